@@ -2,19 +2,14 @@
 
 #include "hal_interfaces.h"
 #include "ui_manager.h"
+#include "config.h"
 
-// Forward declarations
-namespace reaper
-{
-    struct ReaperState;
-    struct TransportState;
-}
-
-// Forward declaration to avoid circular dependency
+// Forward declarations to avoid circular dependency
 namespace http
 {
     class HttpJobManager;
 }
+class StateManager;
 
 class ButtonHandler
 {
@@ -27,13 +22,39 @@ private:
     bool awaiting_state_update = false;
     bool awaiting_transport_update = false;
 
-    // State references
-    reaper::ReaperState *current_reaper_state;
-    reaper::TransportState *current_transport_state;
+    // State the actions are applied to (optimistically, with OPTIMISTIC_UPDATES)
+    StateManager *state_manager;
+    unsigned long press_time = 0; // Time of the press being handled
+
+#if PERF_METRICS
+    // Hidden combo: holding A and C together toggles the metrics overlay. Presses made while
+    // both are down are not acted on, and A and C step on release while stopped, so starting the
+    // combo there sends nothing either.
+    static const unsigned long PERF_OVERLAY_HOLD_MS = 2000;
+    unsigned long combo_start = 0;
+    bool combo_held = false;
+    bool combo_fired = false;
+    bool handlePerfOverlayCombo(unsigned long current_time);
+#endif
+
+    // Holding C while stopped opens the setlist picker on the active tab. While stopped, C (and A,
+    // with the overlay combo) steps on release instead of on press, so a hold or the combo never
+    // sends anything to REAPER. The step keeps the press time, so the latency metrics include the hold.
+    static const unsigned long TAB_PICKER_HOLD_MS = 800;
+    unsigned long picker_hold_start = 0;
+    bool picker_held = false;
+    bool picker_hold_fired = false;
+    bool next_tab_pending = false;     // C went down while stopped, steps when released before the hold
+    unsigned long next_tab_press_time = 0;
+    bool previous_tab_pending = false; // A went down while stopped, steps when released outside the combo
+    unsigned long previous_tab_press_time = 0;
+    bool handleTabPickerHold(unsigned long current_time);
+    bool handleTabStepRelease();
 
     void handleStoppedState();
     void handlePlayingState();
     void handleAreYouSureState();
+    void handleTabPickerState();
 
     void handlePreviousTab();
     void handlePlay();
@@ -41,16 +62,22 @@ private:
     void handleStopConfirmation();
     void handleStop();
     void handleCancel();
+    void handleJumpToTab();
+
+    // Digest of the tabs we already hold, so unchanged setlists are not re-parsed
+    uint32_t knownTabsDigest() const;
 
 public:
     ButtonHandler(hal::IInputManager *input, http::HttpJobManager *http_manager, UIManager *ui);
     ~ButtonHandler() = default;
 
-    // Set state references for callbacks
-    void setStateReferences(reaper::ReaperState *reaper_state, reaper::TransportState *transport_state);
+    void setStateManager(StateManager *state) { state_manager = state; }
 
     // Main button handling
-    bool handleButtonPress();
+    bool handleButtonPress(unsigned long current_time);
+
+    // Milliseconds until handleButtonPress() next needs calling without a button edge (a held combo)
+    uint32_t msUntilNextUpdate(unsigned long current_time) const;
 
     // State control for HTTP job processing
     void setAwaitingStateUpdate(bool awaiting) { awaiting_state_update = awaiting; }
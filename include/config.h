@@ -19,6 +19,97 @@
 #define WIFI_RETRY_ATTEMPTS 3
 #endif
 
+#ifndef WIFI_FAST_RECONNECT
+#define WIFI_FAST_RECONNECT 1 // M5Stack: after deep sleep rejoin the last access point and reuse its lease, skipping scan and DHCP
+#endif
+
+// Static address instead of DHCP, e.g. "192.168.1.60". Empty uses DHCP (or the cached lease).
+#ifndef WIFI_STATIC_IP
+#define WIFI_STATIC_IP ""
+#endif
+
+#ifndef WIFI_GATEWAY
+#define WIFI_GATEWAY "" // Required with WIFI_STATIC_IP
+#endif
+
+#ifndef WIFI_SUBNET
+#define WIFI_SUBNET "255.255.255.0"
+#endif
+
+#ifndef WIFI_DNS
+#define WIFI_DNS "" // Empty uses the gateway
+#endif
+
+// HTTP Configuration
+#ifndef HTTP_KEEP_ALIVE
+#define HTTP_KEEP_ALIVE 1 // Reuse one persistent connection to the Reaper server
+#endif
+
+#ifndef HTTP_USER_WORKER
+#define HTTP_USER_WORKER 0 // Second worker and connection for button actions, never queued behind polls
+#endif
+
+#ifndef SETLIST_COMPACT_FORMAT
+#define SETLIST_COMPACT_FORMAT 1 // Ask ReaperSetlist for the compact setlist payload, JSON is still accepted
+#endif
+
+#ifndef SETLIST_LIVE_STATE
+#define SETLIST_LIVE_STATE 1 // Poll read-only while ReaperSetlist keeps its ExtState current, running the script only when it does not
+#endif
+
+// Display Configuration
+#ifndef DISPLAY_BUFFER_LINES
+#define DISPLAY_BUFFER_LINES 15 // Height in lines of each LVGL draw buffer strip
+#endif
+
+#ifndef DISPLAY_DMA_FLUSH
+#define DISPLAY_DMA_FLUSH 1 // M5Stack: two DMA buffers, SPI transfer overlaps rendering of the next strip
+#endif
+
+// Input Configuration
+#ifndef OPTIMISTIC_UPDATES
+#define OPTIMISTIC_UPDATES 1 // Show button actions at once, roll back if REAPER disagrees
+#endif
+
+// Performance Metrics
+#ifndef PERF_METRICS
+#define PERF_METRICS 1 // Scoped timers and histograms on the hot paths, hold A+C for the overlay. 0 compiles them out
+#endif
+
+#ifndef PERF_DUMP_INTERVAL_MS
+#define PERF_DUMP_INTERVAL_MS 60000 // Serial dump of the metrics (PERF_METRICS), 0 disables it
+#endif
+
+// Memory Budget
+#ifndef MEMORY_RESERVE_HEAP_BLOCK
+#define MEMORY_RESERVE_HEAP_BLOCK 16384 // Degraded mode (no prefetch, no picker) below this largest free internal heap block in bytes
+#endif
+
+#ifndef MEMORY_RESERVE_LVGL_BLOCK
+#define MEMORY_RESERVE_LVGL_BLOCK 3072 // Degraded mode below this largest free block of the LVGL pool (LV_MEM_SIZE)
+#endif
+
+#ifndef STACK_RESERVE_BYTES
+#define STACK_RESERVE_BYTES 512 // Warn when a task has come this close to the end of its stack
+#endif
+
+#ifndef PSRAM_MALLOC_THRESHOLD
+#define PSRAM_MALLOC_THRESHOLD 1024 // M5Stack with PSRAM: allocations of at least this many bytes go there first, 0 keeps all internal
+#endif
+
+// Logging Configuration
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 2 // Lowest level compiled in: 0 trace, 1 debug, 2 info, 3 warning, 4 error, 5 critical
+#endif
+
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED 1 // Queue raw arguments and format on a low-priority task instead of at the call site
+#endif
+
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 32 // Deferred log records held before new ones are dropped, power of two
+#endif
+
 // Reaper Server Configuration
 #ifndef REAPER_SERVER
 #define REAPER_SERVER "192.168.1.100"
@@ -28,6 +119,23 @@
 #define REAPER_PORT 8080
 #endif
 
+#ifndef REAPER_PUSH_PORT
+#define REAPER_PUSH_PORT 0 // UDP port for ReaperSetlist push updates, 0 polls only
+#endif
+
+// Second REAPER rig following the first, e.g. "192.168.1.101". Empty runs a single host. Needs HTTP_USER_WORKER 0.
+#ifndef REAPER_BACKUP_SERVER
+#define REAPER_BACKUP_SERVER ""
+#endif
+
+#ifndef REAPER_BACKUP_PORT
+#define REAPER_BACKUP_PORT REAPER_PORT
+#endif
+
+#ifndef HOST_FAILOVER_FAILURES
+#define HOST_FAILOVER_FAILURES 2 // Failed requests in a row before reading from the backup instead
+#endif
+
 // You can also create a config.cpp file to define these at runtime:
 /*
 // config.cpp example:
@@ -1,12 +1,84 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
+#include <atomic>
 #include <functional>
 #include <string>
 
 namespace hal
 {
 
+    // Deadline helpers for the event-driven main loop
+    static constexpr uint32_t NO_DEADLINE = UINT32_MAX;
+
+    // Milliseconds left of an interval that started elapsed_ms ago, 0 when already due
+    inline uint32_t msRemaining(uint32_t elapsed_ms, uint32_t interval_ms)
+    {
+        return elapsed_ms >= interval_ms ? 0 : interval_ms - elapsed_ms;
+    }
+
+    // Snapshot of HTTP client counters (for measuring connection reuse)
+    struct HttpStats
+    {
+        uint32_t requests = 0;           // Requests issued
+        uint32_t failures = 0;           // Requests that did not produce a response
+        uint32_t connections_opened = 0; // Requests that had to open a new TCP connection
+        uint32_t reconnects = 0;         // Stale keep-alive connections that were re-established
+        uint32_t last_connect_ms = 0;    // Connect time of the last request (0 when reused)
+        uint32_t last_ttfb_ms = 0;       // Time to first byte of the last request
+        uint32_t total_connect_ms = 0;
+        uint32_t total_ttfb_ms = 0;
+    };
+
+    // Thread-safe HTTP counters - written by the HTTP worker, read from the main loop
+    class HttpStatsCounters
+    {
+    private:
+        std::atomic<uint32_t> requests{0};
+        std::atomic<uint32_t> failures{0};
+        std::atomic<uint32_t> connections_opened{0};
+        std::atomic<uint32_t> reconnects{0};
+        std::atomic<uint32_t> last_connect_ms{0};
+        std::atomic<uint32_t> last_ttfb_ms{0};
+        std::atomic<uint32_t> total_connect_ms{0};
+        std::atomic<uint32_t> total_ttfb_ms{0};
+
+    public:
+        void recordRequest(bool success, bool new_connection, uint32_t connect_ms, uint32_t ttfb_ms)
+        {
+            requests.fetch_add(1, std::memory_order_relaxed);
+            if (!success)
+            {
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (new_connection)
+            {
+                connections_opened.fetch_add(1, std::memory_order_relaxed);
+            }
+            last_connect_ms.store(connect_ms, std::memory_order_relaxed);
+            last_ttfb_ms.store(ttfb_ms, std::memory_order_relaxed);
+            total_connect_ms.fetch_add(connect_ms, std::memory_order_relaxed);
+            total_ttfb_ms.fetch_add(ttfb_ms, std::memory_order_relaxed);
+        }
+
+        void recordReconnect() { reconnects.fetch_add(1, std::memory_order_relaxed); }
+
+        HttpStats snapshot() const
+        {
+            HttpStats stats;
+            stats.requests = requests.load(std::memory_order_relaxed);
+            stats.failures = failures.load(std::memory_order_relaxed);
+            stats.connections_opened = connections_opened.load(std::memory_order_relaxed);
+            stats.reconnects = reconnects.load(std::memory_order_relaxed);
+            stats.last_connect_ms = last_connect_ms.load(std::memory_order_relaxed);
+            stats.last_ttfb_ms = last_ttfb_ms.load(std::memory_order_relaxed);
+            stats.total_connect_ms = total_connect_ms.load(std::memory_order_relaxed);
+            stats.total_ttfb_ms = total_ttfb_ms.load(std::memory_order_relaxed);
+            return stats;
+        }
+    };
+
     // Network interface abstraction
     class INetworkManager
     {
@@ -19,8 +91,32 @@ namespace hal
         virtual bool isConnected() const = 0;
         virtual const char *getIP() const = 0;
 
-        // HTTP client functionality (blocking only)
-        virtual bool httpGetBlocking(const char *url, std::string &response, int &status_code) = 0;
+        // HTTP client functionality (blocking only). A request that fails on a stale keep-alive
+        // connection is retried once on a new one if it never went out. Once sent it is only
+        // retried when repeatable - REAPER may have run it and only the response been lost, so
+        // anything with side effects (tab steps, play/stop) must pass false.
+        virtual bool httpGetBlocking(const char *url, std::string &response, int &status_code, bool repeatable) = 0;
+
+        // Pipelining across connections: httpSend() writes a request without waiting for the
+        // answer, httpReceive() then reads it. A command fanned out to several hosts is sent to
+        // all of them before any response is awaited. One request in flight per manager.
+        virtual bool httpSend(const char *url, int &status_code) = 0;
+        virtual bool httpReceive(std::string &response, int &status_code) = 0;
+
+        // Connection reuse - keep one persistent keep-alive connection to the server and
+        // transparently reconnect when it goes stale
+        virtual void setKeepAlive(bool enable) = 0;
+        virtual bool isKeepAliveEnabled() const = 0;
+
+        // Per-request connect time / time-to-first-byte counters
+        virtual HttpStats getHttpStats() const = 0;
+
+        // Push channel - one bound UDP socket for updates sent from REAPER. udpReceive() blocks
+        // for up to timeout_ms and returns the datagram length, 0 on timeout or -1 on error.
+        // Call from a single task.
+        virtual bool udpOpen(uint16_t port) = 0;
+        virtual int udpReceive(char *buffer, size_t size, uint32_t timeout_ms) = 0;
+        virtual void udpClose() = 0;
     };
 
     // Power management interface abstraction
@@ -63,6 +159,9 @@ namespace hal
 
         // LVGL integration
         virtual void flush(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint16_t *color_p) = 0;
+
+        // Total pixels pushed to the panel since startup
+        virtual uint64_t getPixelsFlushed() const = 0;
     };
 
     // Input interface abstraction
@@ -84,6 +183,20 @@ namespace hal
         virtual void update() = 0;
     };
 
+    // Heap usage snapshot - min_free_bytes is the low-water mark since boot, the gap between
+    // free_bytes and largest_free_block shows fragmentation. All zero where not tracked.
+    struct HeapStats
+    {
+        uint32_t free_bytes = 0;
+        uint32_t min_free_bytes = 0;
+        uint32_t largest_free_block = 0;
+        uint32_t psram_free_bytes = 0; // 0 without PSRAM
+        uint32_t psram_largest_free_block = 0;
+    };
+
+    // Size of the buffer kept across deep sleep for the state snapshot (see getRetainedBuffer)
+    static const size_t RETAINED_BUFFER_SIZE = 3072;
+
     // System abstraction - combines all interfaces
     class ISystemHAL
     {
@@ -91,6 +204,10 @@ namespace hal
         virtual ~ISystemHAL() = default;
 
         virtual INetworkManager &getNetworkManager() = 0;
+        // Connection used by the button action worker (HTTP_USER_WORKER), else the same as above
+        virtual INetworkManager &getUserNetworkManager() = 0;
+        // Connection to the backup REAPER host (REAPER_BACKUP_SERVER), used by the same worker
+        virtual INetworkManager &getBackupNetworkManager() = 0;
         virtual IPowerManager &getPowerManager() = 0;
         virtual IDisplayManager &getDisplayManager() = 0;
         virtual IInputManager &getInputManager() = 0;
@@ -99,7 +216,31 @@ namespace hal
         virtual void init() = 0;
         virtual void update() = 0;
         virtual uint32_t getMillis() const = 0;
+        virtual uint32_t getMicros() const = 0; // Wraps after ~71 minutes, use for short intervals only
         virtual void delay(uint32_t ms) = 0;
+        virtual HeapStats getHeapStats() const = 0;
+
+        // Least stack the named task has ever had left, in bytes - 0 when no such task is running
+        // or the platform does not track it
+        virtual uint32_t getStackHighWaterMark(const char *task_name) const = 0;
+
+        // Deep sleep resets the device - true when this boot is a wake from it rather than a
+        // power on or reset
+        virtual bool wokeFromSleep() const = 0;
+
+        // Script action ID kept across deep sleep, so a wake does not have to look it up again.
+        // Empty when nothing is cached.
+        virtual const char *getCachedScriptActionId() const = 0;
+        virtual void cacheScriptActionId(const char *id) = 0;
+
+        // RETAINED_BUFFER_SIZE bytes kept across deep sleep, for the state snapshot written just
+        // before sleeping. The owner validates the contents. Null (capacity 0) where unsupported.
+        virtual uint8_t *getRetainedBuffer(size_t &capacity) = 0;
+
+        // Event-driven main loop - block until signalEvent(), a button/input edge or the
+        // timeout, whichever comes first. signalEvent() may be called from any task.
+        virtual void waitForEvent(uint32_t timeout_ms) = 0;
+        virtual void signalEvent() = 0;
     };
 
 } // namespace hal
@@ -2,81 +2,229 @@
 
 #include "hal_interfaces.h"
 #include "http_jobs.h"
+#include "spsc_ring.h"
+#include "push_listener.h"
+#include "config.h"
 #include <string>
-#include <vector>
 #include <memory>
 #include <atomic>
+#include <cstdint>
 
 #ifdef ARDUINO
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/queue.h>
-#include <freertos/semphr.h>
 #else
 #include <thread>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
-#include <atomic>
 #endif
 
 namespace http
 {
+        // Requests saved by coalescing queued jobs
+        struct JobCoalesceStats
+        {
+                uint32_t read_jobs_merged = 0;       // Transport/status polls answered by a job already queued
+                uint32_t transport_jobs_dropped = 0; // Queued transport polls superseded by a playstate change
+                uint32_t tab_presses_folded = 0;     // Tab presses merged into a queued tab change
+
+                uint32_t requestsSaved() const { return read_jobs_merged + transport_jobs_dropped + tab_presses_folded; }
+        };
+
+        // Time jobs of one priority class spent queued before a worker took them
+        struct QueueWaitStats
+        {
+                uint32_t jobs = 0;
+                uint32_t total_wait_ms = 0;
+                uint32_t max_wait_ms = 0;
+
+                uint32_t averageWaitMs() const { return jobs ? total_wait_ms / jobs : 0; }
+        };
+
+        // Thread-safe queue wait counters - written by the workers, read from the main loop
+        class QueueWaitCounters
+        {
+        private:
+                std::atomic<uint32_t> jobs{0};
+                std::atomic<uint32_t> total_wait_ms{0};
+                std::atomic<uint32_t> max_wait_ms{0};
+
+        public:
+                void record(uint32_t wait_ms)
+                {
+                        jobs.fetch_add(1, std::memory_order_relaxed);
+                        total_wait_ms.fetch_add(wait_ms, std::memory_order_relaxed);
+                        uint32_t max = max_wait_ms.load(std::memory_order_relaxed);
+                        while (wait_ms > max && !max_wait_ms.compare_exchange_weak(max, wait_ms, std::memory_order_relaxed))
+                        {
+                        }
+                }
+
+                QueueWaitStats snapshot() const
+                {
+                        QueueWaitStats stats;
+                        stats.jobs = jobs.load(std::memory_order_relaxed);
+                        stats.total_wait_ms = total_wait_ms.load(std::memory_order_relaxed);
+                        stats.max_wait_ms = max_wait_ms.load(std::memory_order_relaxed);
+                        return stats;
+                }
+        };
+
         class HttpJobManager
         {
         private:
                 hal::ISystemHAL *system_hal;
                 NetworkManager *network_manager;
-                std::string base_url;
-                std::string script_action_id; // ReaperSetlist script action ID
+
+                // REAPER hosts: the primary and, with a backup URL, a second rig following it. Jobs
+                // read from the active host, its transport and tab commands are mirrored to the
+                // others. Every REAPER install has its own script action ID, so each host has its
+                // own URL set.
+                struct Host
+                {
+                        std::string base_url;
+                        std::string base;             // "<base_url>/" - never changes, read by the worker
+                        std::string script_action_id; // ReaperSetlist script action ID
+                        // URLs for both of the above, rebuilt when the script action ID changes and handed to
+                        // every submitted job. Main thread only - workers use the copy held by their job.
+                        std::shared_ptr<const RequestUrls> request_urls;
+                        hal::INetworkManager *network = nullptr; // Connection of the shared worker
+                        HostHealth health;
+                        // Worker only: answers to mirrored commands, when it was last mirrored to
+                        std::string mirror_response;
+                        uint32_t last_mirrored = 0;
+                };
+                Host hosts[MAX_HOSTS];
+                size_t host_count = 1;
+                size_t active_host = 0; // Main thread only
+                // A mirror that stopped answering only gets a probe this often, so a host that is down
+                // does not hold every command up for its connect timeout
+                static const uint32_t HOST_PROBE_INTERVAL_MS = 30000;
 
                 // Connection state tracking
                 std::atomic<bool> wifi_connected;
                 std::atomic<uint32_t> last_wifi_attempt;
                 std::atomic<uint32_t> last_action_id_attempt;
+                // ReaperSetlist keeps its ExtState current by itself (SETLIST_LIVE_STATE), so status
+                // polls can skip the script. Learned from every status response, read by the workers.
+                std::atomic<bool> setlist_live;
                 static const uint32_t WIFI_RETRY_INTERVAL_MS = 10000;     // 10 seconds
                 static const uint32_t SCRIPT_ID_RETRY_INTERVAL_MS = 5000; // 5 seconds
                 static const uint32_t MAX_SCRIPT_ID_ATTEMPTS = 5;
 
+                // Push mode (REAPER_PUSH_PORT) - the subscription is renewed periodically so a
+                // restarted REAPER picks the device up again
+                std::unique_ptr<PushListener> push_listener;
+                uint32_t last_subscribe_attempt = 0; // Main thread only
+                bool subscribe_requested = false;
+                static const uint32_t PUSH_SUBSCRIBE_INTERVAL_MS = 60000;
+
+                bool memory_degraded = false; // Low memory, nothing is fetched ahead of time. Main thread only.
+
                 std::atomic<uint32_t> next_job_id;
                 bool worker_running;
 
-                // Results queue owned by main thread
+                // Lock-free queues shared by both platforms: the main loop is the only producer of
+                // jobs and the only consumer of results. Each priority class has its own job ring,
+                // taken by exactly one worker, and each worker returns results on its own ring.
+                // Jobs and results are held by value, so the rings are their only storage.
+                static const size_t JOB_QUEUE_SIZE = 8; // Per priority class
+                static const size_t RESULT_QUEUE_SIZE = 16;
+                SpscRing<HttpJob, JOB_QUEUE_SIZE> job_queues[JOB_PRIORITY_COUNT];
+                QueueWaitCounters queue_wait[JOB_PRIORITY_COUNT];
+
+                // A worker serves the job rings from first_priority to last_priority, taking the
+                // highest priority job queued each time it finishes one. With HTTP_USER_WORKER button
+                // actions get a worker and HTTP connection of their own, so they never wait behind a
+                // poll that is already running.
+                struct Worker
+                {
+                        HttpJobManager *manager = nullptr;
+                        hal::INetworkManager *network = nullptr;
+                        const char *name = "";
+                        JobPriority first_priority = JobPriority::USER;
+                        JobPriority last_priority = JobPriority::BACKGROUND;
+                        SpscRing<HttpJobResult, RESULT_QUEUE_SIZE> result_queue;
+                        std::string response; // Reused for every request, keeps its capacity
 #ifdef ARDUINO
-                QueueHandle_t main_result_queue; // Main thread receives from this
+                        // Woken with a direct task notification when a job is queued
+                        TaskHandle_t task_handle = nullptr;
 #else
-                std::queue<std::unique_ptr<HttpJobResult>> results;
-                std::mutex results_mutex; // Minimal sync for cross-thread communication
+                        // Only sleeps on the condition variable once its rings are empty, so the main
+                        // loop touches idle_mutex only when it has to wake an idle worker
+                        std::thread thread;
+                        std::condition_variable job_available;
+                        std::mutex idle_mutex;
+                        std::atomic<bool> idle{false};
 #endif
+                };
+                static const size_t WORKER_COUNT = HTTP_USER_WORKER ? 2 : 1;
+                Worker workers[WORKER_COUNT];
 
-#ifdef ARDUINO
-                // FreeRTOS primitives
-                QueueHandle_t job_queue;
-                TaskHandle_t worker_task_handle;
+                // Coalescing of queued jobs. A queued poll is live only while its ID is in the pending
+                // slot: the main thread merges into it or clears the slot to cancel it, the worker
+                // claims it by swapping the slot back to 0 before running it.
+                std::atomic<uint32_t> pending_transport_job;
+                std::atomic<uint32_t> pending_status_job;
+                // Net steps of the queued tab change, folded into by the main thread until claimed
+                static const int32_t NO_PENDING_TAB_CHANGE = INT32_MIN;
+                std::atomic<int32_t> pending_tab_steps;
+                uint32_t pending_tab_job; // Main thread only
+                JobCoalesceStats coalesce_stats; // Main thread only
+                uint32_t jobs_rejected = 0;               // Submits refused by a full job ring, main thread only
+                std::atomic<uint32_t> results_dropped{0}; // Results lost to a full result ring
 
+#ifdef ARDUINO
                 static void workerTaskWrapper(void *parameter);
-                void workerTask();
 #else
-                // Standard library primitives
-                std::queue<std::unique_ptr<HttpJob>> job_queue;
-                std::thread worker_thread;
-                std::condition_variable job_available;
-                std::mutex job_queue_mutex;
                 std::atomic<bool> should_stop;
 
-                void workerThreadFunction();
+                void waitForJob(Worker &worker);
 #endif
 
+                void startWorker(Worker &worker);
+                void workerLoop(Worker &worker);
+
                 uint32_t generateJobId();
 
+                // Worker serving the given priority class
+                Worker &workerFor(JobPriority priority);
+
+                // Failover: the first host, in configured order, that answers and has its script action
+                // ID. Stays put when none qualifies. Main thread only.
+                size_t selectActiveHost();
+                bool isHostUsable(size_t host) const;
+                bool hasStandbyWithoutScriptId() const;
+
+                // Mirrors for a job reading from host, skipping those down since their last probe
+                size_t collectMirrors(size_t host, MirrorHost *mirrors);
+
+                // Queue a job for its worker and wake it - returns the job ID or 0 if the queue is full.
+                // Coalesced jobs take the ID they were announced under before the push.
+                uint32_t submitJob(JobPayload &&payload) { return submitJob(generateJobId(), std::move(payload)); }
+                uint32_t submitJob(uint32_t job_id, JobPayload &&payload) { return submitJob(job_id, std::move(payload), selectActiveHost()); }
+                uint32_t submitJob(uint32_t job_id, JobPayload &&payload, size_t host);
+
+                // Worker side: pop the highest priority job among the worker's rings
+                bool popJob(Worker &worker, HttpJob &job);
+                bool hasJob(Worker &worker) const;
+
+                // Worker side of coalescing - false if the job was superseded while queued
+                bool claimJob(HttpJob &job);
+
+                // Run one job on a worker and hand its result to the main thread
+                void executeJob(Worker &worker, HttpJob &job);
+
                 // Worker thread sends results to main thread
-                void sendResult(std::unique_ptr<HttpJobResult> result);
+                void sendResult(Worker &worker, HttpJobResult &&result);
 
                 // Internal shutdown logic (called from destructor)
                 void shutdown();
 
         public:
-                HttpJobManager(hal::ISystemHAL *system, NetworkManager *network, const std::string &reaper_base_url);
+                // backup_base_url adds a second REAPER host (empty for a single one)
+                HttpJobManager(hal::ISystemHAL *system, NetworkManager *network, const std::string &reaper_base_url,
+                               const std::string &backup_base_url = std::string());
                 ~HttpJobManager();
 
                 // Non-copyable, non-movable (RAII resource management)
@@ -85,31 +233,87 @@ namespace http
                 HttpJobManager(HttpJobManager &&) = delete;
                 HttpJobManager &operator=(HttpJobManager &&) = delete;
 
-                // Job submission - returns job ID, no callbacks needed
+                // Job submission - returns job ID, no callbacks needed. Polls and tab changes may be
+                // coalesced with a job still waiting in the queue, in which case that job's ID is returned.
+                // A tab press that would take the queued job past ChangeTabJob::MAX_STEPS is dropped (0).
                 uint32_t submitWiFiConnectJob();
-                uint32_t submitChangeTabJob(TabDirection direction);
+                // known_tabs_digest is the digest of the tabs currently held by the caller (0 forces a full parse)
+                uint32_t submitChangeTabJob(TabDirection direction, uint32_t known_tabs_digest = 0);
+                // Jump straight to a tab in one request, however far away (setlist picker).
+                // current_index is where the device believes REAPER is.
+                uint32_t submitJumpToTabJob(unsigned int target_index, unsigned int current_index, unsigned int tab_count,
+                                            uint32_t known_tabs_digest = 0);
                 uint32_t submitChangePlaystateJob(PlayAction action);
-                uint32_t submitGetStatusJob();
+                uint32_t submitGetStatusJob(uint32_t known_tabs_digest = 0);
                 uint32_t submitGetScriptActionIdJob();
                 uint32_t submitGetTransportJob();
+                uint32_t submitSubscribeJob();
 
-                // Result processing (call from main thread) - returns ownership of results
-                std::vector<std::unique_ptr<HttpJobResult>> processResults();
+                // Result processing (call from main thread) - pops one completed result or pushed
+                // update, returns false when none are pending. Never blocks or allocates.
+                bool nextResult(HttpJobResult &result);
 
                 // Connection management
                 bool isWiFiConnected() const { return wifi_connected.load(); }
                 void checkAndRetryConnections(uint32_t current_time);
+                uint32_t msUntilNextUpdate(uint32_t current_time) const; // Until the next connection retry is due
+
+                // Low memory (MemoryBudget): skip prefetches such as the standby's script action ID
+                void setMemoryDegraded(bool degraded) { memory_degraded = degraded; }
 
-                // Script action ID management
-                void setScriptActionId(const std::string &id)
+                // Script action ID management, per host - the getter is the active host's
+                void setScriptActionId(const std::string &id, size_t host = 0)
                 {
-                        script_action_id = id;
+                        Host &target = hosts[host];
+                        if (id != target.script_action_id)
+                        {
+                                target.script_action_id = id;
+                                target.request_urls = std::make_shared<const RequestUrls>(target.base_url, id);
+                                if (host == 0)
+                                {
+                                        system_hal->cacheScriptActionId(id.c_str()); // Skips the lookup after deep sleep
+                                }
+                        }
                         last_action_id_attempt.store(0); // Reset attempts when successful
                 }
-                const std::string &getScriptActionId() const { return script_action_id; }
+                const std::string &getScriptActionId() const { return hosts[active_host].script_action_id; }
+
+                // Hosts - status is read from the active one, health covers every request to each
+                size_t getHostCount() const { return host_count; }
+                size_t getActiveHost() const { return active_host; }
+                const std::string &getHostUrl(size_t host) const { return hosts[host].base_url; }
+                const HostHealth &getHostHealth(size_t host) const { return hosts[host].health; }
 
                 // Status
                 bool isWorkerRunning() const { return worker_running; }
+
+                // True while REAPER is pushing state changes, so polls can back off
+                bool isPushActive(uint32_t current_time) const { return push_listener && push_listener->isActive(current_time); }
+                uint32_t getPushMessagesReceived() const { return push_listener ? push_listener->getMessagesReceived() : 0; }
+
+                // HTTP connection reuse / timing counters from the HAL network manager(s)
+                hal::HttpStats getHttpStats() const;
+
+                // How long jobs of each priority class waited before a worker took them
+                QueueWaitStats getQueueWaitStats(JobPriority priority) const { return queue_wait[(size_t)priority].snapshot(); }
+
+                // Requests saved by coalescing (call from main thread)
+                const JobCoalesceStats &getCoalesceStats() const { return coalesce_stats; }
+
+                // Jobs refused because their queue was full, results dropped for the same reason
+                uint32_t getJobsRejected() const { return jobs_rejected; }
+                uint32_t getResultsDropped() const { return results_dropped.load(std::memory_order_relaxed); }
+
+                // Jobs waiting in all priority queues
+                size_t getQueuedJobs() const
+                {
+                        size_t queued = 0;
+                        for (const auto &queue : job_queues)
+                        {
+                                queued += queue.size();
+                        }
+                        return queued;
+                }
         };
 
 } // namespace http
@@ -3,202 +3,373 @@
 #include "hal_interfaces.h"
 #include "reaper_types.h"
 #include "network_manager.h"
-#include <string>
+#include <atomic>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <variant>
 #include <cstdint>
 
 namespace http
 {
-    // Forward declarations
-    class HttpJobResult;
-
-    // Result type enumeration for type identification without RTTI
-    enum class ResultType
+    // Job type enumeration, lets the job manager coalesce queued jobs. Follows the order
+    // of JobPayload, so it is just the index of the active alternative.
+    enum class JobType
     {
         WIFI_CONNECT,
         CHANGE_TAB,
         CHANGE_PLAYSTATE,
         GET_STATUS,
         GET_SCRIPT_ACTION_ID,
-        GET_TRANSPORT
+        GET_TRANSPORT,
+        SUBSCRIBE
     };
 
-    // Base class for HTTP job results
-    class HttpJobResult
+    // Priority classes - workers always take the highest priority job queued, so a button action
+    // waits at most for the job already running
+    enum class JobPriority
     {
-    public:
-        uint32_t job_id;
-        bool success;
-        uint32_t timestamp;
-        ResultType result_type;
-
-        HttpJobResult(uint32_t id, ResultType type) : job_id(id), success(false), timestamp(0), result_type(type) {}
-        virtual ~HttpJobResult() = default;
+        USER,      // Button actions
+        TRANSPORT, // Transport polls
+        BACKGROUND // Status and script ID refreshes, WiFi, push subscription
     };
+    static const size_t JOB_PRIORITY_COUNT = 3;
 
-    // Base class for HTTP jobs
-    class HttpJob
+    inline JobPriority jobPriority(JobType type)
     {
-    public:
-        uint32_t job_id;
-        uint32_t timestamp;
+        switch (type)
+        {
+        case JobType::CHANGE_TAB:
+        case JobType::CHANGE_PLAYSTATE:
+            return JobPriority::USER;
+        case JobType::GET_TRANSPORT:
+            return JobPriority::TRANSPORT;
+        default:
+            return JobPriority::BACKGROUND;
+        }
+    }
 
-        HttpJob(uint32_t id) : job_id(id), timestamp(0) {}
-        virtual ~HttpJob() = default;
+    inline const char *jobPriorityName(JobPriority priority)
+    {
+        switch (priority)
+        {
+        case JobPriority::USER:
+            return "user";
+        case JobPriority::TRANSPORT:
+            return "transport";
+        default:
+            return "background";
+        }
+    }
 
-        // Pure virtual method to execute the job and return the result
-        virtual std::unique_ptr<HttpJobResult> execute(hal::INetworkManager *network_mgr, const std::string &base_url) = 0;
-        virtual const char *getJobTypeName() const = 0;
-    };
+    // Script action IDs are "_RS" plus a 40 digit hash - jobs keep a copy without touching the heap
+    static const size_t SCRIPT_ACTION_ID_SIZE = 64;
 
-    // WiFi Connection Job and Result
-    class WiFiConnectResult : public HttpJobResult
+    enum class TabDirection
     {
-    public:
-        bool connected;
-        std::string ip_address;
+        NEXT,
+        PREVIOUS
+    };
 
-        WiFiConnectResult(uint32_t id) : HttpJobResult(id, ResultType::WIFI_CONNECT), connected(false) {}
+    enum class PlayAction
+    {
+        PLAY,
+        STOP
     };
 
-    class WiFiConnectJob : public HttpJob
+    // Results - plain structs carried by value in the result rings
+
+    struct WiFiConnectResult
     {
-    private:
-        NetworkManager *network_manager;
+        bool connected = false;
+        char ip_address[16] = {};
+    };
 
-    public:
-        WiFiConnectJob(uint32_t id, NetworkManager *network);
+    struct ChangeTabResult
+    {
+        reaper::ReaperState reaper_state;
+        reaper::TransportState transport_state;
+        bool tabs_unchanged = false; // Tabs payload matched the known digest - reaper_state.tabs left null
+    };
 
-        std::unique_ptr<HttpJobResult> execute(hal::INetworkManager *network_mgr, const std::string &base_url) override;
-        const char *getJobTypeName() const override { return "WiFiConnect"; }
-    }; // Change Tab Job and Result
-    enum class TabDirection
+    struct ChangePlaystateResult
     {
-        NEXT,
-        PREVIOUS
+        reaper::TransportState transport_state;
     };
 
-    class ChangeTabResult : public HttpJobResult
+    struct GetStatusResult
     {
-    public:
         reaper::ReaperState reaper_state;
         reaper::TransportState transport_state;
+        bool tabs_unchanged = false; // Tabs payload matched the known digest - reaper_state.tabs left null
+    };
 
-        ChangeTabResult(uint32_t id) : HttpJobResult(id, ResultType::CHANGE_TAB)
-        {
-            reaper_state = reaper::ReaperState{};
-            transport_state = reaper::TransportState{};
-        }
+    struct GetScriptActionIdResult
+    {
+        char script_action_id[SCRIPT_ACTION_ID_SIZE] = {};
+        uint8_t host = 0; // Host the ID was looked up on - each REAPER install has its own
     };
 
-    class ChangeTabJob : public HttpJob
+    struct GetTransportResult
     {
-    private:
-        TabDirection direction;
-        std::string script_action_id;
+        reaper::TransportState transport_state;
+    };
 
-    public:
-        ChangeTabJob(uint32_t id, TabDirection dir, const std::string &script_id)
-            : HttpJob(id), direction(dir), script_action_id(script_id) {}
+    struct SubscribeResult
+    {
+    };
 
-        std::unique_ptr<HttpJobResult> execute(hal::INetworkManager *network_mgr, const std::string &base_url) override;
-        const char *getJobTypeName() const override { return "ChangeTab"; }
+    // State pushed by the ReaperSetlist script (see PushListener), not the result of a job.
+    // Only the parts present in the datagram are set.
+    struct PushUpdateResult
+    {
+        reaper::TransportState transport_state; // success is false when no TRANSPORT line was sent
+        bool has_active_index = false;
+        unsigned int active_index = 0;
+        bool tabs_changed = false; // Setlist changed - fetch it with a status job
     };
 
-    // Change Playstate Job and Result
-    enum class PlayAction
+    using ResultPayload = std::variant<WiFiConnectResult, ChangeTabResult, ChangePlaystateResult, GetStatusResult,
+                                       GetScriptActionIdResult, GetTransportResult, SubscribeResult, PushUpdateResult>;
+
+    struct HttpJobResult
     {
-        PLAY,
-        STOP
+        uint32_t job_id = 0; // 0 for pushed updates
+        bool success = false;
+        uint32_t timestamp = 0;
+        ResultPayload payload;
     };
 
-    class ChangePlaystateResult : public HttpJobResult
+    // Jobs - plain structs naming their result type. Each is run by the execute() overload for
+    // it in http_jobs.cpp; adding a job means adding a struct here, an overload there and a
+    // JobType entry.
+
+    struct WiFiConnectJob
     {
-    public:
-        reaper::TransportState transport_state;
+        using Result = WiFiConnectResult;
+        static constexpr const char *NAME = "WiFiConnect";
 
-        ChangePlaystateResult(uint32_t id) : HttpJobResult(id, ResultType::CHANGE_PLAYSTATE)
+        NetworkManager *network_manager = nullptr;
+    };
+
+    struct ChangeTabJob
+    {
+        using Result = ChangeTabResult;
+        static constexpr const char *NAME = "ChangeTab";
+        static constexpr int MAX_STEPS = 8; // Bounds the batch URL length
+
+        int steps = 0; // Net tab change, positive is NEXT - repeated presses are folded into one job
+        uint32_t known_tabs_digest = 0;
+        // Jumps (setlist picker) only: the tab the steps should land on, checked against the
+        // active index REAPER reports and corrected once. Jumps are never folded into.
+        int target_index = -1;
+        unsigned int tab_count = 0;
+
+        // Signed steps from one tab to another the shorter way round (tab actions wrap)
+        static int stepsBetween(unsigned int from, unsigned int to, unsigned int count)
         {
-            transport_state = reaper::TransportState{};
+            if (count == 0)
+            {
+                return 0;
+            }
+            int forward = (int)((to + count - from % count) % count);
+            return forward <= (int)count / 2 ? forward : forward - (int)count;
         }
     };
 
-    class ChangePlaystateJob : public HttpJob
+    struct ChangePlaystateJob
     {
-    private:
-        PlayAction action;
+        using Result = ChangePlaystateResult;
+        static constexpr const char *NAME = "ChangePlaystate";
 
-    public:
-        ChangePlaystateJob(uint32_t id, PlayAction act) : HttpJob(id), action(act) {}
+        PlayAction action = PlayAction::PLAY;
+    };
 
-        std::unique_ptr<HttpJobResult> execute(hal::INetworkManager *network_mgr, const std::string &base_url) override;
-        const char *getJobTypeName() const override { return "ChangePlaystate"; }
+    struct GetStatusJob
+    {
+        using Result = GetStatusResult;
+        static constexpr const char *NAME = "GetStatus";
+
+        uint32_t known_tabs_digest = 0;
     };
 
-    // Get Status Job and Result
-    class GetStatusResult : public HttpJobResult
+    struct GetScriptActionIdJob
     {
-    public:
-        reaper::ReaperState reaper_state;
-        reaper::TransportState transport_state;
+        using Result = GetScriptActionIdResult;
+        static constexpr const char *NAME = "GetScriptActionId";
+    };
 
-        GetStatusResult(uint32_t id) : HttpJobResult(id, ResultType::GET_STATUS)
-        {
-            reaper_state = reaper::ReaperState{};
-            transport_state = reaper::TransportState{};
-        }
+    struct GetTransportJob
+    {
+        using Result = GetTransportResult;
+        static constexpr const char *NAME = "GetTransport";
+    };
+
+    // Registers this device as the ReaperSetlist push target
+    struct SubscribeJob
+    {
+        using Result = SubscribeResult;
+        static constexpr const char *NAME = "Subscribe";
+
+        uint16_t push_port = 0;
     };
 
-    class GetStatusJob : public HttpJob
+    using JobPayload = std::variant<WiFiConnectJob, ChangeTabJob, ChangePlaystateJob, GetStatusJob,
+                                    GetScriptActionIdJob, GetTransportJob, SubscribeJob>;
+
+    template <JobType Type, typename Job>
+    constexpr bool jobTypeIs() { return std::is_same<std::variant_alternative_t<(size_t)Type, JobPayload>, Job>::value; }
+    static_assert(jobTypeIs<JobType::WIFI_CONNECT, WiFiConnectJob>() && jobTypeIs<JobType::CHANGE_TAB, ChangeTabJob>() &&
+                      jobTypeIs<JobType::CHANGE_PLAYSTATE, ChangePlaystateJob>() && jobTypeIs<JobType::GET_STATUS, GetStatusJob>() &&
+                      jobTypeIs<JobType::GET_SCRIPT_ACTION_ID, GetScriptActionIdJob>() &&
+                      jobTypeIs<JobType::GET_TRANSPORT, GetTransportJob>() && jobTypeIs<JobType::SUBSCRIBE, SubscribeJob>(),
+                  "JobType must follow the order of JobPayload");
+
+    // Request URLs of the fixed batches, built once for a base URL and script action ID. A set is
+    // never modified: the job manager builds a new one when the script action ID changes and
+    // each job holds the set it was submitted with, so workers read it without locking.
+    class RequestUrls
     {
     private:
-        std::string script_action_id;
+        std::string base;           // "<base_url>/", prefix of every request
+        std::string status_refresh; // Commands that have the script refresh the setlist, then read it back
+        std::string transport;
+        std::string play;
+        std::string stop;
+        std::string script_action_id_query;
+        std::string status;
+        std::string status_read; // Read-only STATUS_QUERY, for while the script keeps the setlist current
+        std::string next_tab; // Single presses - folded presses are built from status_refresh
+        std::string previous_tab;
 
     public:
-        GetStatusJob(uint32_t id, const std::string &script_id)
-            : HttpJob(id), script_action_id(script_id) {}
+        RequestUrls(const std::string &base_url, const std::string &script_action_id);
+
+        const std::string &getBase() const { return base; }
+        const std::string &getStatusRefresh() const { return status_refresh; }
+        const std::string &getTransport() const { return transport; }
+        const std::string &getPlay() const { return play; }
+        const std::string &getStop() const { return stop; }
+        const std::string &getScriptActionIdQuery() const { return script_action_id_query; }
+        const std::string &getStatus() const { return status; }
+        const std::string &getStatusRead() const { return status_read; }
+        const std::string &getNextTab() const { return next_tab; }
+        const std::string &getPreviousTab() const { return previous_tab; }
+    };
 
-        std::unique_ptr<HttpJobResult> execute(hal::INetworkManager *network_mgr, const std::string &base_url) override;
-        const char *getJobTypeName() const override { return "GetStatus"; }
+    struct HttpJob
+    {
+        uint32_t job_id = 0;
+        uint32_t timestamp = 0;
+        JobPayload payload;
+        std::shared_ptr<const RequestUrls> urls; // Set by the job manager on submit
+        uint8_t host = 0;                        // Host the job reads from, urls are that host's
+
+        JobType type() const { return static_cast<JobType>(payload.index()); }
+        const char *name() const
+        {
+            return std::visit([](const auto &job)
+                              { return std::decay_t<decltype(job)>::NAME; },
+                              payload);
+        }
     };
 
-    // Get Script Action ID Job and Result
-    class GetScriptActionIdResult : public HttpJobResult
+    // The primary REAPER host and, with REAPER_BACKUP_SERVER, a backup
+    static const size_t MAX_HOSTS = 2;
+
+    // Request health of one REAPER host, written by the worker and read by the main thread
+    struct HostHealth
     {
-    public:
-        std::string script_action_id;
+        std::atomic<uint32_t> requests{0};
+        std::atomic<uint32_t> failures{0};
+        std::atomic<uint32_t> consecutive_failures{0};
+        std::atomic<uint32_t> last_latency_ms{0};
 
-        GetScriptActionIdResult(uint32_t id) : HttpJobResult(id, ResultType::GET_SCRIPT_ACTION_ID) {}
+        void record(bool success, uint32_t latency_ms)
+        {
+            requests.fetch_add(1, std::memory_order_relaxed);
+            if (success)
+            {
+                consecutive_failures.store(0, std::memory_order_relaxed);
+                last_latency_ms.store(latency_ms, std::memory_order_relaxed);
+            }
+            else
+            {
+                failures.fetch_add(1, std::memory_order_relaxed);
+                consecutive_failures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
     };
 
-    class GetScriptActionIdJob : public HttpJob
+    // Another REAPER host following the one a job reads from (REAPER_BACKUP_SERVER). It gets the
+    // job's transport and tab commands, pipelined with the main request, and its answers are only
+    // used for its health.
+    struct MirrorHost
     {
-    public:
-        GetScriptActionIdJob(uint32_t id) : HttpJob(id) {}
+        hal::INetworkManager *network;
+        const std::string *base; // "<base_url>/", never changes
+        HostHealth *health;
+        std::string *response; // Reused for its answers
+    };
 
-        std::unique_ptr<HttpJobResult> execute(hal::INetworkManager *network_mgr, const std::string &base_url) override;
-        const char *getJobTypeName() const override { return "GetScriptActionId"; }
+    // What a job needs while it runs on a worker
+    struct JobContext
+    {
+        hal::INetworkManager *network;
+        const RequestUrls &urls;
+        std::string &response; // Owned by the worker and reused, so it keeps its capacity between jobs
+        JobType type;          // Of the job running, for the per-type metrics
+        std::atomic<bool> &setlist_live; // Shared by the workers - last status read found the script keeping it current
+        HostHealth &health;              // Of the host the job reads from
+        const MirrorHost *mirrors;       // The other hosts, mirror_count of them
+        size_t mirror_count;
     };
 
-    // Get Transport Job and Result
-    class GetTransportResult : public HttpJobResult
+    // Parse the tabs ExtState value, compact format or JSON. Null if it cannot be parsed.
+    std::unique_ptr<reaper::Setlist> parseTabData(std::string_view tab_data);
+
+    // Run a job on the calling worker and fill in its result
+    void runJob(const HttpJob &job, JobContext &context, HttpJobResult &result);
+
+    // Routes each result to the handler registered for its payload type. Handlers are plain
+    // functions; results nobody registered for are reported as unhandled.
+    class ResultDispatcher
     {
     public:
-        reaper::TransportState transport_state;
+        template <typename Result>
+        using Handler = void (*)(const HttpJobResult &result, Result &payload, uint32_t current_time);
 
-        GetTransportResult(uint32_t id) : HttpJobResult(id, ResultType::GET_TRANSPORT)
+    private:
+        template <typename Variant>
+        struct HandlerTable;
+        template <typename... Results>
+        struct HandlerTable<std::variant<Results...>>
         {
-            transport_state = reaper::TransportState{};
-        }
-    };
+            using type = std::tuple<Handler<Results>...>;
+        };
+
+        typename HandlerTable<ResultPayload>::type handlers{};
 
-    class GetTransportJob : public HttpJob
-    {
     public:
-        GetTransportJob(uint32_t id) : HttpJob(id) {}
+        template <typename Result>
+        void on(Handler<Result> handler) { std::get<Handler<Result>>(handlers) = handler; }
 
-        std::unique_ptr<HttpJobResult> execute(hal::INetworkManager *network_mgr, const std::string &base_url) override;
-        const char *getJobTypeName() const override { return "GetTransport"; }
+        // Returns false if no handler is registered for the result's payload type
+        bool dispatch(HttpJobResult &result, uint32_t current_time) const
+        {
+            return std::visit([&](auto &payload)
+                              {
+                auto handler = std::get<Handler<std::decay_t<decltype(payload)>>>(handlers);
+                if (!handler)
+                {
+                    return false;
+                }
+                handler(result, payload, current_time);
+                return true; },
+                              result.payload);
+        }
     };
 
 } // namespace http
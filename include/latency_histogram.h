@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size log2 histogram of millisecond latencies - no allocation, cheap enough to record on
+// every button press. Bucket 0 holds 0 ms, bucket i holds [2^(i-1), 2^i) ms and the last
+// bucket everything above.
+class LatencyHistogram
+{
+public:
+    static const size_t BUCKETS = 14; // Last bucket starts at 4096 ms
+
+private:
+    uint32_t counts[BUCKETS] = {};
+    uint32_t total = 0;
+    uint32_t max_ms = 0;
+    uint64_t sum_ms = 0;
+
+public:
+    void record(uint32_t ms)
+    {
+        size_t bucket = 0;
+        while (bucket < BUCKETS - 1 && (ms >> bucket) != 0)
+        {
+            bucket++;
+        }
+        counts[bucket]++;
+        total++;
+        sum_ms += ms;
+        if (ms > max_ms)
+        {
+            max_ms = ms;
+        }
+    }
+
+    uint32_t count() const { return total; }
+    uint32_t maxMs() const { return max_ms; }
+    uint32_t averageMs() const { return total ? (uint32_t)(sum_ms / total) : 0; }
+
+    // Upper bound of the bucket holding the given percentile (0-100)
+    uint32_t percentileMs(uint32_t percentile) const
+    {
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        uint32_t target = (uint32_t)(((uint64_t)total * percentile + 99) / 100);
+        uint32_t seen = 0;
+        for (size_t bucket = 0; bucket < BUCKETS; ++bucket)
+        {
+            seen += counts[bucket];
+            if (seen >= target && seen > 0)
+            {
+                uint32_t upper = bucket == BUCKETS - 1 ? max_ms : (1u << bucket) - 1;
+                return upper < max_ms ? upper : max_ms;
+            }
+        }
+        return max_ms;
+    }
+};
@@ -1,35 +1,104 @@
 #pragma once
 
+#include "config.h"
+
+// Severities, lowest first. Calls below LOG_MIN_LEVEL (config.h) compile to nothing, their
+// arguments are never evaluated. Format strings are printf-style on every backend.
+#define LOG_SEVERITY_TRACE 0
+#define LOG_SEVERITY_DEBUG 1
+#define LOG_SEVERITY_INFO 2
+#define LOG_SEVERITY_WARNING 3
+#define LOG_SEVERITY_ERROR 4
+#define LOG_SEVERITY_CRITICAL 5
+
+// Compiled-out calls still name their arguments (so nothing becomes unused) but never run. The
+// format attribute gives them, and the deferred calls made alongside one, -Wformat checking.
+__attribute__((format(printf, 2, 3))) inline void log_discard(const char *, const char *, ...) {}
+#define LOG_DISCARD(tag, fmt_str, ...)                       \
+    do                                                       \
+    {                                                        \
+        if (0)                                               \
+            log_discard(tag, fmt_str, ##__VA_ARGS__);        \
+    } while (0)
+
+#if LOG_DEFERRED
+#include "log_deferred.h"
+
+// Tags and formats must be string literals - records keep the pointers, not copies. The call
+// never made to log_discard() checks the format against the arguments at compile time.
+#define LOG_BACKEND(severity, tag, fmt_str, ...)                     \
+    do                                                               \
+    {                                                                \
+        if (0)                                                       \
+            log_discard(tag, fmt_str, ##__VA_ARGS__);                \
+        logging::write(severity, tag, fmt_str, ##__VA_ARGS__);       \
+    } while (0)
+#define LOG_BACKEND_TRACE(tag, fmt_str, ...) LOG_BACKEND(LOG_SEVERITY_TRACE, tag, fmt_str, ##__VA_ARGS__)
+#define LOG_BACKEND_DEBUG(tag, fmt_str, ...) LOG_BACKEND(LOG_SEVERITY_DEBUG, tag, fmt_str, ##__VA_ARGS__)
+#define LOG_BACKEND_INFO(tag, fmt_str, ...) LOG_BACKEND(LOG_SEVERITY_INFO, tag, fmt_str, ##__VA_ARGS__)
+#define LOG_BACKEND_WARNING(tag, fmt_str, ...) LOG_BACKEND(LOG_SEVERITY_WARNING, tag, fmt_str, ##__VA_ARGS__)
+#define LOG_BACKEND_ERROR(tag, fmt_str, ...) LOG_BACKEND(LOG_SEVERITY_ERROR, tag, fmt_str, ##__VA_ARGS__)
+// Critical messages are written out before the call returns, in order with everything before them
+#define LOG_BACKEND_CRITICAL(tag, fmt_str, ...)                          \
+    do                                                                   \
+    {                                                                    \
+        LOG_BACKEND(LOG_SEVERITY_CRITICAL, tag, fmt_str, ##__VA_ARGS__); \
+        logging::flush();                                                \
+    } while (0)
+#endif
+
 #ifdef NATIVE_BUILD
 #include <cstdio>
 #include <ctime>
 #include <iostream>
 
+#if !LOG_DEFERRED
 // Simple logging for native build using printf
-#define LOG_TRACE(tag, fmt_str, ...) printf("[TRACE][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
-#define LOG_DEBUG(tag, fmt_str, ...) printf("[DEBUG][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
-#define LOG_INFO(tag, fmt_str, ...) printf("[INFO][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
-#define LOG_WARNING(tag, fmt_str, ...) printf("[WARN][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
-#define LOG_ERROR(tag, fmt_str, ...) printf("[ERROR][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
-#define LOG_CRITICAL(tag, fmt_str, ...) printf("[FATAL][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
+#define LOG_BACKEND_TRACE(tag, fmt_str, ...) printf("[TRACE][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
+#define LOG_BACKEND_DEBUG(tag, fmt_str, ...) printf("[DEBUG][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
+#define LOG_BACKEND_INFO(tag, fmt_str, ...) printf("[INFO][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
+#define LOG_BACKEND_WARNING(tag, fmt_str, ...) printf("[WARN][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
+#define LOG_BACKEND_ERROR(tag, fmt_str, ...) printf("[ERROR][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
+#define LOG_BACKEND_CRITICAL(tag, fmt_str, ...) printf("[FATAL][%s] " fmt_str "\n", tag, ##__VA_ARGS__)
+#endif
 
 // Initialize logging for native build
 inline void init_logging()
 {
+#if LOG_DEFERRED
+    logging::start();
+#endif
     printf("=== Native logging initialized ===\n");
 }
 
 #else
 #include <Arduino.h>
+
+#if LOG_DEFERRED
+// Initialize logging for Arduino build
+inline void init_logging()
+{
+    // Wait for Serial to be ready
+    delay(100);
+    while (!Serial)
+    {
+        delay(10);
+    }
+
+    logging::start();
+    LOG_BACKEND_INFO("Log", "=== Logging initialized ===");
+}
+
+#else
 #include <ArduinoLog.h>
 
 // For Arduino build, use printf-style format strings directly
-#define LOG_TRACE(tag, fmt_str, ...) Log.traceln("[%s] " fmt_str, tag, ##__VA_ARGS__)
-#define LOG_DEBUG(tag, fmt_str, ...) Log.verboseln("[%s] " fmt_str, tag, ##__VA_ARGS__)
-#define LOG_INFO(tag, fmt_str, ...) Log.infoln("[%s] " fmt_str, tag, ##__VA_ARGS__)
-#define LOG_WARNING(tag, fmt_str, ...) Log.warningln("[%s] " fmt_str, tag, ##__VA_ARGS__)
-#define LOG_ERROR(tag, fmt_str, ...) Log.errorln("[%s] " fmt_str, tag, ##__VA_ARGS__)
-#define LOG_CRITICAL(tag, fmt_str, ...) Log.fatalln("[%s] " fmt_str, tag, ##__VA_ARGS__)
+#define LOG_BACKEND_TRACE(tag, fmt_str, ...) Log.traceln("[%s] " fmt_str, tag, ##__VA_ARGS__)
+#define LOG_BACKEND_DEBUG(tag, fmt_str, ...) Log.verboseln("[%s] " fmt_str, tag, ##__VA_ARGS__)
+#define LOG_BACKEND_INFO(tag, fmt_str, ...) Log.infoln("[%s] " fmt_str, tag, ##__VA_ARGS__)
+#define LOG_BACKEND_WARNING(tag, fmt_str, ...) Log.warningln("[%s] " fmt_str, tag, ##__VA_ARGS__)
+#define LOG_BACKEND_ERROR(tag, fmt_str, ...) Log.errorln("[%s] " fmt_str, tag, ##__VA_ARGS__)
+#define LOG_BACKEND_CRITICAL(tag, fmt_str, ...) Log.fatalln("[%s] " fmt_str, tag, ##__VA_ARGS__)
 
 // Initialize logging for Arduino build
 inline void init_logging()
@@ -41,7 +110,8 @@ inline void init_logging()
         delay(10);
     }
 
-    Log.begin(LOG_LEVEL_INFO, &Serial);
+    // Everything reaching ArduinoLog already passed LOG_MIN_LEVEL
+    Log.begin(LOG_LEVEL_VERBOSE, &Serial);
     Log.setPrefix([](Print *_logOutput, int logLevel)
                   {
         const char* levelStr = "";
@@ -64,5 +134,46 @@ inline void init_logging()
     // Print a startup message to verify logging is working
     Log.infoln("=== Logging initialized ===");
 }
+#endif
+
+#endif
+
+// Write out deferred messages now, e.g. before deep sleep - a no-op when not deferred
+inline void log_flush()
+{
+#if LOG_DEFERRED
+    logging::flush();
+#endif
+}
+
+#if LOG_MIN_LEVEL <= LOG_SEVERITY_TRACE
+#define LOG_TRACE(tag, fmt_str, ...) LOG_BACKEND_TRACE(tag, fmt_str, ##__VA_ARGS__)
+#else
+#define LOG_TRACE(tag, fmt_str, ...) LOG_DISCARD(tag, fmt_str, ##__VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_SEVERITY_DEBUG
+#define LOG_DEBUG(tag, fmt_str, ...) LOG_BACKEND_DEBUG(tag, fmt_str, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(tag, fmt_str, ...) LOG_DISCARD(tag, fmt_str, ##__VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_SEVERITY_INFO
+#define LOG_INFO(tag, fmt_str, ...) LOG_BACKEND_INFO(tag, fmt_str, ##__VA_ARGS__)
+#else
+#define LOG_INFO(tag, fmt_str, ...) LOG_DISCARD(tag, fmt_str, ##__VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_SEVERITY_WARNING
+#define LOG_WARNING(tag, fmt_str, ...) LOG_BACKEND_WARNING(tag, fmt_str, ##__VA_ARGS__)
+#else
+#define LOG_WARNING(tag, fmt_str, ...) LOG_DISCARD(tag, fmt_str, ##__VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_SEVERITY_ERROR
+#define LOG_ERROR(tag, fmt_str, ...) LOG_BACKEND_ERROR(tag, fmt_str, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(tag, fmt_str, ...) LOG_DISCARD(tag, fmt_str, ##__VA_ARGS__)
+#endif
 
-#endif
\ No newline at end of file
+#define LOG_CRITICAL(tag, fmt_str, ...) LOG_BACKEND_CRITICAL(tag, fmt_str, ##__VA_ARGS__)
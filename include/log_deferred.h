@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Deferred logging (LOG_DEFERRED): a log call copies its tag and format pointers (string
+// literals, so they outlive the record) and its raw arguments into a fixed-size record on a
+// lock-free ring. A low-priority drain task formats the records and writes them out, so the
+// HTTP workers and the render loop never wait on the UART.
+namespace logging
+{
+    // Integers are tagged with their width (after the usual promotion to int) and signedness,
+    // so the drain formats them as printf would have formatted the original argument
+    enum class ArgType : uint8_t
+    {
+        INT32,
+        UINT32,
+        INT64,
+        UINT64,
+        DOUBLE,
+        STRING, // Length byte then the characters, truncated to what fits
+        POINTER
+    };
+
+    struct Record
+    {
+        const char *tag;
+        const char *format;
+        uint32_t timestamp_ms;
+        uint8_t level;
+        uint8_t payload_size;
+        bool truncated; // Arguments that did not fit print as "?"
+        uint8_t payload[53];
+    };
+
+    // Encodes the arguments of one call into a record
+    class RecordWriter
+    {
+    private:
+        Record &record;
+
+        void put(ArgType type, const void *value, size_t size)
+        {
+            if (record.truncated || record.payload_size + 1 + size > sizeof(record.payload))
+            {
+                record.truncated = true;
+                return;
+            }
+            record.payload[record.payload_size++] = (uint8_t)type;
+            memcpy(record.payload + record.payload_size, value, size);
+            record.payload_size += size;
+        }
+
+        void putString(const char *text)
+        {
+            if (!text)
+            {
+                text = "(null)";
+            }
+            size_t room = sizeof(record.payload) - record.payload_size;
+            if (record.truncated || room < 2)
+            {
+                record.truncated = true;
+                return;
+            }
+            size_t length = strnlen(text, room - 2);
+            record.payload[record.payload_size++] = (uint8_t)ArgType::STRING;
+            record.payload[record.payload_size++] = (uint8_t)length;
+            memcpy(record.payload + record.payload_size, text, length);
+            record.payload_size += length;
+        }
+
+    public:
+        explicit RecordWriter(Record &target) : record(target) {}
+
+        template <typename T>
+        void add(const T &value)
+        {
+            if constexpr (std::is_convertible<T, const char *>::value)
+            {
+                putString(value);
+            }
+            else if constexpr (std::is_pointer<T>::value)
+            {
+                uint64_t address = (uint64_t)(uintptr_t)value;
+                put(ArgType::POINTER, &address, sizeof(address));
+            }
+            else if constexpr (std::is_floating_point<T>::value)
+            {
+                double number = value;
+                put(ArgType::DOUBLE, &number, sizeof(number));
+            }
+            else if constexpr (std::is_enum<T>::value)
+            {
+                add((typename std::underlying_type<T>::type)value);
+            }
+            else
+            {
+                static_assert(std::is_integral<T>::value, "Log arguments must be numbers, strings or pointers");
+                if constexpr (sizeof(T) <= 4 && std::is_signed<T>::value)
+                {
+                    int32_t number = value;
+                    put(ArgType::INT32, &number, sizeof(number));
+                }
+                else if constexpr (sizeof(T) <= 4)
+                {
+                    uint32_t number = value;
+                    put(ArgType::UINT32, &number, sizeof(number));
+                }
+                else if constexpr (std::is_signed<T>::value)
+                {
+                    int64_t number = value;
+                    put(ArgType::INT64, &number, sizeof(number));
+                }
+                else
+                {
+                    uint64_t number = value;
+                    put(ArgType::UINT64, &number, sizeof(number));
+                }
+            }
+        }
+    };
+
+    // Queue a finished record - counts it as dropped if the ring is full. Never blocks.
+    void push(Record &record);
+
+    template <typename... Args>
+    void write(uint8_t level, const char *tag, const char *format, const Args &...args)
+    {
+        Record record;
+        record.tag = tag;
+        record.format = format;
+        record.level = level;
+        record.payload_size = 0;
+        record.truncated = false;
+        RecordWriter writer(record);
+        (writer.add(args), ...);
+        push(record);
+    }
+
+    // Format one record as a complete line ending in '\n'. Returns the length written.
+    size_t formatRecord(const Record &record, char *buffer, size_t size);
+
+    // Start the drain task
+    void start();
+
+    // Write out everything queued so far from the calling thread - before sleeping or restarting
+    void flush();
+
+} // namespace logging
@@ -68,10 +68,10 @@
 
 #if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
     /** Size of memory available for `lv_malloc()` in bytes (>= 2kB) */
-    #ifdef NATIVE_BUILD
+    #if defined(NATIVE_BUILD) && !defined(NATIVE_BENCH)
         #define LV_MEM_SIZE (128 * 1024U)      /**< [bytes] - Large for native build */
     #else
-        #define LV_MEM_SIZE (32 * 1024U)       /**< [bytes] - Smaller for ESP32 hardware */
+        #define LV_MEM_SIZE (32 * 1024U)       /**< [bytes] - Smaller for ESP32 hardware, and the bench renders in the same pool */
     #endif
 
     /** Size of the memory expand for `lv_malloc()` in bytes */
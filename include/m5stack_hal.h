@@ -8,6 +8,13 @@
 #include <HTTPClient.h>
 #include <lvgl.h>
 #include <Wire.h>
+#include <esp_heap_caps.h>
+#include <esp_sleep.h>
+#include <lwip/sockets.h>
+#include <algorithm>
+#include <cstdint>
+#include "log.h"
+#include "config.h"
 
 namespace hal
 {
@@ -15,32 +22,299 @@ namespace hal
     class M5StackNetworkManager : public INetworkManager
     {
     private:
+        WiFiClient client; // Persistent TCP connection shared with HTTPClient
         HTTPClient http;
         bool connected = false;
         String ip_address;
+        bool keep_alive = HTTP_KEEP_ALIVE;
+        HttpStatsCounters stats;
+        int udp_socket = -1; // Push channel
+
+        // Pipelined request in flight (httpSend/httpReceive)
+        bool request_pending = false;
+        bool pending_reused = false;
+        uint32_t pending_connect_ms = 0;
+        uint32_t pending_sent_at = 0;
+
+        static const uint32_t CONNECT_TIMEOUT_MS = 10000;
+        static const uint32_t FAST_CONNECT_TIMEOUT_MS = 3000; // Falls back to a full connect after this
+        static const uint32_t CONNECT_POLL_MS = 20;
+        static const uint32_t RESPONSE_TIMEOUT_MS = 5000;
+        static const size_t REQUEST_BUFFER_SIZE = 640;
+        static const size_t HEADER_LINE_SIZE = 128;
+
+        // Last association and address, kept in RTC memory so a wake from deep sleep can rejoin
+        // without a scan or DHCP. Lost on power off, discarded whenever a fast reconnect fails.
+        struct WiFiRtcCache
+        {
+            static const uint32_t MAGIC = 0x57464331; // "WFC1"
+            uint32_t magic;
+            char ssid[33];
+            uint8_t bssid[6];
+            int32_t channel;
+            uint32_t ip;
+            uint32_t gateway;
+            uint32_t subnet;
+            uint32_t dns;
+
+            bool matches(const char *wanted_ssid) const { return magic == MAGIC && strcmp(ssid, wanted_ssid) == 0; }
+        };
+        static WiFiRtcCache wifi_cache;
+
+        // WIFI_STATIC_IP, if configured and valid
+        static bool staticAddress(IPAddress &ip, IPAddress &gateway, IPAddress &subnet, IPAddress &dns)
+        {
+            if (strlen(WIFI_STATIC_IP) == 0)
+            {
+                return false;
+            }
+            if (!ip.fromString(WIFI_STATIC_IP) || !gateway.fromString(WIFI_GATEWAY) || !subnet.fromString(WIFI_SUBNET))
+            {
+                LOG_ERROR("WIFI", "Invalid static address configuration, using DHCP");
+                return false;
+            }
+            if (!dns.fromString(WIFI_DNS))
+            {
+                dns = gateway;
+            }
+            return true;
+        }
+
+        static bool waitForConnection(uint32_t timeout_ms)
+        {
+            uint32_t start = millis();
+            while (WiFi.status() != WL_CONNECTED && millis() - start < timeout_ms)
+            {
+                delay(CONNECT_POLL_MS);
+            }
+            return WiFi.status() == WL_CONNECTED;
+        }
+
+        // Rejoin the cached access point on its channel, with the static address or the cached lease
+        bool fastReconnect(const char *ssid, const char *password)
+        {
+#if WIFI_FAST_RECONNECT
+            if (!wifi_cache.matches(ssid))
+            {
+                return false;
+            }
+
+            IPAddress ip, gateway, subnet, dns;
+            if (!staticAddress(ip, gateway, subnet, dns))
+            {
+                ip = IPAddress(wifi_cache.ip);
+                gateway = IPAddress(wifi_cache.gateway);
+                subnet = IPAddress(wifi_cache.subnet);
+                dns = IPAddress(wifi_cache.dns);
+            }
+            WiFi.config(ip, gateway, subnet, dns);
+            WiFi.begin(ssid, password, wifi_cache.channel, wifi_cache.bssid);
+            if (waitForConnection(FAST_CONNECT_TIMEOUT_MS))
+            {
+                return true;
+            }
+
+            LOG_WARNING("WIFI", "Fast reconnect to channel %d failed, doing a full connect", (int)wifi_cache.channel);
+            wifi_cache.magic = 0;
+            WiFi.disconnect();
+#endif
+            return false;
+        }
+
+        void saveConnection(const char *ssid)
+        {
+#if WIFI_FAST_RECONNECT
+            snprintf(wifi_cache.ssid, sizeof(wifi_cache.ssid), "%s", ssid);
+            memcpy(wifi_cache.bssid, WiFi.BSSID(), sizeof(wifi_cache.bssid));
+            wifi_cache.channel = WiFi.channel();
+            wifi_cache.ip = (uint32_t)WiFi.localIP();
+            wifi_cache.gateway = (uint32_t)WiFi.gatewayIP();
+            wifi_cache.subnet = (uint32_t)WiFi.subnetMask();
+            wifi_cache.dns = (uint32_t)WiFi.dnsIP();
+            wifi_cache.magic = WiFiRtcCache::MAGIC;
+#endif
+        }
+
+        // Extract host and port from "http://host:port/..." so the connection can be opened (and timed) up front
+        static bool parseHostPort(const char *url, String &host, uint16_t &port)
+        {
+            const char *start = strstr(url, "://");
+            start = start ? start + 3 : url;
+
+            const char *end = start;
+            while (*end && *end != ':' && *end != '/')
+            {
+                end++;
+            }
+            if (end == start)
+                return false;
+
+            host = String(start).substring(0, end - start);
+            port = (*end == ':') ? (uint16_t)atoi(end + 1) : 80;
+            return true;
+        }
+
+        // HTTPClient errors that indicate the server dropped an idle keep-alive connection
+        // A stale keep-alive connection failed before the request was written
+        static bool failedBeforeSend(int status_code)
+        {
+            return status_code == HTTPC_ERROR_SEND_HEADER_FAILED || status_code == HTTPC_ERROR_NOT_CONNECTED;
+        }
+
+        // Perform one request. Sets reused when the existing connection was used.
+        bool performRequest(const char *url, std::string &response, int &status_code, bool &reused)
+        {
+            response.clear();
+            reused = keep_alive && client.connected();
+
+            uint32_t connect_ms = 0;
+            if (!reused)
+            {
+                client.stop();
+
+                String host;
+                uint16_t port = 0;
+                uint32_t connect_start = millis();
+                if (!parseHostPort(url, host, port) || !client.connect(host.c_str(), port))
+                {
+                    status_code = HTTPC_ERROR_CONNECTION_REFUSED;
+                    stats.recordRequest(false, true, millis() - connect_start, 0);
+                    return false;
+                }
+                connect_ms = millis() - connect_start;
+            }
+
+            // HTTPClient picks up the already connected client and only sends the request
+            http.setReuse(keep_alive);
+            http.begin(client, url);
+
+            uint32_t request_start = millis();
+            status_code = http.GET(); // Returns once the status line and headers have arrived
+            uint32_t ttfb_ms = millis() - request_start;
+
+            if (status_code > 0)
+            {
+                String payload = http.getString();
+                response.assign(payload.c_str(), payload.length());
+            }
+
+            // Keeps the connection open when reuse is enabled and the server allows it
+            http.end();
+
+            stats.recordRequest(status_code > 0, !reused, connect_ms, ttfb_ms);
+            return status_code > 0;
+        }
+
+        // Read one line of the response head without its line ending (truncated to fit) - false
+        // on timeout or when the server closed the connection
+        bool readLine(char *line, size_t size, uint32_t deadline)
+        {
+            size_t length = 0;
+            while ((int32_t)(deadline - millis()) > 0)
+            {
+                int c = client.read();
+                if (c < 0)
+                {
+                    if (!client.connected())
+                        return false;
+                    delay(1);
+                    continue;
+                }
+                if (c == '\n')
+                {
+                    if (length > 0 && line[length - 1] == '\r')
+                        length--;
+                    line[length] = '\0';
+                    return true;
+                }
+                if (length < size - 1)
+                    line[length++] = (char)c;
+            }
+            return false;
+        }
+
+        // Append count body bytes, or everything until the server closes for SIZE_MAX
+        bool readBody(std::string &response, size_t count, uint32_t deadline)
+        {
+            char buffer[256];
+            while (count > 0 && (int32_t)(deadline - millis()) > 0)
+            {
+                int available = client.available();
+                if (available <= 0)
+                {
+                    if (!client.connected())
+                        return count == SIZE_MAX;
+                    delay(1);
+                    continue;
+                }
+                size_t wanted = std::min(sizeof(buffer), std::min(count, (size_t)available));
+                int length = client.read((uint8_t *)buffer, wanted);
+                if (length > 0)
+                {
+                    response.append(buffer, length);
+                    if (count != SIZE_MAX)
+                        count -= length;
+                }
+            }
+            return count == 0;
+        }
+
+        // Body in chunked transfer encoding
+        bool readChunkedBody(std::string &response, uint32_t deadline)
+        {
+            char line[HEADER_LINE_SIZE];
+            while (readLine(line, sizeof(line), deadline))
+            {
+                size_t chunk_size = strtoul(line, nullptr, 16);
+                if (chunk_size == 0)
+                {
+                    // Skip any trailers up to the closing empty line
+                    while (readLine(line, sizeof(line), deadline))
+                    {
+                        if (line[0] == '\0')
+                            return true;
+                    }
+                    return false;
+                }
+                if (!readBody(response, chunk_size, deadline) || !readLine(line, sizeof(line), deadline))
+                    return false;
+            }
+            return false;
+        }
 
     public:
         bool connect(const char *ssid, const char *password) override
         {
-            WiFi.begin(ssid, password);
-
-            int attempts = 0;
-            while (WiFi.status() != WL_CONNECTED && attempts < 20)
+            uint32_t start = millis();
+            bool fast = fastReconnect(ssid, password);
+            if (!fast)
             {
-                delay(500);
-                attempts++;
+                IPAddress ip, gateway, subnet, dns;
+                if (staticAddress(ip, gateway, subnet, dns))
+                {
+                    WiFi.config(ip, gateway, subnet, dns);
+                }
+                else
+                {
+                    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE); // Back to DHCP
+                }
+                WiFi.begin(ssid, password);
+                waitForConnection(CONNECT_TIMEOUT_MS);
             }
 
             connected = (WiFi.status() == WL_CONNECTED);
             if (connected)
             {
                 ip_address = WiFi.localIP().toString();
+                saveConnection(ssid);
+                LOG_INFO("WIFI", "%s in %u ms", fast ? "Fast reconnect" : "Connected", (unsigned)(millis() - start));
             }
             return connected;
         }
 
         bool disconnect() override
         {
+            client.stop();
             WiFi.disconnect();
             connected = false;
             ip_address = "";
@@ -58,23 +332,219 @@ namespace hal
             return ip_address.c_str();
         }
 
-        bool httpGetBlocking(const char *url, std::string &response, int &status_code) override
+        bool httpGetBlocking(const char *url, std::string &response, int &status_code, bool repeatable) override
         {
-            http.begin(url);
-            status_code = http.GET();
+            bool reused = false;
+            bool ok = performRequest(url, response, status_code, reused);
 
-            if (status_code > 0)
+            // The server may have dropped an idle keep-alive connection - retry once on a new one.
+            // A lost response is only retried for requests that are safe to run twice.
+            bool stale = failedBeforeSend(status_code) || (repeatable && status_code == HTTPC_ERROR_CONNECTION_LOST);
+            if (!ok && reused && stale)
             {
-                String payload = http.getString();
-                response = payload.c_str();
+                stats.recordReconnect();
+                client.stop();
+                ok = performRequest(url, response, status_code, reused);
             }
-            else
+
+            if (!keep_alive)
+            {
+                client.stop();
+            }
+            return ok;
+        }
+
+        // Written straight to the client - HTTPClient cannot split a request from its response
+        bool httpSend(const char *url, int &status_code) override
+        {
+            String host;
+            uint16_t port = 0;
+            const char *authority = strstr(url, "://");
+            const char *path = strchr(authority ? authority + 3 : url, '/');
+            if (!parseHostPort(url, host, port))
+            {
+                status_code = HTTPC_ERROR_CONNECTION_REFUSED;
+                return false;
+            }
+
+            char request[REQUEST_BUFFER_SIZE];
+            int length = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s:%u\r\nConnection: %s\r\n\r\n",
+                                  path ? path : "/", host.c_str(), (unsigned)port, keep_alive ? "keep-alive" : "close");
+            if (length <= 0 || (size_t)length >= sizeof(request))
+            {
+                status_code = HTTPC_ERROR_TOO_LESS_RAM;
+                return false;
+            }
+
+            for (int attempt = 0; attempt < 2; ++attempt)
+            {
+                pending_reused = keep_alive && client.connected();
+                pending_connect_ms = 0;
+                if (!pending_reused)
+                {
+                    client.stop();
+                    uint32_t connect_start = millis();
+                    if (!client.connect(host.c_str(), port))
+                    {
+                        status_code = HTTPC_ERROR_CONNECTION_REFUSED;
+                        stats.recordRequest(false, true, millis() - connect_start, 0);
+                        return false;
+                    }
+                    pending_connect_ms = millis() - connect_start;
+                    client.setNoDelay(true); // The request goes out now, not with the next segment
+                }
+
+                if (client.write((const uint8_t *)request, length) == (size_t)length)
+                {
+                    request_pending = true;
+                    pending_sent_at = millis();
+                    status_code = 0;
+                    return true;
+                }
+
+                // The server may have dropped an idle keep-alive connection - retry once on a new one
+                client.stop();
+                if (!pending_reused)
+                    break;
+                stats.recordReconnect();
+            }
+
+            status_code = HTTPC_ERROR_SEND_HEADER_FAILED;
+            stats.recordRequest(false, !pending_reused, pending_connect_ms, 0);
+            return false;
+        }
+
+        bool httpReceive(std::string &response, int &status_code) override
+        {
+            response.clear();
+            if (!request_pending)
+            {
+                status_code = HTTPC_ERROR_NOT_CONNECTED;
+                return false;
+            }
+            request_pending = false;
+
+            uint32_t deadline = millis() + RESPONSE_TIMEOUT_MS;
+            char line[HEADER_LINE_SIZE];
+            const char *status = nullptr;
+            if (readLine(line, sizeof(line), deadline) && strncmp(line, "HTTP/", 5) == 0)
+            {
+                status = strchr(line, ' ');
+            }
+            if (!status)
+            {
+                client.stop();
+                status_code = HTTPC_ERROR_CONNECTION_LOST;
+                stats.recordRequest(false, !pending_reused, pending_connect_ms, 0);
+                return false;
+            }
+            status_code = atoi(status + 1);
+            uint32_t ttfb_ms = millis() - pending_sent_at;
+
+            size_t content_length = SIZE_MAX;
+            bool chunked = false;
+            bool close = !keep_alive;
+            bool ok = false;
+            while (readLine(line, sizeof(line), deadline))
+            {
+                if (line[0] == '\0')
+                {
+                    ok = true;
+                    break;
+                }
+                if (strncasecmp(line, "Content-Length:", 15) == 0)
+                    content_length = strtoul(line + 15, nullptr, 10);
+                else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0)
+                    chunked = strstr(line + 18, "chunked") != nullptr;
+                else if (strncasecmp(line, "Connection:", 11) == 0)
+                    close = strstr(line + 11, "close") != nullptr;
+            }
+
+            if (ok)
+            {
+                ok = chunked ? readChunkedBody(response, deadline) : readBody(response, content_length, deadline);
+            }
+            // Without a length the body ran to the end of the connection
+            if (!ok || close || (!chunked && content_length == SIZE_MAX))
+            {
+                client.stop();
+            }
+
+            stats.recordRequest(ok && status_code > 0, !pending_reused, pending_connect_ms, ttfb_ms);
+            if (!ok)
             {
                 response.clear();
+                status_code = HTTPC_ERROR_READ_TIMEOUT;
             }
+            return ok;
+        }
 
-            http.end();
-            return status_code > 0;
+        void setKeepAlive(bool enable) override
+        {
+            keep_alive = enable;
+            if (!keep_alive)
+            {
+                client.stop();
+            }
+        }
+
+        bool isKeepAliveEnabled() const override
+        {
+            return keep_alive;
+        }
+
+        HttpStats getHttpStats() const override
+        {
+            return stats.snapshot();
+        }
+
+        bool udpOpen(uint16_t port) override
+        {
+            if (udp_socket >= 0)
+                return true;
+
+            int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            if (sock < 0)
+                return false;
+
+            struct sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+            if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+            {
+                closesocket(sock);
+                return false;
+            }
+            udp_socket = sock;
+            return true;
+        }
+
+        int udpReceive(char *buffer, size_t size, uint32_t timeout_ms) override
+        {
+            if (udp_socket < 0)
+                return -1;
+
+            struct timeval timeout;
+            timeout.tv_sec = timeout_ms / 1000;
+            timeout.tv_usec = (timeout_ms % 1000) * 1000;
+            setsockopt(udp_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            int length = recv(udp_socket, buffer, size, 0);
+            if (length < 0)
+            {
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+            }
+            return length;
+        }
+
+        void udpClose() override
+        {
+            if (udp_socket >= 0)
+            {
+                closesocket(udp_socket);
+                udp_socket = -1;
+            }
         }
     };
 
@@ -120,14 +590,9 @@ namespace hal
 
         void enableWiFiPowerSave(bool enable) override
         {
-            if (enable)
-            {
-                WiFi.setSleep(true);
-            }
-            else
-            {
-                WiFi.setSleep(false);
-            }
+            // Maximum modem sleep - the radio only wakes for DTIM beacons (and our own traffic),
+            // the association is kept
+            WiFi.setSleep(enable ? WIFI_PS_MAX_MODEM : WIFI_PS_NONE);
         }
     };
 
@@ -136,6 +601,8 @@ namespace hal
     private:
         static M5StackDisplayManager *instance;
         uint8_t current_brightness = 100;
+        uint64_t pixels_flushed = 0;
+        bool dma_in_flight = false; // A strip is being sent and the SPI transaction is still open
 
     public:
         M5StackDisplayManager()
@@ -156,15 +623,28 @@ namespace hal
 
         void turnOn() override
         {
+            finishTransfer();
             M5.Lcd.wakeup();
             setBrightness(current_brightness);
         }
 
         void turnOff() override
         {
+            finishTransfer();
             M5.Lcd.sleep();
         }
 
+        // Block until an asynchronous strip transfer has completed and release the bus
+        void finishTransfer()
+        {
+            if (dma_in_flight)
+            {
+                M5.Lcd.dmaWait();
+                M5.Lcd.endWrite();
+                dma_in_flight = false;
+            }
+        }
+
         uint16_t getWidth() const override
         {
             return 320;
@@ -185,11 +665,45 @@ namespace hal
             M5.Lcd.pushImage(x1, y1, x2 - x1 + 1, y2 - y1 + 1, (uint16_t *)color_p);
         }
 
+        uint64_t getPixelsFlushed() const override
+        {
+            return pixels_flushed;
+        }
+
         static void lvgl_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
         {
             if (instance)
             {
                 instance->flush(area->x1, area->y1, area->x2, area->y2, (uint16_t *)px_map);
+                instance->pixels_flushed += (uint64_t)(area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1);
+            }
+            lv_display_flush_ready(disp);
+        }
+
+        // Double-buffered path (DISPLAY_DMA_FLUSH): start the SPI DMA transfer and return immediately so LVGL can
+        // render the next strip into the other buffer
+        static void lvgl_flush_dma_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+        {
+            if (!instance)
+            {
+                lv_display_flush_ready(disp);
+                return;
+            }
+
+            instance->finishTransfer();
+            M5.Lcd.startWrite();
+            M5.Lcd.pushImageDMA(area->x1, area->y1, area->x2 - area->x1 + 1, area->y2 - area->y1 + 1, (uint16_t *)px_map);
+            instance->dma_in_flight = true;
+            instance->pixels_flushed += (uint64_t)(area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1);
+        }
+
+        // Called by LVGL before it reuses a buffer that may still be on the wire - this is where
+        // the transfer completes and the buffer is handed back
+        static void lvgl_flush_wait_cb(lv_display_t *disp)
+        {
+            if (instance)
+            {
+                instance->finishTransfer();
             }
             lv_display_flush_ready(disp);
         }
@@ -268,22 +782,91 @@ namespace hal
     {
     private:
         M5StackNetworkManager network_mgr;
+#if HTTP_USER_WORKER
+        M5StackNetworkManager user_network_mgr; // Own connection for button actions
+#endif
+        M5StackNetworkManager backup_network_mgr; // REAPER_BACKUP_SERVER
         M5StackPowerManager power_mgr;
         M5StackDisplayManager display_mgr;
         M5StackInputManager input_mgr;
 
-        // LVGL display and input objects
-        static const size_t buf_size = 320 * 15; // Reduced from 60 to 15 lines
-        static lv_color_t buf_1[buf_size];
+        // LVGL display and input objects. Draw buffers live in internal DMA-capable RAM, PSRAM
+        // cannot be used as an SPI DMA source
+        static const size_t buf_size = 320 * DISPLAY_BUFFER_LINES;
+        lv_color_t *buf_1 = nullptr;
+        lv_color_t *buf_2 = nullptr;
         lv_display_t *display;
         lv_indev_t *indev;
 
+        // Main loop wake-ups - button edges and signalEvent() notify the loop task
+        static TaskHandle_t main_task;
+        static volatile bool input_settling;
+        static const uint32_t BUTTON_SETTLE_MS = 15; // Keep polling past the 10 ms button debounce after an edge
+
+        // Survive deep sleep (RTC memory), cleared on power on
+        static char rtc_script_action_id[64];
+        static uint8_t rtc_retained_buffer[RETAINED_BUFFER_SIZE];
+
+        static void IRAM_ATTR button_isr()
+        {
+            input_settling = true;
+            BaseType_t higher_priority_woken = pdFALSE;
+            if (main_task)
+            {
+                vTaskNotifyGiveFromISR(main_task, &higher_priority_woken);
+            }
+            if (higher_priority_woken)
+            {
+                portYIELD_FROM_ISR();
+            }
+        }
+
+        static uint32_t tick_cb()
+        {
+            return millis();
+        }
+
+        void setupDisplayBuffers()
+        {
+            const size_t buf_bytes = buf_size * sizeof(lv_color_t);
+            buf_1 = (lv_color_t *)heap_caps_malloc(buf_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            if (!buf_1)
+            {
+                Serial.println("Failed to allocate LVGL draw buffer");
+                return;
+            }
+
+#if DISPLAY_DMA_FLUSH
+            buf_2 = (lv_color_t *)heap_caps_malloc(buf_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            if (buf_2)
+            {
+                M5.Lcd.initDMA();
+                lv_display_set_flush_cb(display, M5StackDisplayManager::lvgl_flush_dma_cb);
+                lv_display_set_flush_wait_cb(display, M5StackDisplayManager::lvgl_flush_wait_cb);
+                lv_display_set_buffers(display, buf_1, buf_2, buf_bytes, LV_DISPLAY_RENDER_MODE_PARTIAL);
+                Serial.printf("Display: DMA double buffer, %u lines\n", (unsigned)DISPLAY_BUFFER_LINES);
+                return;
+            }
+            Serial.println("No RAM for second draw buffer, using synchronous flush");
+#endif
+
+            lv_display_set_flush_cb(display, M5StackDisplayManager::lvgl_flush_cb);
+            lv_display_set_buffers(display, buf_1, nullptr, buf_bytes, LV_DISPLAY_RENDER_MODE_PARTIAL);
+            Serial.printf("Display: single buffer, %u lines\n", (unsigned)DISPLAY_BUFFER_LINES);
+        }
+
     public:
         M5StackSystemHAL()
         {
         }
 
         INetworkManager &getNetworkManager() override { return network_mgr; }
+#if HTTP_USER_WORKER
+        INetworkManager &getUserNetworkManager() override { return user_network_mgr; }
+#else
+        INetworkManager &getUserNetworkManager() override { return network_mgr; }
+#endif
+        INetworkManager &getBackupNetworkManager() override { return backup_network_mgr; }
         IPowerManager &getPowerManager() override { return power_mgr; }
         IDisplayManager &getDisplayManager() override { return display_mgr; }
         IInputManager &getInputManager() override { return input_mgr; }
@@ -294,17 +877,32 @@ namespace hal
             M5.begin();
             Serial.begin(115200);
 
+#if defined(BOARD_HAS_PSRAM) && PSRAM_MALLOC_THRESHOLD
+            // Large allocations (HTTP responses, setlists) go to PSRAM first, leaving internal RAM
+            // for the task stacks, the DMA draw buffers and the many small objects
+            if (psramFound())
+            {
+                heap_caps_malloc_extmem_enable(PSRAM_MALLOC_THRESHOLD);
+            }
+#endif
+
             // Explicitly initialize I2C (Wire) to prevent I2C communication errors
             // M5.begin() should do this, but we'll be explicit to ensure it works
             Wire.begin();
 
+            // Wake the main loop on any button edge instead of polling for presses
+            main_task = xTaskGetCurrentTaskHandle();
+            attachInterrupt(digitalPinToInterrupt(BUTTON_A_PIN), button_isr, CHANGE);
+            attachInterrupt(digitalPinToInterrupt(BUTTON_B_PIN), button_isr, CHANGE);
+            attachInterrupt(digitalPinToInterrupt(BUTTON_C_PIN), button_isr, CHANGE);
+
             // Initialize LVGL
             lv_init();
+            lv_tick_set_cb(tick_cb);
 
             // Create display (LVGL 9.x API)
             display = lv_display_create(320, 240);
-            lv_display_set_flush_cb(display, M5StackDisplayManager::lvgl_flush_cb);
-            lv_display_set_buffers(display, buf_1, nullptr, buf_size * sizeof(lv_color_t), LV_DISPLAY_RENDER_MODE_PARTIAL);
+            setupDisplayBuffers();
 
             // Create input device (LVGL 9.x API)
             indev = lv_indev_create();
@@ -317,7 +915,6 @@ namespace hal
         void update() override
         {
             input_mgr.update();
-            lv_timer_handler();
         }
 
         uint32_t getMillis() const override
@@ -325,11 +922,79 @@ namespace hal
             return millis();
         }
 
+        uint32_t getMicros() const override
+        {
+            return micros();
+        }
+
         void delay(uint32_t ms) override
         {
             ::delay(ms);
         }
 
+        bool wokeFromSleep() const override
+        {
+            return esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED;
+        }
+
+        const char *getCachedScriptActionId() const override
+        {
+            return rtc_script_action_id;
+        }
+
+        void cacheScriptActionId(const char *id) override
+        {
+            snprintf(rtc_script_action_id, sizeof(rtc_script_action_id), "%s", id);
+        }
+
+        uint8_t *getRetainedBuffer(size_t &capacity) override
+        {
+            capacity = sizeof(rtc_retained_buffer);
+            return rtc_retained_buffer;
+        }
+
+        HeapStats getHeapStats() const override
+        {
+            // Internal RAM only - that is where std containers and LVGL live
+            HeapStats stats;
+            stats.free_bytes = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            stats.min_free_bytes = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            stats.largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            stats.psram_free_bytes = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+            stats.psram_largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+            return stats;
+        }
+
+        uint32_t getStackHighWaterMark(const char *task_name) const override
+        {
+            // Stacks are counted in bytes on the ESP32
+            TaskHandle_t task = xTaskGetHandle(task_name);
+            return task ? (uint32_t)uxTaskGetStackHighWaterMark(task) : 0;
+        }
+
+        void waitForEvent(uint32_t timeout_ms) override
+        {
+            // A button is bouncing - come back once the debounce has settled so the press
+            // or release is not missed
+            if (input_settling)
+            {
+                input_settling = false;
+                if (timeout_ms > BUTTON_SETTLE_MS)
+                {
+                    timeout_ms = BUTTON_SETTLE_MS;
+                }
+            }
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+        }
+
+        void signalEvent() override
+        {
+            if (main_task)
+            {
+                xTaskNotifyGive(main_task);
+            }
+        }
+
     private:
         static void input_read_cb(lv_indev_t *indev_drv, lv_indev_data_t *data)
         {
@@ -364,7 +1029,11 @@ namespace hal
 
     // Static member definitions
     M5StackDisplayManager *M5StackDisplayManager::instance = nullptr;
-    lv_color_t M5StackSystemHAL::buf_1[M5StackSystemHAL::buf_size];
+    TaskHandle_t M5StackSystemHAL::main_task = nullptr;
+    volatile bool M5StackSystemHAL::input_settling = false;
+    RTC_DATA_ATTR M5StackNetworkManager::WiFiRtcCache M5StackNetworkManager::wifi_cache = {};
+    RTC_DATA_ATTR char M5StackSystemHAL::rtc_script_action_id[64] = {};
+    RTC_DATA_ATTR uint8_t M5StackSystemHAL::rtc_retained_buffer[RETAINED_BUFFER_SIZE] = {};
 
 } // namespace hal
 
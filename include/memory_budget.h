@@ -0,0 +1,67 @@
+#pragma once
+
+#include "hal_interfaces.h"
+#include <cstddef>
+#include <cstdint>
+
+// Memory budget: samples the internal heap, PSRAM, the LVGL pool (LV_MEM_SIZE) and the stack
+// high-water marks of our tasks, and keeps the lowest of each seen since boot. While the
+// internal heap's largest free block or the LVGL pool's falls below its reserve (config.h) the
+// device runs degraded - allocations that are only there to be quicker (prefetches, labels laid
+// out ahead, the picker rows) are shed and not made again, so memory the show needs is still
+// there. Degraded mode ends once both are a margin above their reserve.
+class MemoryBudget
+{
+public:
+    // Tasks whose stacks are watched, by FreeRTOS task name - those not running are skipped
+    static const size_t WATCHED_TASK_COUNT = 5;
+    static const char *const WATCHED_TASKS[WATCHED_TASK_COUNT];
+
+    struct Snapshot
+    {
+        hal::HeapStats heap;
+        uint32_t lvgl_total = 0;
+        uint32_t lvgl_used = 0;
+        uint32_t lvgl_peak = 0;          // Most ever in use
+        uint32_t lvgl_largest_free = 0;  // Largest block lv_malloc() can still hand out
+        uint8_t lvgl_frag_pct = 0;
+        uint32_t stack_free[WATCHED_TASK_COUNT] = {}; // Least left, in bytes - 0 for tasks not running
+    };
+
+private:
+    hal::ISystemHAL *system_hal;
+
+    Snapshot last;
+    uint32_t lowest_heap_block = UINT32_MAX; // Internal heap, since boot
+    uint32_t lowest_psram_block = UINT32_MAX;
+    uint32_t lowest_lvgl_block = UINT32_MAX;
+    bool stack_warned[WATCHED_TASK_COUNT] = {};
+    bool degraded = false;
+
+    unsigned long last_sample_time = 0;
+    unsigned long last_log_time = 0;
+    bool sampled = false;
+
+    static const uint32_t SAMPLE_INTERVAL_MS = 5000;
+    // Logged periodically as well, so fragmentation shows up as a shrinking largest free block
+    // long before an allocation fails
+    static const uint32_t LOG_INTERVAL_MS = 60000;
+    static const uint32_t RECOVERY_MARGIN_PCT = 50; // Above reserve by this much to leave degraded mode
+
+    void sample();
+    bool isLow(uint32_t margin_pct) const;
+    void logSnapshot(const char *when) const;
+
+public:
+    explicit MemoryBudget(hal::ISystemHAL *system);
+
+    // Sample when due - returns true when degraded mode was entered or left
+    bool update(unsigned long current_time);
+    uint32_t msUntilNextUpdate(unsigned long current_time) const;
+
+    bool isDegraded() const { return degraded; }
+    const Snapshot &getSnapshot() const { return last; }
+
+    // Sample now and log everything (startup, diagnostics)
+    void logStats(const char *when);
+};
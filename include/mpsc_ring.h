@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free multi-producer/single-consumer ring buffer. push() may be called from any
+// number of threads/tasks, pop() from one. Each slot carries a sequence number telling
+// producers and the consumer whose turn it is, so a producer preempted mid-write only holds
+// up the consumer at its own slot, never other producers.
+template <typename T, size_t Capacity>
+class MpscRing
+{
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    static constexpr uint32_t MASK = Capacity - 1;
+
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence;
+        T value;
+    };
+
+    Slot slots[Capacity];
+    std::atomic<uint32_t> tail{0}; // Next slot to claim - shared by the producers
+    uint32_t head = 0;             // Next slot to read - consumer only
+
+public:
+    MpscRing()
+    {
+        for (uint32_t i = 0; i < Capacity; ++i)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing &) = delete;
+    MpscRing &operator=(const MpscRing &) = delete;
+
+    // Producer side. Returns false, leaving value untouched, if the ring is full.
+    bool push(const T &value)
+    {
+        uint32_t position = tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot &slot = slots[position & MASK];
+            int32_t turn = (int32_t)(slot.sequence.load(std::memory_order_acquire) - position);
+            if (turn == 0)
+            {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.value = value;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (turn < 0)
+            {
+                return false; // The consumer has not freed this slot yet
+            }
+            else
+            {
+                position = tail.load(std::memory_order_relaxed); // Another producer claimed it
+            }
+        }
+    }
+
+    // Consumer side. Returns false if the next slot is empty or still being written.
+    bool pop(T &value)
+    {
+        Slot &slot = slots[head & MASK];
+        if ((int32_t)(slot.sequence.load(std::memory_order_acquire) - (head + 1)) < 0)
+        {
+            return false;
+        }
+        value = slot.value;
+        slot.sequence.store(head + Capacity, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+};
@@ -12,24 +12,23 @@
 #include <cstring>
 #include <ctime>
 #include <curl/curl.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 #include <string>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include "log.h"
+#include "config.h"
 
 namespace hal
 {
 
-    struct HttpResponse
-    {
-        std::string data;
-        long response_code;
-    };
-
-    static size_t WriteCallback(void *contents, size_t size, size_t nmemb, HttpResponse *response)
+    static size_t WriteCallback(void *contents, size_t size, size_t nmemb, std::string *response)
     {
         size_t total_size = size * nmemb;
-        response->data.append((char *)contents, total_size);
+        response->append((char *)contents, total_size);
         return total_size;
     }
 
@@ -39,14 +38,112 @@ namespace hal
         bool connected = false;
         std::string ip_address = "127.0.0.1";
 
+        // Persistent easy handle - libcurl keeps the keep-alive connection in its cache
+        CURL *curl = nullptr;
+        struct curl_slist *close_headers = nullptr;
+        bool keep_alive = HTTP_KEEP_ALIVE;
+        HttpStatsCounters stats;
+        int udp_socket = -1; // Push channel
+        std::string pending_url; // httpSend() - the easy handle cannot split a request from its response
+
+        bool ensureHandle()
+        {
+            if (curl)
+                return true;
+
+            curl = curl_easy_init();
+            if (!curl)
+                return false;
+
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+            curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+            curl_easy_setopt(curl, CURLOPT_MAXCONNECTS, 1L);
+            curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+
+            // Add user agent to identify requests
+            curl_easy_setopt(curl, CURLOPT_USERAGENT, "Reaper-M5-Remote/1.0");
+            return true;
+        }
+
+        void resetHandle()
+        {
+            if (curl)
+            {
+                curl_easy_cleanup(curl);
+                curl = nullptr;
+            }
+        }
+
+        // Perform one request on the persistent handle. Sets reused when an existing connection was used.
+        CURLcode performRequest(const char *url, std::string &response, int &status_code, bool fresh, bool &reused)
+        {
+            response.clear();
+            status_code = 0;
+            reused = false;
+
+            curl_easy_setopt(curl, CURLOPT_URL, url);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+
+            // Without keep-alive force fresh connections and close them straight away
+            bool no_reuse = fresh || !keep_alive;
+            curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, no_reuse ? 1L : 0L);
+            curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, keep_alive ? 0L : 1L);
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, keep_alive ? nullptr : close_headers);
+
+            CURLcode res = curl_easy_perform(curl);
+
+            long response_code = 0;
+            long num_connects = 0;
+            curl_off_t connect_us = 0;
+            curl_off_t ttfb_us = 0;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+            curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &num_connects);
+            curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect_us);
+            curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &ttfb_us);
+
+            reused = num_connects == 0;
+            uint32_t connect_ms = reused ? 0 : (uint32_t)(connect_us / 1000);
+            uint32_t start_ms = (uint32_t)(ttfb_us / 1000);
+            uint32_t ttfb_ms = start_ms > connect_ms ? start_ms - connect_ms : 0;
+
+            if (res == CURLE_OK)
+            {
+                status_code = response_code;
+            }
+            else
+            {
+                response.clear();
+            }
+
+            stats.recordRequest(res == CURLE_OK && status_code > 0, !reused, connect_ms, ttfb_ms);
+            return res;
+        }
+
+        // A stale keep-alive connection failed before the request was written
+        static bool failedBeforeSend(CURLcode res)
+        {
+            return res == CURLE_SEND_ERROR;
+        }
+
+        // The request went out but no response came back on the reused connection
+        static bool responseLost(CURLcode res)
+        {
+            return res == CURLE_GOT_NOTHING || res == CURLE_RECV_ERROR;
+        }
+
     public:
         NativeNetworkManager()
         {
             curl_global_init(CURL_GLOBAL_DEFAULT);
+            close_headers = curl_slist_append(close_headers, "Connection: close");
         }
 
         ~NativeNetworkManager()
         {
+            udpClose();
+            resetHandle();
+            curl_slist_free_all(close_headers);
             curl_global_cleanup();
         }
 
@@ -65,6 +162,7 @@ namespace hal
         bool disconnect() override
         {
             connected = false;
+            resetHandle(); // Drop the persistent connection with the link
             printf("WiFi disconnected\n");
             return true;
         }
@@ -79,55 +177,114 @@ namespace hal
             return ip_address.c_str();
         }
 
-        bool httpGetBlocking(const char *url, std::string &response, int &status_code) override
+        bool httpGetBlocking(const char *url, std::string &response, int &status_code, bool repeatable) override
         {
-            CURL *curl = curl_easy_init();
-            if (!curl)
+            if (!ensureHandle())
             {
                 status_code = 0;
                 response.clear();
                 return false;
             }
 
-            HttpResponse curl_response;
-            curl_easy_setopt(curl, CURLOPT_URL, url);
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &curl_response);
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-            curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+            bool reused = false;
+            CURLcode res = performRequest(url, response, status_code, false, reused);
 
-            // Force fresh connections to prevent connection pooling issues
-            curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, 1L);
-            curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+            // The server may have dropped an idle keep-alive connection - retry once on a new one.
+            // A lost response is only retried for requests that are safe to run twice.
+            if (res != CURLE_OK && reused && (failedBeforeSend(res) || (repeatable && responseLost(res))))
+            {
+                stats.recordReconnect();
+                res = performRequest(url, response, status_code, true, reused);
+            }
 
-            // Disable keep-alive to ensure connections are properly closed
-            struct curl_slist *headers = nullptr;
-            headers = curl_slist_append(headers, "Connection: close");
-            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+            return res == CURLE_OK && status_code > 0;
+        }
 
-            // Add user agent to identify requests
-            curl_easy_setopt(curl, CURLOPT_USERAGENT, "Reaper-M5-Remote/1.0");
+        // Not pipelined here: the request goes out when its response is collected, so a fan-out
+        // runs host after host on the simulator
+        bool httpSend(const char *url, int &status_code) override
+        {
+            pending_url = url;
+            status_code = 0;
+            return true;
+        }
 
-            CURLcode res = curl_easy_perform(curl);
-            if (res == CURLE_OK)
+        bool httpReceive(std::string &response, int &status_code) override
+        {
+            if (pending_url.empty())
             {
-                curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &curl_response.response_code);
-                response = curl_response.data;
-                status_code = curl_response.response_code;
+                status_code = 0;
+                response.clear();
+                return false;
             }
-            else
+            // Fanned out commands are never safe to run twice
+            bool ok = httpGetBlocking(pending_url.c_str(), response, status_code, false);
+            pending_url.clear();
+            return ok;
+        }
+
+        void setKeepAlive(bool enable) override
+        {
+            keep_alive = enable;
+        }
+
+        bool isKeepAliveEnabled() const override
+        {
+            return keep_alive;
+        }
+
+        HttpStats getHttpStats() const override
+        {
+            return stats.snapshot();
+        }
+
+        bool udpOpen(uint16_t port) override
+        {
+            if (udp_socket >= 0)
+                return true;
+
+            int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            if (sock < 0)
+                return false;
+
+            struct sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+            if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
             {
-                response.clear();
-                status_code = 0;
+                close(sock);
+                return false;
+            }
+            udp_socket = sock;
+            return true;
+        }
+
+        int udpReceive(char *buffer, size_t size, uint32_t timeout_ms) override
+        {
+            if (udp_socket < 0)
+                return -1;
+
+            struct timeval timeout;
+            timeout.tv_sec = timeout_ms / 1000;
+            timeout.tv_usec = (timeout_ms % 1000) * 1000;
+            setsockopt(udp_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            int length = recv(udp_socket, buffer, size, 0);
+            if (length < 0)
+            {
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
             }
+            return length;
+        }
 
-            // Clean up headers and curl handle
-            if (headers)
+        void udpClose() override
+        {
+            if (udp_socket >= 0)
             {
-                curl_slist_free_all(headers);
+                close(udp_socket);
+                udp_socket = -1;
             }
-            curl_easy_cleanup(curl);
-            return res == CURLE_OK && status_code > 0;
         }
     };
 
@@ -188,6 +345,7 @@ namespace hal
         SDL_Texture *texture = nullptr;
         uint8_t brightness = 100;
         bool display_on = true;
+        uint64_t pixels_flushed = 0;
 
         static const int SCREEN_WIDTH = 320;
         static const int SCREEN_HEIGHT = 240;
@@ -349,11 +507,17 @@ namespace hal
             }
         }
 
+        uint64_t getPixelsFlushed() const override
+        {
+            return pixels_flushed;
+        }
+
         static void lvgl_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
         {
             if (instance)
             {
                 instance->flush(area->x1, area->y1, area->x2, area->y2, (uint16_t *)px_map);
+                instance->pixels_flushed += (uint64_t)(area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1);
             }
             lv_display_flush_ready(disp);
         }
@@ -432,14 +596,20 @@ namespace hal
     {
     private:
         NativeNetworkManager network_mgr;
+#if HTTP_USER_WORKER
+        NativeNetworkManager user_network_mgr; // Own connection for button actions
+#endif
+        NativeNetworkManager backup_network_mgr; // REAPER_BACKUP_SERVER
         NativePowerManager power_mgr;
         NativeDisplayManager display_mgr;
         NativeInputManager input_mgr;
 
         std::chrono::steady_clock::time_point start_time;
+        std::string cached_script_action_id;
+        uint8_t retained_buffer[RETAINED_BUFFER_SIZE] = {};
 
         // Reduced buffer size for memory conservation
-        static const size_t buf_size = 320 * 10; // Much smaller buffer
+        static const size_t buf_size = 320 * DISPLAY_BUFFER_LINES;
         static lv_color_t buf_1[buf_size];
         static lv_color_t buf_2[buf_size];
         lv_display_t *display;
@@ -447,6 +617,12 @@ namespace hal
 
     public:
         INetworkManager &getNetworkManager() override { return network_mgr; }
+#if HTTP_USER_WORKER
+        INetworkManager &getUserNetworkManager() override { return user_network_mgr; }
+#else
+        INetworkManager &getUserNetworkManager() override { return network_mgr; }
+#endif
+        INetworkManager &getBackupNetworkManager() override { return backup_network_mgr; }
         IPowerManager &getPowerManager() override { return power_mgr; }
         IDisplayManager &getDisplayManager() override { return display_mgr; }
         IInputManager &getInputManager() override { return input_mgr; }
@@ -457,7 +633,6 @@ namespace hal
         {
             display_mgr.processSDLEvents();
             input_mgr.update();
-            lv_timer_handler();
         }
 
         uint32_t getMillis() const override
@@ -467,12 +642,58 @@ namespace hal
             return duration.count();
         }
 
+        uint32_t getMicros() const override
+        {
+            auto now = std::chrono::steady_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(now - start_time);
+            return (uint32_t)duration.count();
+        }
+
         void delay(uint32_t ms) override
         {
             std::this_thread::sleep_for(std::chrono::milliseconds(ms));
         }
 
+        HeapStats getHeapStats() const override
+        {
+            return HeapStats(); // Not tracked on the desktop build
+        }
+
+        uint32_t getStackHighWaterMark(const char *) const override { return 0; }
+
+        // The desktop build never sleeps, the cache only lasts for the process
+        bool wokeFromSleep() const override { return false; }
+        const char *getCachedScriptActionId() const override { return cached_script_action_id.c_str(); }
+        void cacheScriptActionId(const char *id) override { cached_script_action_id = id; }
+        uint8_t *getRetainedBuffer(size_t &capacity) override
+        {
+            capacity = sizeof(retained_buffer);
+            return retained_buffer;
+        }
+
+        void waitForEvent(uint32_t timeout_ms) override
+        {
+            // Returns early on any SDL event (keys, mouse, window, signalEvent). The event is
+            // left queued for processSDLEvents() in the next update().
+            if (timeout_ms > 0)
+            {
+                SDL_WaitEventTimeout(nullptr, timeout_ms > INT32_MAX ? INT32_MAX : (int)timeout_ms);
+            }
+        }
+
+        void signalEvent() override
+        {
+            SDL_Event event = {};
+            event.type = SDL_USEREVENT;
+            SDL_PushEvent(&event); // Thread-safe
+        }
+
     private:
+        static uint32_t tick_cb()
+        {
+            return SDL_GetTicks();
+        }
+
         static void input_read_cb(lv_indev_t *indev_drv, lv_indev_data_t *data)
         {
             NativeSystemHAL *hal = (NativeSystemHAL *)lv_indev_get_user_data(indev_drv);
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "config.h"
+#include "hal_interfaces.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Hot-path metrics (PERF_METRICS): each metric keeps its most recent samples in a fixed ring, so
+// recording is a couple of relaxed atomics from any thread and percentiles cover a recent
+// window. The trace point macros at the bottom compile to nothing when PERF_METRICS is 0.
+namespace perf
+{
+    enum class Metric
+    {
+        // HTTP round trip per job type, in the order of http::JobType (WiFi is the connect)
+        HTTP_WIFI_CONNECT,
+        HTTP_CHANGE_TAB,
+        HTTP_CHANGE_PLAYSTATE,
+        HTTP_GET_STATUS,
+        HTTP_GET_SCRIPT_ACTION_ID,
+        HTTP_GET_TRANSPORT,
+        HTTP_SUBSCRIBE,
+        PARSE_TABS,  // parseTabData
+        RENDER,      // lv_refr_now, render + flush of one frame
+        FLUSH_BYTES, // Bytes flushed to the display per frame
+        QUEUE_DEPTH, // Jobs queued, sampled on each submit
+        COUNT
+    };
+
+    // Metric for the job type, whose order HTTP_* follows
+    template <typename JobType>
+    constexpr Metric httpMetric(JobType type) { return static_cast<Metric>((size_t)Metric::HTTP_WIFI_CONNECT + (size_t)type); }
+
+    const char *metricName(Metric metric);
+
+    struct Summary
+    {
+        uint32_t count = 0; // Samples recorded in total, percentiles cover the last SampleRing::SIZE
+        uint32_t p50 = 0;
+        uint32_t p99 = 0;
+        uint32_t max = 0;
+    };
+
+    class SampleRing
+    {
+    public:
+        static constexpr size_t SIZE = 64;
+
+    private:
+        std::atomic<uint32_t> samples[SIZE] = {};
+        std::atomic<uint32_t> recorded{0};
+
+    public:
+        void record(uint32_t value)
+        {
+            uint32_t slot = recorded.fetch_add(1, std::memory_order_relaxed);
+            samples[slot % SIZE].store(value, std::memory_order_relaxed);
+        }
+
+        // Percentiles of the samples in the ring - a sample written meanwhile may or may not count
+        Summary summarize() const;
+    };
+
+    SampleRing &ring(Metric metric);
+    inline void record(Metric metric, uint32_t value) { ring(metric).record(value); }
+
+    uint32_t nowMicros();
+
+    // Records the time from construction to destruction in microseconds
+    class ScopedTimer
+    {
+    private:
+        Metric metric;
+        uint32_t start_us;
+
+    public:
+        explicit ScopedTimer(Metric timed_metric) : metric(timed_metric), start_us(nowMicros()) {}
+        ~ScopedTimer() { record(metric, nowMicros() - start_us); }
+    };
+
+    // Overlay text, one line per metric with samples plus the heap. Returns the length written.
+    size_t formatOverlay(char *buffer, size_t size, const hal::HeapStats &heap);
+
+    // Compact serial dump, one "key=value" line per metric with samples, for scraping the log
+    void dump(const hal::HeapStats &heap);
+
+} // namespace perf
+
+#if PERF_METRICS
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+// Time the rest of the enclosing scope
+#define PERF_SCOPE(metric) perf::ScopedTimer PERF_CONCAT(perf_scope_, __LINE__)(metric)
+#define PERF_RECORD(metric, value) perf::record(metric, (uint32_t)(value))
+#else
+#define PERF_SCOPE(metric) ((void)0)
+#define PERF_RECORD(metric, value) ((void)0)
+#endif
@@ -3,25 +3,55 @@
 #include "hal_interfaces.h"
 #include "ui_manager.h"
 #include "reaper_types.h"
+#include "transport_clock.h"
+
+class StateManager;
 
 class PowerManager
 {
 private:
     hal::ISystemHAL *system_hal;
     UIManager *ui_manager;
+    StateManager *state_manager = nullptr; // Snapshot taken before deep sleep
 
     // Sleep timing constants (in milliseconds)
     static const unsigned long LIGHT_SLEEP_TIMEOUT = 30000; // 30 seconds -> light sleep
     static const unsigned long DEEP_SLEEP_TIMEOUT = 90000;  // 90 seconds -> deep sleep
     static const unsigned long PLAY_SLEEP_DELAY = 5000;     // 5 seconds after play starts
     static const unsigned long WAKEUP_BEFORE_END = 15000;   // 15 seconds before song ends
+    static const unsigned long PLAY_SLEEP_GRACE = 10000;    // No play sleep within 10 seconds of a button press
+
+    // Play sleep is taken in segments of at most PLAY_CHECK_INTERVAL, each ending at a transport
+    // checkpoint. The sample taken after each wake re-plans the rest of the song, so seeks,
+    // repeat loops and tempo (play rate) changes are picked up. The last segment ends early
+    // enough that the wake-up poll has a connection before WAKEUP_BEFORE_END. The WiFi modem
+    // stays in power save (DTIM modem sleep) for the whole play sleep.
+    static const unsigned long PLAY_CHECK_INTERVAL = 60000;    // Longest segment between transport checks
+    static const unsigned long PLAY_SLEEP_MIN = 1000;          // Shorter segments are not worth sleeping
+    static const unsigned long PLAY_WAKE_LEAD_MIN = 500;       // Lower bound of the measured wake-to-sample time
+    static const unsigned long RATE_SAMPLE_MIN_INTERVAL = 5000; // Samples closer than this are too noisy for the play rate
 
     // State tracking
     unsigned long last_button_press_time = 0;
     unsigned long play_start_time = 0;
-    bool is_in_play_sleep = false;
+    bool is_in_play_sleep = false; // Woke from a play sleep segment, waiting for the checkpoint sample
     bool play_sleep_scheduled = false;
     bool is_in_light_sleep = false;
+    bool radio_power_save = false;
+    unsigned long play_wake_time = 0; // When the last play sleep segment ended
+    unsigned long wake_lead_ms = PLAY_WAKE_LEAD_MIN; // Averaged wake to first transport sample
+
+    // Battery drain per song (telemetry) - a song ends when the tab changes or playback stops
+    struct SongPowerStats
+    {
+        bool active = false;
+        unsigned int tab_index = 0;
+        unsigned long start_time = 0;
+        uint8_t start_battery = 0;
+        unsigned long asleep_ms = 0;
+        uint32_t sleep_segments = 0;
+    };
+    SongPowerStats song_stats;
 
     // External power status caching to reduce I2C calls
     bool cached_external_power_status = false;
@@ -30,11 +60,21 @@ private:
 
     // Song timing
     double current_song_length = 0.0;
-    double last_known_position = 0.0;
+    double last_known_position = 0.0;   // Anchor of the shared transport clock
+    unsigned long last_sample_time = 0; // When last_known_position was anchored
+    bool repeat_enabled = false;
+    double play_rate = 1.0; // Song seconds per wall clock second, measured across samples
+    double rate_sample_position = 0.0;
+    unsigned long rate_sample_time = 0; // 0 = no reference sample yet
 
     // Helper methods
     bool isOnExternalPower() const;
-    unsigned long calculateSleepDuration(double song_length, double current_position) const;
+    unsigned long calculateSleepDuration(unsigned long current_time) const;
+    double positionAt(unsigned long current_time) const; // Interpolated at the measured play rate
+    void enterPlaySleep(unsigned long current_time);
+    void setRadioPowerSave(bool enable);
+    void startSongStats(unsigned int tab_index, unsigned long current_time);
+    void endSongStats(unsigned long current_time);
     void enterLightSleep(unsigned long duration_ms);
     void enterDeepSleep(unsigned long duration_ms);
 
@@ -42,18 +82,25 @@ public:
     PowerManager(hal::ISystemHAL *hal, UIManager *ui);
     ~PowerManager() = default;
 
+    void setStateManager(StateManager *state) { state_manager = state; }
+
     // Called when any button is pressed
     void onButtonPress();
 
     // Called when UI state changes
     void onUIStateChange(UIState new_state, UIState old_state);
 
-    // Called when transport state updates (for song position tracking)
-    void onTransportUpdate(const reaper::TransportState &transport_state, const reaper::ReaperState &reaper_state);
+    // Called every loop with the current transport state (for song position tracking). The
+    // position comes from the clock the display runs on, re-read whenever it is re-anchored.
+    void onTransportUpdate(const reaper::TransportState &transport_state, const reaper::ReaperState &reaper_state,
+                           const TransportClock &clock);
 
     // Main update loop - checks for sleep conditions
     void update(unsigned long current_time);
 
+    // Milliseconds until update() next has a sleep transition to make
+    uint32_t msUntilNextUpdate(unsigned long current_time) const;
+
     // Query methods
     bool shouldEnterSleep() const;
     unsigned long getTimeSinceLastButtonPress(unsigned long current_time) const;
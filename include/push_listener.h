@@ -0,0 +1,80 @@
+#pragma once
+
+#include "hal_interfaces.h"
+#include "http_jobs.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <string_view>
+#include <cstdint>
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+namespace http
+{
+    // Receives state pushed by the ReaperSetlist script over UDP, so changes made in REAPER show
+    // up without waiting for the next poll. The script sends to the target registered by
+    // SubscribeJob, once per change plus a heartbeat every few seconds.
+    //
+    // Each datagram holds one or more lines in the web interface batch response format:
+    //   TRANSPORT\t<playstate>\t<position_seconds>\t<repeat>\t<position_bars_beats>...
+    //   EXTSTATE\tReaperSetlist\tactiveIndex\t<index>
+    //   TABS (or an EXTSTATE ReaperSetlist tabs line) - the setlist changed and must be fetched
+    class PushListener
+    {
+    private:
+        static const size_t RESULT_QUEUE_SIZE = 8;
+        static const size_t DATAGRAM_SIZE = 512;
+        static const uint32_t RECEIVE_TIMEOUT_MS = 500; // Bounds how long shutdown waits for the listener
+        static const uint32_t OPEN_RETRY_MS = 5000;
+        static const uint32_t ACTIVE_TIMEOUT_MS = 15000; // Push is considered lost after this much silence
+
+        hal::ISystemHAL *system_hal;
+        uint16_t port;
+
+        // The listener is the only producer, the main loop the only consumer
+        SpscRing<HttpJobResult, RESULT_QUEUE_SIZE> result_queue;
+        char datagram[DATAGRAM_SIZE];
+
+        std::atomic<bool> should_stop{false};
+        std::atomic<bool> have_message{false};
+        std::atomic<uint32_t> last_message_time{0};
+        std::atomic<uint32_t> messages_received{0};
+
+#ifdef ARDUINO
+        TaskHandle_t listener_task_handle = nullptr;
+        static void listenerTaskWrapper(void *parameter);
+#else
+        std::thread listener_thread;
+#endif
+
+        void run();
+        // Fills result with a PushUpdateResult, returns false if nothing in the datagram was recognised
+        bool parseDatagram(std::string_view data, HttpJobResult &result) const;
+
+    public:
+        PushListener(hal::ISystemHAL *system, uint16_t push_port);
+        ~PushListener();
+
+        PushListener(const PushListener &) = delete;
+        PushListener &operator=(const PushListener &) = delete;
+
+        // Pops one pushed update (call from main thread). Never blocks or allocates.
+        bool nextResult(HttpJobResult &result) { return result_queue.pop(result); }
+
+        // True while REAPER is pushing - polls can back off
+        bool isActive(uint32_t current_time) const
+        {
+            // Signed difference - a datagram may land after the caller read current_time
+            return have_message.load() && (int32_t)(current_time - last_message_time.load()) < (int32_t)ACTIVE_TIMEOUT_MS;
+        }
+
+        uint16_t getPort() const { return port; }
+        uint32_t getMessagesReceived() const { return messages_received.load(std::memory_order_relaxed); }
+    };
+
+} // namespace http
@@ -1,7 +1,10 @@
 #pragma once
 
-#include <string>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
 
 namespace reaper
 {
@@ -11,33 +14,83 @@ namespace reaper
         int play_state;                  // 0=stopped, 1=playing, 2=paused, 5=recording, 6=record paused
         double position_seconds;         // Position in seconds
         bool repeat_enabled;             // Repeat on/off
-        std::string position_bars_beats; // Position as bars.beats string
+        char position_bars_beats[16];    // Position as bars.beats string (truncated if longer)
         bool success;                    // Whether parsing succeeded
 
         TransportState()
-            : play_state(0), position_seconds(0.0), repeat_enabled(false), success(false)
+            : play_state(0), position_seconds(0.0), repeat_enabled(false), position_bars_beats(), success(false)
         {
         }
     };
 
-    // Structure for individual tab information
+    // Structure for individual tab information - POD, the name lives in the owning Setlist's arena
     struct TabInfo
     {
-        float length;       // Length in seconds
-        std::string name;   // Filename without .rpp/.RPP extension
-        unsigned int index; // Array index
+        float length;         // Length in seconds
+        unsigned int index;   // Array index
+        uint16_t name_offset; // Start of the NUL-terminated name in the arena
+        uint16_t name_length;
+    };
+
+    // Parsed setlist in a single fixed-size block: a tab record array plus one arena holding every
+    // name back to back. Filled once per setlist change and handed on by pointer, so neither the
+    // job results nor the state manager copy or reallocate it.
+    class Setlist
+    {
+    public:
+        static const size_t MAX_TABS = 64;
+        static const size_t NAME_ARENA_SIZE = 2048;
+
+    private:
+        TabInfo tabs[MAX_TABS];
+        char names[NAME_ARENA_SIZE];
+        size_t tab_count = 0;
+        size_t names_used = 0;
+
+    public:
+        // Append a tab - false (and nothing added) when the records or the arena are full
+        bool add(float length, unsigned int index, std::string_view name)
+        {
+            if (tab_count >= MAX_TABS || name.size() + 1 > NAME_ARENA_SIZE - names_used)
+            {
+                return false;
+            }
+
+            TabInfo &tab = tabs[tab_count++];
+            tab.length = length;
+            tab.index = index;
+            tab.name_offset = (uint16_t)names_used;
+            tab.name_length = (uint16_t)name.size();
+            memcpy(names + names_used, name.data(), name.size());
+            names[names_used + name.size()] = '\0';
+            names_used += name.size() + 1;
+            return true;
+        }
 
-        TabInfo() : length(0.0f), index(0) {}
+        size_t size() const { return tab_count; }
+        bool empty() const { return tab_count == 0; }
+        size_t arenaUsed() const { return names_used; }
+
+        const TabInfo &operator[](size_t i) const { return tabs[i]; }
+        const char *name(size_t i) const { return names + tabs[i].name_offset; }
+        std::string_view nameView(size_t i) const { return std::string_view(name(i), tabs[i].name_length); }
     };
 
-    // Structure for Reaper setlist state
+    // Structure for Reaper setlist state. Move-only: the setlist is transferred, never copied.
     struct ReaperState
     {
-        std::vector<TabInfo> tabs;
+        std::unique_ptr<Setlist> tabs; // Null until a setlist has been parsed
         unsigned int active_index;
+        uint32_t tabs_digest; // Digest of the raw tabs payload the tabs were parsed from (0 = unknown)
         bool success;
 
-        ReaperState() : active_index(0), success(false) {}
+        ReaperState() : active_index(0), tabs_digest(0), success(false) {}
+
+        size_t tabCount() const { return tabs ? tabs->size() : 0; }
+        bool hasActiveTab() const { return active_index < tabCount(); }
+        // Only valid when hasActiveTab()
+        const TabInfo &activeTab() const { return (*tabs)[active_index]; }
+        const char *activeTabName() const { return tabs->name(active_index); }
     };
 
 } // namespace reaper
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "reaper_types.h"
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace http
+{
+    // Allocation-free helpers for Reaper web interface responses.
+    // Everything works on std::string_view slices of the response buffer, so the
+    // buffer must outlive any token taken from it.
+    namespace parser
+    {
+        // Iterates the non-empty tokens of a buffer separated by a delimiter.
+        // Trailing '\r'/'\n' are trimmed from each token and empty tokens are skipped.
+        class Tokenizer
+        {
+        private:
+            std::string_view remaining;
+            char delimiter;
+
+        public:
+            Tokenizer(std::string_view input, char delim) : remaining(input), delimiter(delim) {}
+
+            bool next(std::string_view &token);
+        };
+
+        // Split into at most max_tokens non-empty tokens, returns the number found
+        size_t split(std::string_view input, char delimiter, std::string_view *tokens, size_t max_tokens);
+
+        // Newline-separated batch response lines / tab-separated fields of one line
+        inline size_t splitLines(std::string_view response, std::string_view *lines, size_t max_lines)
+        {
+            return split(response, '\n', lines, max_lines);
+        }
+
+        inline size_t splitFields(std::string_view line, std::string_view *fields, size_t max_fields)
+        {
+            return split(line, '\t', fields, max_fields);
+        }
+
+        // Numeric parsing without copies or locale lookups. The whole token must be consumed.
+        bool parseInt(std::string_view token, int &value);
+        bool parseUnsigned(std::string_view token, unsigned int &value);
+        bool parseDecimal(std::string_view token, double &value); // [-]digits[.digits]
+
+        // Match "EXTSTATE\t<section>\t<key>\t<value>" and return the value slice
+        bool parseExtStateValue(std::string_view line, std::string_view section, std::string_view key, std::string_view &value);
+
+        // Cheap FNV-1a digest of a payload, used to detect unchanged ExtState values
+        uint32_t digest(std::string_view data);
+
+        // Compact setlist payload, written to the tabs ExtState by ReaperSetlist in place of the
+        // JSON array when the device asks for it (tabsFormat = compact1):
+        //   S1:<count>:<table_length>:<string table><length_ms>,<name_offset>,<name_length>;...
+        // The string table holds every name back to back with the project extension already
+        // stripped; each of the <count> records points into it. A record's position is its index.
+        inline bool isCompactSetlist(std::string_view payload) { return !payload.empty() && payload[0] == 'S'; }
+
+        // Fill a setlist from a compact payload in one pass. Stops quietly once the setlist is
+        // full; false if the payload is malformed (the setlist then holds what came before).
+        bool parseCompactSetlist(std::string_view payload, reaper::Setlist &setlist);
+
+        // Parse "TRANSPORT\t<playstate>\t<position_seconds>\t<repeat>\t<position_bars_beats>\t..."
+        bool parseTransportLine(std::string_view line, reaper::TransportState &transport_state);
+
+    } // namespace parser
+
+} // namespace http
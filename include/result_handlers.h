@@ -0,0 +1,29 @@
+#pragma once
+
+#include "hal_interfaces.h"
+#include "http_jobs.h"
+
+class UIManager;
+class ButtonHandler;
+class StateManager;
+namespace http
+{
+    class HttpJobManager;
+}
+
+// What the HTTP result handlers act on - the application's components, or a benchmark's
+struct AppComponents
+{
+    hal::ISystemHAL *system = nullptr;
+    UIManager *ui = nullptr;
+    ButtonHandler *button_handler = nullptr;
+    StateManager *state_manager = nullptr;
+    http::HttpJobManager *http_manager = nullptr;
+};
+
+// Register the handler for every result type on the dispatcher. The components must outlive
+// the dispatcher's use; registering again replaces them and restarts the startup timing.
+void registerResultHandlers(http::ResultDispatcher &results, const AppComponents &components);
+
+// Log boot (or wake) to first transport state once it arrived - call once per loop
+void checkStartupTiming(uint32_t current_time);
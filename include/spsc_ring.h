@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#ifdef NATIVE_BUILD
+#define SPSC_CACHE_LINE 64 // Keep producer and consumer indices on separate cache lines
+#else
+#define SPSC_CACHE_LINE 4 // ESP32 has no data cache coherency traffic to avoid
+#endif
+
+// Bounded lock-free single-producer/single-consumer ring buffer.
+// push() may only be called from one thread/task and pop() from one other thread/task.
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    std::array<T, Capacity> slots;
+    alignas(SPSC_CACHE_LINE) std::atomic<size_t> head{0}; // Next slot to read - written by the consumer only
+    alignas(SPSC_CACHE_LINE) std::atomic<size_t> tail{0}; // Next slot to write - written by the producer only
+
+public:
+    // Producer side. On failure (ring full) value is left untouched.
+    bool push(T &&value)
+    {
+        size_t current_tail = tail.load(std::memory_order_relaxed);
+        if (current_tail - head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+
+        slots[current_tail & MASK] = std::move(value);
+        tail.store(current_tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Never blocks or allocates.
+    bool pop(T &value)
+    {
+        size_t current_head = head.load(std::memory_order_relaxed);
+        if (current_head == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        value = std::move(slots[current_head & MASK]);
+        head.store(current_head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    // Approximate when called from a third thread
+    size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+};
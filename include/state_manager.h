@@ -2,6 +2,8 @@
 
 #include "reaper_types.h"
 #include "ui_manager.h"
+#include "latency_histogram.h"
+#include "transport_clock.h"
 
 // Forward declaration to avoid circular dependency
 namespace http
@@ -31,9 +33,44 @@ private:
     // UI state tracking
     int last_reaper_play_state = 0;
 
+    // Transport prediction - while playing, position is extrapolated from the last sample so
+    // polls only need to catch drift, seeks and play state changes. The poll interval doubles
+    // each time a sample confirms the prediction.
+    static const unsigned long TRANSPORT_POLL_MIN_MS = 1000;
+    static const unsigned long TRANSPORT_POLL_MAX_MS = 8000;
+    static const unsigned long SONG_END_WINDOW_MS = 10000;  // Poll at the minimum interval this close to the end
+    static constexpr double DRIFT_TOLERANCE_SECONDS = 0.25; // Prediction error that counts as drift
+    static const unsigned long PUSH_FALLBACK_POLL_MS = 30000; // Poll interval while REAPER pushes updates
+    TransportClock transport_clock;
+    unsigned long transport_poll_interval = TRANSPORT_POLL_MIN_MS;
+    uint32_t predictions_confirmed = 0;
+    uint32_t drift_corrections = 0;
+
+    // Optimistic button actions (OPTIMISTIC_UPDATES) - applied locally the moment the button is
+    // pressed, then reconciled against the result of the job they were submitted as. Results of
+    // other jobs do not overwrite the predicted field while an action is pending.
+    struct PendingAction
+    {
+        uint32_t job_id = 0; // 0 = nothing pending
+        unsigned long press_time = 0;
+    };
+    static const unsigned long OPTIMISTIC_TIMEOUT_MS = 5000; // Roll back if no result arrives
+    PendingAction pending_tab;
+    PendingAction pending_play;
+    unsigned int rollback_active_index = 0;
+    int rollback_play_state = 0;
+    unsigned long last_press_time = 0;
+    bool press_awaiting_render = false;
+    uint32_t optimistic_confirmed = 0;
+    uint32_t optimistic_rolled_back = 0;
+    LatencyHistogram press_to_render;
+    LatencyHistogram press_to_confirm;
+
+    void rollBack(const char *what, unsigned long current_time);
+
     // Helper methods
-    unsigned long getReaperStateInterval() const;
-    unsigned long getTransportInterval() const;
+    unsigned long getReaperStateInterval(unsigned long current_time) const;
+    unsigned long getTransportInterval(unsigned long current_time) const;
 
 public:
     StateManager(http::HttpJobManager *http_manager, UIManager *ui);
@@ -43,13 +80,47 @@ public:
     void update(unsigned long current_time);
     void periodicDebugLog(unsigned long current_time);
 
+    // Milliseconds until update() next has a poll to submit
+    uint32_t msUntilNextUpdate(unsigned long current_time) const;
+
     // State accessors
     const reaper::ReaperState &getReaperState() const { return current_reaper_state; }
     const reaper::TransportState &getTransportState() const { return current_transport_state; }
+    const TransportClock &getTransportClock() const { return transport_clock; }
 
     // State mutators for HTTP job results
-    void updateReaperState(const reaper::ReaperState &state) { current_reaper_state = state; }
-    void updateTransportState(const reaper::TransportState &state) { current_transport_state = state; }
+    void updateReaperState(reaper::ReaperState &&state, bool tabs_unchanged);
+    void updateTransportState(const reaper::TransportState &state, unsigned long sample_time);
+    void setActiveIndex(unsigned int index);
+
+    // Optimistic updates - apply the expected outcome of a button action submitted as job_id
+    // (0 if the submit failed, in which case nothing is applied)
+    void applyTabChange(int steps, uint32_t job_id, unsigned long press_time);
+    void applyPlayState(int play_state, uint32_t job_id, unsigned long press_time);
+
+    // Authoritative results of tab / playstate jobs. Returns false if the optimistic state was
+    // wrong and had to be rolled back.
+    bool confirmTabChange(uint32_t job_id, reaper::ReaperState &&state, bool tabs_unchanged, unsigned long current_time);
+    bool confirmPlayState(uint32_t job_id, const reaper::TransportState &state, unsigned long current_time);
+    bool isPlayStatePending() const { return pending_play.job_id != 0; }
+
+    // Warm resume - what the screen shows is written to the HAL's retained buffer before deep
+    // sleep and restored on wake, so the first frame shows the last known setlist while the polls
+    // refresh it. sleep_ms carries a playing position across the sleep (0 if unknown).
+    void saveSnapshot(hal::ISystemHAL &system, UIState ui_state, unsigned long sleep_ms) const;
+    bool restoreSnapshot(hal::ISystemHAL &system, UIState &ui_state);
+
+    // Called after a frame was drawn, closes the press-to-render measurement
+    void onFrameRendered(unsigned long current_time);
+    const LatencyHistogram &getPressToRender() const { return press_to_render; }
+    const LatencyHistogram &getPressToConfirm() const { return press_to_confirm; }
+
+    // Transport position to show at current_time - extrapolated from the last sample and eased
+    // onto each new one (the sampled position when not playing)
+    double getPredictedPosition(unsigned long current_time) const;
+
+    // A button was pressed - poll at the minimum interval until the prediction is confirmed again
+    void onUserInput() { transport_poll_interval = TRANSPORT_POLL_MIN_MS; }
 
     // Status flag control
     void setHaveReaperState(bool have) { have_reaper_state = have; }
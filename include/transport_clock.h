@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include "reaper_types.h"
+
+// Transport position between polls. Anchored on each sample from REAPER (position, time, play
+// state) and extrapolated in real time while the transport advances. A sample that disagrees
+// with the extrapolation by no more than SLEW_LIMIT_SECONDS is eased in over SLEW_MS rather
+// than jumped to, so the shown clock never skips or runs backwards over ordinary drift. Larger
+// differences are seeks and are taken at once.
+class TransportClock
+{
+public:
+    static constexpr double SLEW_LIMIT_SECONDS = 0.5;
+    static const uint32_t SLEW_MS = 2000;
+
+private:
+    double anchor_position = 0.0; // Sampled position - the true line the display converges on
+    unsigned long anchor_time = 0;
+    double residual = 0.0; // Shown minus true at anchor_time, wound down to 0 over SLEW_MS
+    bool advancing = false;
+    int play_state = 0;
+
+public:
+    // Play states in which the transport position advances in real time
+    static bool isAdvancing(const reaper::TransportState &state)
+    {
+        return state.success && (state.play_state == 1 || state.play_state == 5);
+    }
+
+    // Anchor on a new sample. Pass slew = false for positions that are not a measurement of the
+    // same playback (a press applied optimistically, a restored snapshot).
+    void anchor(const reaper::TransportState &state, unsigned long sample_time, bool slew = true)
+    {
+        bool keeps_advancing = advancing && isAdvancing(state) && state.play_state == play_state;
+        double shown = position(sample_time);
+        double difference = shown - state.position_seconds;
+        residual = slew && keeps_advancing && difference <= SLEW_LIMIT_SECONDS && difference >= -SLEW_LIMIT_SECONDS
+                       ? difference
+                       : 0.0;
+        anchor_position = state.position_seconds;
+        anchor_time = sample_time;
+        advancing = isAdvancing(state);
+        play_state = state.play_state;
+    }
+
+    // Where the transport is by the last sample, without easing - for drift checks and sleep planning
+    double predictedPosition(unsigned long current_time) const
+    {
+        return advancing ? anchor_position + (current_time - anchor_time) / 1000.0 : anchor_position;
+    }
+
+    // Position to show at current_time
+    double position(unsigned long current_time) const
+    {
+        double position = predictedPosition(current_time);
+        unsigned long elapsed = current_time - anchor_time;
+        if (residual != 0.0 && elapsed < SLEW_MS)
+        {
+            position += residual * (1.0 - (double)elapsed / SLEW_MS);
+        }
+        return position;
+    }
+
+    // Milliseconds until the shown position reaches its next whole second (UINT32_MAX when still)
+    uint32_t msUntilNextSecond(unsigned long current_time) const
+    {
+        if (!advancing)
+        {
+            return UINT32_MAX;
+        }
+        double shown = position(current_time);
+        double fraction = shown - (double)(int64_t)shown;
+        uint32_t due = (uint32_t)((1.0 - fraction) * 1000.0) + 1;
+        // Easing runs the clock a little slow or fast, never by more than a quarter
+        return residual != 0.0 && current_time - anchor_time < SLEW_MS ? due * 3 / 4 + 1 : due;
+    }
+
+    double anchorPosition() const { return anchor_position; }
+    unsigned long anchorTime() const { return anchor_time; }
+    bool isAdvancing() const { return advancing; }
+};
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <lvgl.h>
+#include <climits>
 #include <string>
+#include "config.h"
 #include "hal_interfaces.h"
 #include "reaper_types.h"
 
@@ -10,7 +12,8 @@ enum class UIState
     DISCONNECTED,
     STOPPED,
     PLAYING,
-    ARE_YOU_SURE
+    ARE_YOU_SURE,
+    TAB_PICKER // Setlist picker, jumps straight to the chosen tab
 };
 
 class UIManager
@@ -29,18 +32,73 @@ private:
     lv_obj_t *battery_percentage_label = nullptr;
     lv_obj_t *tab_info_label = nullptr;
     lv_obj_t *play_icon_label = nullptr;
-    lv_obj_t *tab_name_label = nullptr;
+    lv_obj_t *play_row = nullptr;
+    lv_obj_t *tab_name_label = nullptr; // The shown tab slot's label
     lv_obj_t *time_label = nullptr;
     lv_obj_t *are_you_sure_label = nullptr;
     lv_obj_t *btn1_label = nullptr;
     lv_obj_t *btn2_label = nullptr;
     lv_obj_t *btn3_label = nullptr;
 
+    // Tab names: the shown one plus the previous and next tabs laid out ahead of time in hidden
+    // labels, so stepping through the setlist only swaps which label is visible
+    struct TabSlot
+    {
+        lv_obj_t *label = nullptr;
+        unsigned int index = UINT_MAX; // Tab laid out in the label, UINT_MAX for none
+        float length = 0;
+        char length_text[12] = ""; // Formatted length for the time label
+    };
+    static const size_t TAB_SLOT_COUNT = 3;
+    TabSlot tab_slots[TAB_SLOT_COUNT];
+    size_t shown_tab_slot = 0;
+
+    // What the time label shows, so it is only formatted when the second changes
+    int time_label_seconds = -2; // -1 for the placeholder, -2 before the first update
+    float time_label_length = -2.0f;
+
+    // Setlist picker (TAB_PICKER): a fixed window of rows standing in for the transport rows,
+    // relabelled as the selection scrolls through the setlist, so a long setlist needs no more of
+    // the LVGL pool than a short one. Rows are created the first time the picker opens and kept.
+    static const unsigned int TAB_PICKER_ROWS = 8;
+    lv_obj_t *tab_picker = nullptr;
+    lv_obj_t *tab_picker_rows[TAB_PICKER_ROWS] = {};
+    unsigned int tab_picker_row_count = 0; // Rows created (fewer than TAB_PICKER_ROWS when the pool ran low)
+    unsigned int tab_picker_tab_count = 0; // Tabs in the setlist being picked from
+    unsigned int tab_picker_first = 0;     // Tab shown in the top row
+    unsigned int tab_picker_selection = 0;
+    unsigned long tab_picker_input_time = 0;
+    static constexpr unsigned long TAB_PICKER_TIMEOUT_MS = 10000; // Closes untouched after this
+
+    // Render tracking - set when LVGL reports an invalidated area, cleared once it is drawn
+    bool render_pending = true;
+    uint32_t frames_rendered = 0;
+    uint32_t frames_skipped = 0;
+    uint32_t last_frame_us = 0; // Render + flush time of refreshed frames
+    uint32_t max_frame_us = 0;
+    uint64_t total_frame_us = 0;
+    static const uint32_t ANIMATION_FRAME_MS = 1000 / 60; // LVGL service rate while animations run
+
     // State tracking
     UIState current_ui_state = UIState::DISCONNECTED;
     unsigned long last_battery_update = 0;
+    static const unsigned long BATTERY_UPDATE_INTERVAL = 30000;
+    unsigned long rollback_hint_time = 0; // Tab name is tinted while a rollback hint shows
+    bool rollback_hint_shown = false;
+    static const unsigned long ROLLBACK_HINT_MS = 600;
     bool wifi_connected = false;
     bool reaper_connected = false;
+    bool showing_restored_state = false; // Main UI shown from a snapshot until the connection is back
+    bool memory_degraded = false;        // Low memory: no neighbouring tab labels, no picker
+
+#if PERF_METRICS
+    // Metrics overlay on the top layer, created the first time it is shown
+    lv_obj_t *perf_overlay_label = nullptr;
+    bool perf_overlay_shown = false;
+    unsigned long last_perf_overlay_update = 0;
+    static const unsigned long PERF_OVERLAY_INTERVAL = 1000;
+    void updatePerfOverlay(unsigned long current_time);
+#endif
 
     // System references
     hal::ISystemHAL *system_hal;
@@ -54,6 +112,23 @@ private:
     void createTabInfoSection(lv_obj_t *parent);
     void createTransportSection(lv_obj_t *parent);
     void createButtonSection(lv_obj_t *parent);
+    void createTabPicker(lv_obj_t *parent);
+    bool createTabPickerRows();
+    void fillTabPicker(const reaper::ReaperState &state);
+
+    // Tab slots: lay a tab out in a slot (no-op if it already holds it), show the active tab
+    // and prepare its neighbours, or show a message in place of a tab
+    void prepareTabSlot(TabSlot &slot, const reaper::ReaperState &state, unsigned int index);
+    void showActiveTab(const reaper::ReaperState &state);
+    void showTabMessage(const char *text);
+
+    // Retained-state setters: widgets keep the last value rendered, so only a real change
+    // reaches LVGL and invalidates anything
+    void setLabelText(lv_obj_t *label, const char *text);
+    void setTextColor(lv_obj_t *obj, lv_color_t color);
+    void setHidden(lv_obj_t *obj, bool hidden);
+
+    static void onDisplayEvent(lv_event_t *e);
 
 public:
     UIManager(hal::ISystemHAL *hal);
@@ -67,17 +142,56 @@ public:
     void updateWiFiUI();
     void updateWiFiUI(const bool connected);
     void updateReaperStateUI(const reaper::ReaperState &state);
-    void updateTransportUI(const reaper::TransportState &state, const reaper::ReaperState &reaper_state);
+    // position_seconds is the displayed position, normally extrapolated from the last sample
+    void updateTransportUI(const reaper::TransportState &state, const reaper::ReaperState &reaper_state, double position_seconds);
     void updateButtonLabelsUI();
 
     // Connection state management
     void updateConnectionState(bool wifi_connected, bool reaper_connected);
-    void showConnectionStatus(const std::string &message);
+    void showConnectionStatus(const char *message);
     void showMainUI();
 
+    // Show the main UI with state restored after deep sleep instead of the connection status,
+    // until WiFi and REAPER are reachable again or the WiFi connection fails
+    void showRestoredState();
+    void clearRestoredState();
+
     // Periodic updates
     void updatePeriodicUI(unsigned long current_time);
 
+    // Redraw only when something was invalidated since the last refresh (call once per loop).
+    // LVGL timers are only serviced while an animation is running. Returns true if a frame was drawn.
+    bool refreshIfDirty();
+
+#if PERF_METRICS
+    // Show or hide the metrics overlay (p50/p99 of the perf metrics, heap)
+    void togglePerfOverlay(unsigned long current_time);
+#endif
+
+    // Setlist picker: open it (TAB_PICKER state) on the active tab - false without a setlist.
+    // Moving wraps around, the selection is the tab index to jump to.
+    bool openTabPicker(const reaper::ReaperState &state, unsigned long current_time);
+    void moveTabPicker(const reaper::ReaperState &state, int steps, unsigned long current_time);
+    unsigned int getTabPickerSelection() const { return tab_picker_selection; }
+
+    // Briefly tint the tab name after an optimistic update was corrected
+    void showRollbackHint(unsigned long current_time);
+
+    // Low memory (MemoryBudget): hand the LVGL pool back from the neighbouring tab labels and the
+    // picker rows, and create neither until memory recovers
+    void setMemoryDegraded(bool degraded);
+
+    // Milliseconds until the UI next needs the main loop (periodic updates, animations)
+    uint32_t msUntilNextUpdate(unsigned long current_time) const;
+
+    // Render statistics
+    uint32_t getFramesRendered() const { return frames_rendered; }
+    uint32_t getFramesSkipped() const { return frames_skipped; }
+    uint64_t getPixelsFlushed() const;
+    uint32_t getLastFrameMicros() const { return last_frame_us; }
+    uint32_t getMaxFrameMicros() const { return max_frame_us; }
+    uint32_t getAverageFrameMicros() const { return frames_rendered ? (uint32_t)(total_frame_us / frames_rendered) : 0; }
+
     // State management
     UIState getCurrentUIState() const { return current_ui_state; }
     void setUIState(UIState state) { current_ui_state = state; }
@@ -0,0 +1,6 @@
+# PlatformIO passes -flto from build_flags to the compiler only. The link has to see it (and the
+# optimization level) too, or the LTO objects are linked without being optimized across files.
+Import("env")
+
+flags = [flag for flag in env.get("CCFLAGS", []) if isinstance(flag, str) and (flag == "-flto" or flag.startswith("-O"))]
+env.Append(LINKFLAGS=flags)
@@ -0,0 +1,82 @@
+#pragma once
+
+#ifdef NATIVE_BENCH
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace bench
+{
+    // Global allocation counter, incremented by the operator new override in bench_main.cpp
+    extern std::atomic<uint64_t> allocation_count;
+
+    struct Measurement
+    {
+        double ns_per_op;
+        double allocs_per_op;
+    };
+
+    // Run fn iterations times and measure wall time and heap allocations per call
+    template <typename Fn>
+    Measurement measure(uint32_t iterations, Fn &&fn)
+    {
+        uint64_t allocs_before = allocation_count.load();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            fn();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        uint64_t allocs = allocation_count.load() - allocs_before;
+
+        Measurement m;
+        m.ns_per_op = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations;
+        m.allocs_per_op = (double)allocs / iterations;
+        return m;
+    }
+
+    // Results go to stderr so they stay readable when application logging on stdout is discarded
+    inline void report(const char *suite, const char *name, const Measurement &m)
+    {
+        fprintf(stderr, "%-10s %-32s %10.1f ns/op %8.2f allocs/op\n", suite, name, m.ns_per_op, m.allocs_per_op);
+    }
+
+    inline uint64_t nowNs()
+    {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    }
+
+    // Print percentiles of a set of latency samples (sorts the samples in place)
+    inline void reportLatency(const char *suite, const char *name, std::vector<uint64_t> &samples_ns)
+    {
+        if (samples_ns.empty())
+            return;
+
+        std::sort(samples_ns.begin(), samples_ns.end());
+        auto percentile = [&](double p)
+        { return (double)samples_ns[(size_t)(p * (samples_ns.size() - 1))]; };
+        fprintf(stderr, "%-10s %-32s p50 %8.0f ns  p99 %8.0f ns  max %10.0f ns\n", suite, name,
+                percentile(0.50), percentile(0.99), (double)samples_ns.back());
+    }
+
+    // Keep the optimizer from discarding benchmarked work
+    template <typename T>
+    inline void doNotOptimize(const T &value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // Benchmark suites
+    void runParseBench();
+    void runQueueBench();
+    void runScenarioBench();
+    void runRenderBench();
+
+} // namespace bench
+
+#endif // NATIVE_BENCH
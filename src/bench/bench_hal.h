@@ -0,0 +1,310 @@
+#pragma once
+
+#ifdef NATIVE_BENCH
+
+#include "bench_reaper.h"
+#include "config.h"
+#include "hal_interfaces.h"
+#include <lvgl.h>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace bench
+{
+    // Headless HAL for benchmarks: no SDL, no sockets. HTTP requests are answered
+    // from canned responses so only the application code path is measured, or by a
+    // FakeReaper when a scenario needs REAPER to react to what the device sends.
+    class BenchNetworkManager : public hal::INetworkManager
+    {
+    private:
+        FakeReaper *server = nullptr;
+        std::string transport_response = "TRANSPORT\t1\t123.456789\t0\t62.3.00\t62.3.00\n";
+        std::string status_response =
+            "EXTSTATE\tReaperSetlist\ttabs\t[{\"length\":297,\"name\":\"Believer.RPP\",\"index\":0,\"dirty\":false}]\n"
+            "EXTSTATE\tReaperSetlist\tactiveIndex\t0\n"
+            "TRANSPORT\t1\t123.456789\t0\t62.3.00\t62.3.00\n";
+        std::chrono::microseconds latency{0};
+        hal::HttpStatsCounters stats;
+        std::future<std::pair<bool, int>> pending; // httpSend() in flight
+        std::string pending_response;
+
+    public:
+        // Simulated round trip per request, e.g. to model slow Wi-Fi
+        void setLatency(std::chrono::microseconds request_latency) { latency = request_latency; }
+        // Answer from a simulated REAPER instead of the canned responses (nullptr to go back)
+        void setServer(FakeReaper *reaper) { server = reaper; }
+
+        bool connect(const char *, const char *) override { return true; }
+        bool disconnect() override { return true; }
+        bool isConnected() const override { return true; }
+        const char *getIP() const override { return "127.0.0.1"; }
+
+        bool httpGetBlocking(const char *url, std::string &response, int &status_code, bool) override
+        {
+            if (server)
+            {
+                bool success = server->handle(url, response, status_code) && status_code == 200;
+                stats.recordRequest(success, false, 0, 0);
+                return success;
+            }
+            if (latency.count() > 0)
+            {
+                std::this_thread::sleep_for(latency);
+            }
+            // Batches that fetch the setlist get the tabs/activeIndex/transport lines
+            bool wants_status = std::string(url).find("ReaperSetlist/tabs") != std::string::npos;
+            response = wants_status ? status_response : transport_response;
+            status_code = 200;
+            stats.recordRequest(true, false, 0, 0);
+            return true;
+        }
+
+        // The request is answered on its own thread, as a server would while the worker sends on
+        bool httpSend(const char *url, int &status_code) override
+        {
+            std::string request_url = url;
+            pending = std::async(std::launch::async, [this, request_url]
+                                 {
+                int code = 0;
+                bool success = httpGetBlocking(request_url.c_str(), pending_response, code, false);
+                return std::make_pair(success, code); });
+            status_code = 0;
+            return true;
+        }
+
+        bool httpReceive(std::string &response, int &status_code) override
+        {
+            if (!pending.valid())
+            {
+                status_code = 0;
+                return false;
+            }
+            std::pair<bool, int> outcome = pending.get();
+            response.swap(pending_response);
+            status_code = outcome.second;
+            return outcome.first;
+        }
+
+        void setKeepAlive(bool) override {}
+        bool isKeepAliveEnabled() const override { return true; }
+        hal::HttpStats getHttpStats() const override { return stats.snapshot(); }
+        bool udpOpen(uint16_t) override { return false; }
+        int udpReceive(char *, size_t, uint32_t) override { return -1; }
+        void udpClose() override {}
+    };
+
+    class BenchPowerManager : public hal::IPowerManager
+    {
+    public:
+        uint8_t getBatteryPercentage() const override { return 100; }
+        bool isCharging() const override { return true; }
+        void deepSleep(uint32_t) override {}
+        void lightSleep(uint32_t) override {}
+        void restart() override {}
+        void setCpuFrequency(uint32_t) override {}
+        void enableWiFiPowerSave(bool) override {}
+        void powerOff() override {}
+    };
+
+    // Discards frames, counting the pixels LVGL flushed
+    class BenchDisplayManager : public hal::IDisplayManager
+    {
+    private:
+        uint64_t pixels_flushed = 0;
+        uint64_t flush_count = 0; // Strips handed over by LVGL
+
+    public:
+        void setBrightness(uint8_t) override {}
+        uint8_t getBrightness() const override { return 0; }
+        void turnOn() override {}
+        void turnOff() override {}
+        uint16_t getWidth() const override { return 320; }
+        uint16_t getHeight() const override { return 240; }
+        void *getFrameBuffer() override { return nullptr; }
+        void flush(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint16_t *) override
+        {
+            pixels_flushed += (uint64_t)(x2 - x1 + 1) * (y2 - y1 + 1);
+            flush_count++;
+        }
+        uint64_t getPixelsFlushed() const override { return pixels_flushed; }
+        uint64_t getFlushCount() const { return flush_count; }
+
+        static void lvglFlushCallback(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+        {
+            auto *display = static_cast<BenchDisplayManager *>(lv_display_get_user_data(disp));
+            display->flush(area->x1, area->y1, area->x2, area->y2, (const uint16_t *)px_map);
+            lv_display_flush_ready(disp);
+        }
+    };
+
+    // Buttons pressed by a scenario script - a press shows up as an edge for one update()
+    class BenchInputManager : public hal::IInputManager
+    {
+    private:
+        static const uint8_t BUTTON_COUNT = 3;
+        bool queued[BUTTON_COUNT] = {};
+        bool pressed[BUTTON_COUNT] = {};
+        bool held[BUTTON_COUNT] = {};
+
+    public:
+        void press(uint8_t button_id)
+        {
+            if (button_id < BUTTON_COUNT)
+                queued[button_id] = true;
+        }
+
+        // Press and keep the button down until released
+        void hold(uint8_t button_id, bool down)
+        {
+            if (button_id < BUTTON_COUNT)
+            {
+                queued[button_id] = queued[button_id] || down;
+                held[button_id] = down;
+            }
+        }
+
+        bool isButtonPressed(uint8_t button_id) const override
+        {
+            return button_id < BUTTON_COUNT && (pressed[button_id] || held[button_id]);
+        }
+        bool wasButtonPressed(uint8_t button_id) override { return button_id < BUTTON_COUNT && pressed[button_id]; }
+        bool wasButtonReleased(uint8_t) override { return false; }
+        bool getTouchPoint(int16_t *, int16_t *) override { return false; }
+        bool isTouched() const override { return false; }
+        void update() override
+        {
+            for (uint8_t i = 0; i < BUTTON_COUNT; ++i)
+            {
+                pressed[i] = queued[i];
+                queued[i] = false;
+            }
+        }
+
+        // A press that is not held comes up on the next update() - the release edge
+        bool releasePending() const
+        {
+            for (uint8_t i = 0; i < BUTTON_COUNT; ++i)
+            {
+                if (pressed[i] && !held[i])
+                    return true;
+            }
+            return false;
+        }
+    };
+
+    class BenchSystemHAL : public hal::ISystemHAL
+    {
+    private:
+        BenchNetworkManager network_mgr;
+        BenchNetworkManager user_network_mgr;
+        BenchNetworkManager backup_network_mgr;
+        BenchPowerManager power_mgr;
+        BenchDisplayManager display_mgr;
+        BenchInputManager input_mgr;
+        std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+        std::mutex event_mutex;
+        std::condition_variable event_cv;
+        bool event_pending = false;
+
+        // LVGL, only set up by init() - suites that do not render never touch it
+        lv_display_t *display = nullptr;
+        lv_color_t draw_buffer[320 * DISPLAY_BUFFER_LINES];
+
+        static uint32_t tickMs()
+        {
+            static const auto epoch = std::chrono::steady_clock::now();
+            return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+        }
+
+    public:
+        ~BenchSystemHAL()
+        {
+            if (display)
+            {
+                lv_deinit();
+            }
+        }
+
+        hal::INetworkManager &getNetworkManager() override { return network_mgr; }
+        hal::INetworkManager &getUserNetworkManager() override { return user_network_mgr; }
+        hal::INetworkManager &getBackupNetworkManager() override { return backup_network_mgr; }
+        hal::IPowerManager &getPowerManager() override { return power_mgr; }
+        hal::IDisplayManager &getDisplayManager() override { return display_mgr; }
+        hal::IInputManager &getInputManager() override { return input_mgr; }
+        BenchNetworkManager &getBenchNetworkManager() { return network_mgr; }
+        BenchNetworkManager &getBenchUserNetworkManager() { return user_network_mgr; }
+        BenchNetworkManager &getBenchBackupNetworkManager() { return backup_network_mgr; }
+        BenchInputManager &getBenchInputManager() { return input_mgr; }
+        BenchDisplayManager &getBenchDisplayManager() { return display_mgr; }
+
+        // Headless LVGL: a 320x240 display rendering into one partial buffer that is then discarded
+        void init() override
+        {
+            lv_init();
+            lv_tick_set_cb(tickMs);
+            display = lv_display_create(display_mgr.getWidth(), display_mgr.getHeight());
+            lv_display_set_user_data(display, &display_mgr);
+            lv_display_set_flush_cb(display, BenchDisplayManager::lvglFlushCallback);
+            lv_display_set_buffers(display, draw_buffer, nullptr, sizeof(draw_buffer), LV_DISPLAY_RENDER_MODE_PARTIAL);
+        }
+
+        void update() override
+        {
+            input_mgr.update();
+            // The release wakes the loop, as the button interrupt does on the device
+            if (input_mgr.releasePending())
+            {
+                signalEvent();
+            }
+        }
+
+        uint32_t getMillis() const override
+        {
+            auto elapsed = std::chrono::steady_clock::now() - start_time;
+            return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+        }
+
+        uint32_t getMicros() const override
+        {
+            auto elapsed = std::chrono::steady_clock::now() - start_time;
+            return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        }
+
+        void delay(uint32_t ms) override { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+        hal::HeapStats getHeapStats() const override { return hal::HeapStats(); }
+        uint32_t getStackHighWaterMark(const char *) const override { return 0; }
+        bool wokeFromSleep() const override { return false; }
+        const char *getCachedScriptActionId() const override { return ""; }
+        void cacheScriptActionId(const char *) override {}
+        uint8_t *getRetainedBuffer(size_t &capacity) override
+        {
+            capacity = 0;
+            return nullptr;
+        }
+        void waitForEvent(uint32_t timeout_ms) override
+        {
+            std::unique_lock<std::mutex> lock(event_mutex);
+            event_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]
+                              { return event_pending; });
+            event_pending = false;
+        }
+
+        void signalEvent() override
+        {
+            {
+                std::lock_guard<std::mutex> lock(event_mutex);
+                event_pending = true;
+            }
+            event_cv.notify_one();
+        }
+    };
+
+} // namespace bench
+
+#endif // NATIVE_BENCH
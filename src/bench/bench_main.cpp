@@ -0,0 +1,77 @@
+#ifdef NATIVE_BENCH
+
+#include "bench.h"
+#include "config.h"
+#include "log.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace bench
+{
+    std::atomic<uint64_t> allocation_count{0};
+
+    struct Suite
+    {
+        const char *name;
+        void (*run)();
+    };
+
+    static const Suite suites[] = {
+        {"parse", runParseBench},
+        {"queue", runQueueBench},
+        {"scenario", runScenarioBench},
+        {"render", runRenderBench},
+    };
+}
+
+// Runtime config normally provided by config.cpp
+const char *getWiFiSSID() { return WIFI_SSID; }
+const char *getWiFiPassword() { return WIFI_PASSWORD; }
+const char *getReaperServer() { return REAPER_SERVER; }
+int getReaperPort() { return REAPER_PORT; }
+
+// Count every heap allocation made by the process
+void *operator new(size_t size)
+{
+    bench::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+// Usage: program [suite...] - runs all suites when none are given
+int main(int argc, char **argv)
+{
+    init_logging();
+
+    for (const auto &suite : bench::suites)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+        {
+            if (strcmp(argv[i], suite.name) == 0)
+                selected = true;
+        }
+
+        if (selected)
+        {
+            fprintf(stderr, "=== %s ===\n", suite.name);
+            suite.run();
+        }
+    }
+    return 0;
+}
+
+#endif // NATIVE_BENCH
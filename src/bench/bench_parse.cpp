@@ -0,0 +1,166 @@
+#ifdef NATIVE_BENCH
+
+#include "bench.h"
+#include "bench_reaper.h"
+#include "http_jobs.h"
+#include "response_parser.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    static const uint32_t PARSE_ITERATIONS = 200000;
+    static const uint32_t SETLIST_ITERATIONS = 5000;
+    static const size_t SETLIST_SONGS = 50;
+
+    // Sample lines as returned by the Reaper web interface
+    static const std::string TRANSPORT_LINE = "TRANSPORT\t1\t123.456789\t0\t62.3.00\t62.3.00\n";
+    static const std::string EXTSTATE_LINE = "EXTSTATE\tReaperSetlist\tactiveIndex\t12\n";
+    static const std::string STATUS_BATCH =
+        "EXTSTATE\tReaperSetlist\ttabs\t[{\"length\":297,\"name\":\"Believer.RPP\",\"index\":0,\"dirty\":false}]\n"
+        "EXTSTATE\tReaperSetlist\tactiveIndex\t12\n"
+        "TRANSPORT\t1\t123.456789\t0\t62.3.00\t62.3.00\n";
+
+    // Previous stringstream based implementation, kept here as the baseline
+    namespace legacy
+    {
+        static std::vector<std::string> parseTabSeparatedResponse(const std::string &response)
+        {
+            std::vector<std::string> items;
+            std::stringstream ss(response);
+            std::string item;
+
+            while (std::getline(ss, item, '\t'))
+            {
+                if (!item.empty() && item.back() == '\n')
+                {
+                    item.pop_back();
+                }
+                if (!item.empty())
+                {
+                    items.push_back(item);
+                }
+            }
+            return items;
+        }
+
+        static std::vector<std::string> parseBatchResponse(const std::string &response)
+        {
+            std::vector<std::string> lines;
+            std::stringstream ss(response);
+            std::string line;
+
+            while (std::getline(ss, line, '\n'))
+            {
+                if (!line.empty() && line.back() == '\r')
+                {
+                    line.pop_back();
+                }
+                if (!line.empty())
+                {
+                    lines.push_back(line);
+                }
+            }
+            return lines;
+        }
+
+        static bool parseTransportState(const std::string &response, reaper::TransportState &transport_state)
+        {
+            auto items = parseTabSeparatedResponse(response);
+            if (items.size() >= 5)
+            {
+                transport_state.play_state = std::stoi(items[1]);
+                transport_state.position_seconds = std::stod(items[2]);
+                transport_state.repeat_enabled = (items[3] == "1");
+                snprintf(transport_state.position_bars_beats, sizeof(transport_state.position_bars_beats), "%s", items[4].c_str());
+                transport_state.success = true;
+                return true;
+            }
+            return false;
+        }
+
+        static bool parseActiveIndex(const std::string &line, unsigned int &active_index)
+        {
+            auto items = parseTabSeparatedResponse(line);
+            if (items.size() >= 4 && items[0] == "EXTSTATE" && items[1] == "ReaperSetlist" && items[2] == "activeIndex")
+            {
+                active_index = std::stoi(items[3]);
+                return true;
+            }
+            return false;
+        }
+    }
+
+    void runParseBench()
+    {
+        reaper::TransportState transport;
+        unsigned int active_index = 0;
+
+        report("parse", "TRANSPORT legacy", measure(PARSE_ITERATIONS, [&]
+                                                    {
+            legacy::parseTransportState(TRANSPORT_LINE, transport);
+            doNotOptimize(transport); }));
+
+        report("parse", "TRANSPORT string_view", measure(PARSE_ITERATIONS, [&]
+                                                         {
+            http::parser::parseTransportLine(TRANSPORT_LINE, transport);
+            doNotOptimize(transport); }));
+
+        report("parse", "GET/EXTSTATE legacy", measure(PARSE_ITERATIONS, [&]
+                                                       {
+            legacy::parseActiveIndex(EXTSTATE_LINE, active_index);
+            doNotOptimize(active_index); }));
+
+        report("parse", "GET/EXTSTATE string_view", measure(PARSE_ITERATIONS, [&]
+                                                            {
+            std::string_view value;
+            if (http::parser::parseExtStateValue(EXTSTATE_LINE, "ReaperSetlist", "activeIndex", value))
+            {
+                http::parser::parseUnsigned(value, active_index);
+            }
+            doNotOptimize(active_index); }));
+
+        report("parse", "status batch legacy", measure(PARSE_ITERATIONS, [&]
+                                                       {
+            auto lines = legacy::parseBatchResponse(STATUS_BATCH);
+            legacy::parseActiveIndex(lines[1], active_index);
+            legacy::parseTransportState(lines[2], transport);
+            doNotOptimize(transport); }));
+
+        report("parse", "status batch string_view", measure(PARSE_ITERATIONS, [&]
+                                                            {
+            std::string_view lines[8];
+            http::parser::splitLines(STATUS_BATCH, lines, 8);
+            std::string_view value;
+            if (http::parser::parseExtStateValue(lines[1], "ReaperSetlist", "activeIndex", value))
+            {
+                http::parser::parseUnsigned(value, active_index);
+            }
+            http::parser::parseTransportLine(lines[2], transport);
+            doNotOptimize(transport); }));
+
+        // Whole setlist payloads, both wire formats of the same 50 songs
+        std::vector<FakeReaper::Tab> setlist;
+        for (size_t i = 0; i < SETLIST_SONGS; ++i)
+        {
+            setlist.push_back({"Song " + std::to_string(i + 1) + " - Working Title.RPP", 150.0 + (double)(i * 7 % 180)});
+        }
+        const std::string tabs_json = FakeReaper::encodeJson(setlist);
+        const std::string tabs_compact = FakeReaper::encodeCompact(setlist);
+        fprintf(stderr, "parse      setlist payload: %zu bytes JSON, %zu bytes compact\n", tabs_json.size(), tabs_compact.size());
+
+        report("parse", "setlist 50 JSON", measure(SETLIST_ITERATIONS, [&]
+                                                   {
+            auto tabs = http::parseTabData(tabs_json);
+            doNotOptimize(tabs); }));
+
+        report("parse", "setlist 50 compact", measure(SETLIST_ITERATIONS, [&]
+                                                      {
+            auto tabs = http::parseTabData(tabs_compact);
+            doNotOptimize(tabs); }));
+    }
+
+} // namespace bench
+
+#endif // NATIVE_BENCH
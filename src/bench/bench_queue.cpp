@@ -0,0 +1,219 @@
+#ifdef NATIVE_BENCH
+
+#include "bench.h"
+#include "bench_hal.h"
+#include "http_job_manager.h"
+#include "network_manager.h"
+#include "spsc_ring.h"
+#include <thread>
+
+namespace bench
+{
+    static const uint32_t RING_MESSAGES = 1000000;
+    static const uint32_t JOB_COUNT = 50000;
+    static const uint32_t EMPTY_POLL_ITERATIONS = 1000000;
+    static const size_t SUBMIT_SLOTS = 1024; // Submit timestamps indexed by job ID, must exceed jobs in flight
+
+    // Raw ring: the producer pushes timestamps as fast as the ring accepts them, so both
+    // ends contend on the indices for the whole run. Both sides yield rather than spin so the
+    // numbers stay meaningful on single-core hosts.
+    static void runRingBench()
+    {
+        SpscRing<uint64_t, 16> ring;
+        std::vector<uint64_t> latencies;
+        latencies.reserve(RING_MESSAGES);
+
+        uint64_t start = nowNs();
+        std::thread producer([&]
+                             {
+            for (uint32_t i = 0; i < RING_MESSAGES; ++i)
+            {
+                while (!ring.push(nowNs()))
+                {
+                    std::this_thread::yield();
+                }
+            } });
+
+        uint64_t sent_at = 0;
+        while (latencies.size() < RING_MESSAGES)
+        {
+            if (ring.pop(sent_at))
+            {
+                latencies.push_back(nowNs() - sent_at);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+
+        Measurement m;
+        m.ns_per_op = (double)(nowNs() - start) / RING_MESSAGES;
+        m.allocs_per_op = 0.0;
+        report("queue", "SpscRing<16> push->pop", m);
+        reportLatency("queue", "SpscRing<16> push->pop", latencies);
+    }
+
+    // Full HttpJobManager path (submit, worker wake, execute against the canned HAL, result
+    // ring, nextResult) with up to max_in_flight jobs outstanding. One job in flight measures
+    // waking an idle worker; more keeps the worker busy and both rings contended. Playstate
+    // jobs are used because they are never coalesced.
+    static void runJobManagerBench(const char *name, uint32_t max_in_flight)
+    {
+        BenchSystemHAL system;
+        NetworkManager network(&system.getNetworkManager());
+        http::HttpJobManager manager(&system, &network, "http://127.0.0.1:8080/_");
+
+        // Drain the initial WiFi connect result
+        http::HttpJobResult result;
+        while (!manager.nextResult(result))
+        {
+            std::this_thread::yield();
+        }
+
+        std::vector<uint64_t> submit_ns(SUBMIT_SLOTS, 0);
+        std::vector<uint64_t> latencies;
+        latencies.reserve(JOB_COUNT);
+
+        uint32_t submitted = 0;
+        uint32_t in_flight = 0;
+        uint64_t allocs_before = allocation_count.load();
+        uint64_t start = nowNs();
+
+        while (latencies.size() < JOB_COUNT)
+        {
+            while (in_flight < max_in_flight && submitted < JOB_COUNT)
+            {
+                uint64_t submit_time = nowNs();
+                uint32_t job_id = manager.submitChangePlaystateJob(http::PlayAction::PLAY);
+                if (job_id == 0)
+                    break;
+                submit_ns[job_id % SUBMIT_SLOTS] = submit_time;
+                submitted++;
+                in_flight++;
+            }
+
+            bool received = false;
+            while (manager.nextResult(result))
+            {
+                latencies.push_back(nowNs() - submit_ns[result.job_id % SUBMIT_SLOTS]);
+                in_flight--;
+                received = true;
+            }
+            if (!received)
+            {
+                std::this_thread::yield(); // Let the worker run on single-core hosts
+            }
+        }
+
+        Measurement m;
+        m.ns_per_op = (double)(nowNs() - start) / JOB_COUNT;
+        m.allocs_per_op = (double)(allocation_count.load() - allocs_before) / JOB_COUNT;
+        report("queue", name, m);
+        reportLatency("queue", name, latencies);
+
+        // What the main loop pays every frame when nothing has completed
+        report("queue", "nextResult() empty poll", measure(EMPTY_POLL_ITERATIONS, [&]
+                                                          {
+            manager.nextResult(result);
+            doNotOptimize(result); }));
+    }
+
+    // Polls and button presses arriving every frame while each request takes several frames,
+    // as happens on slow Wi-Fi. Reports how many HTTP requests coalescing saved.
+    static void runCoalesceBench()
+    {
+        static const uint32_t FRAMES = 200;
+        static const auto FRAME_TIME = std::chrono::milliseconds(1);
+
+        BenchSystemHAL system;
+        system.getBenchNetworkManager().setLatency(std::chrono::microseconds(4000));
+        NetworkManager network(&system.getNetworkManager());
+        http::HttpJobManager manager(&system, &network, "http://127.0.0.1:8080/_");
+
+        uint32_t submitted = 0;
+        http::HttpJobResult result;
+        for (uint32_t frame = 0; frame < FRAMES; ++frame)
+        {
+            manager.submitGetTransportJob();
+            manager.submitChangeTabJob((frame % 3 == 0) ? http::TabDirection::PREVIOUS : http::TabDirection::NEXT);
+            submitted += 2;
+            if (frame % 10 == 0)
+            {
+                manager.submitGetStatusJob();
+                manager.submitChangePlaystateJob(http::PlayAction::PLAY);
+                submitted += 2;
+            }
+
+            while (manager.nextResult(result))
+            {
+            }
+            std::this_thread::sleep_for(FRAME_TIME);
+        }
+
+        // Let the worker drain the queue before reading the request counter
+        while (manager.getHttpStats().requests + manager.getCoalesceStats().requestsSaved() < submitted)
+        {
+            manager.nextResult(result);
+            std::this_thread::sleep_for(FRAME_TIME);
+        }
+
+        const http::JobCoalesceStats &stats = manager.getCoalesceStats();
+        fprintf(stderr, "%-10s %-32s %u submitted, %u HTTP requests, %u saved (merged %u, dropped %u, folded %u)\n",
+                "queue", "coalescing, 4 ms requests", submitted, manager.getHttpStats().requests, stats.requestsSaved(),
+                stats.read_jobs_merged, stats.transport_jobs_dropped, stats.tab_presses_folded);
+    }
+
+    // Button presses mixed into a steady stream of polls and background refreshes on slow
+    // requests. Reports how long each priority class waited in the queue before a worker took it.
+    static void runPriorityBench()
+    {
+        static const uint32_t FRAMES = 200;
+        static const auto FRAME_TIME = std::chrono::milliseconds(2);
+
+        BenchSystemHAL system;
+        system.getBenchNetworkManager().setLatency(std::chrono::microseconds(4000));
+        NetworkManager network(&system.getNetworkManager());
+        http::HttpJobManager manager(&system, &network, "http://127.0.0.1:8080/_");
+
+        http::HttpJobResult result;
+        for (uint32_t frame = 0; frame < FRAMES; ++frame)
+        {
+            manager.submitGetTransportJob();
+            if (frame % 5 == 0)
+            {
+                manager.submitGetStatusJob();
+                manager.submitGetScriptActionIdJob();
+            }
+            if (frame % 10 == 0)
+            {
+                manager.submitChangePlaystateJob(http::PlayAction::PLAY);
+            }
+
+            while (manager.nextResult(result))
+            {
+            }
+            std::this_thread::sleep_for(FRAME_TIME);
+        }
+
+        for (size_t priority = 0; priority < http::JOB_PRIORITY_COUNT; ++priority)
+        {
+            http::QueueWaitStats wait = manager.getQueueWaitStats((http::JobPriority)priority);
+            fprintf(stderr, "%-10s queue wait %-21s avg %5u ms  max %5u ms  (%u jobs)\n", "queue",
+                    http::jobPriorityName((http::JobPriority)priority), wait.averageWaitMs(), wait.max_wait_ms, wait.jobs);
+        }
+    }
+
+    void runQueueBench()
+    {
+        runRingBench();
+        runJobManagerBench("job submit->result (1 in flight)", 1);
+        runJobManagerBench("job submit->result (8 in flight)", 8);
+        runCoalesceBench();
+        runPriorityBench();
+    }
+
+} // namespace bench
+
+#endif // NATIVE_BENCH
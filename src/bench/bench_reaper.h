@@ -0,0 +1,316 @@
+#pragma once
+
+#ifdef NATIVE_BENCH
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+    // In-process stand-in for REAPER's web interface with the ReaperSetlist script loaded.
+    // Answers the semicolon-separated batches the jobs send (TRANSPORT, play/stop, tab
+    // actions, GET/SET EXTSTATE) from a simulated setlist and transport, after a configurable
+    // round trip. Workers call it concurrently, so state is behind a mutex.
+    class FakeReaper
+    {
+    public:
+        struct Conditions
+        {
+            uint32_t latency_ms = 0;   // Round trip of every request
+            uint32_t jitter_ms = 0;    // Extra round trip, uniform in [0, jitter_ms]
+            uint32_t loss_percent = 0; // Requests that time out instead of answering
+        };
+
+        struct Tab
+        {
+            std::string name;
+            double length_seconds;
+        };
+
+        static constexpr const char *SCRIPT_ACTION_ID = "_RSa1b2c3d4e5f60718293a4b5c6d7e8f9012345678";
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        mutable std::mutex mutex;
+        Conditions conditions;
+        std::mt19937 rng{12345}; // Fixed seed, runs are repeatable
+
+        std::vector<Tab> tabs;
+        unsigned int active_index = 0;
+        int play_state = 0;
+        double start_position = 0.0; // Position when playback started (or while stopped)
+        Clock::time_point play_start;
+        std::map<std::string, std::string, std::less<>> ext_state; // ReaperSetlist section
+
+        uint32_t requests = 0;
+        uint32_t requests_lost = 0;
+        uint32_t commands = 0;
+        uint32_t script_runs = 0;
+
+        double positionLocked() const
+        {
+            double position = start_position;
+            if (play_state == 1)
+            {
+                position += std::chrono::duration<double>(Clock::now() - play_start).count();
+            }
+            return position;
+        }
+
+        void appendTransport(std::string &response) const
+        {
+            // Bars.beats at 120 bpm in 4/4
+            double position = positionLocked();
+            unsigned int beats = (unsigned int)(position * 2.0);
+            unsigned int hundredths = (unsigned int)(position * 200.0) % 100;
+            char line[96];
+            snprintf(line, sizeof(line), "TRANSPORT\t%d\t%.6f\t0\t%u.%u.%02u\t%u.%u.%02u\n", play_state, position,
+                     beats / 4 + 1, beats % 4 + 1, hundredths, beats / 4 + 1, beats % 4 + 1, hundredths);
+            response += line;
+        }
+
+        void appendExtState(std::string &response, std::string_view key, std::string_view value) const
+        {
+            response.append("EXTSTATE\tReaperSetlist\t").append(key).append("\t").append(value).append("\n");
+        }
+
+        void selectTabLocked(unsigned int index)
+        {
+            // Switching project tabs keeps the transport of the tab switched to, which is stopped
+            active_index = index;
+            play_state = 0;
+            start_position = 0.0;
+        }
+
+        void runCommand(std::string_view command, std::string &response)
+        {
+            static const std::string_view GET_EXTSTATE = "GET/EXTSTATE/ReaperSetlist/";
+            static const std::string_view SET_EXTSTATE = "SET/EXTSTATE/ReaperSetlist/";
+
+            commands++;
+            if (command == "TRANSPORT")
+            {
+                appendTransport(response);
+            }
+            else if (command == "1007" && play_state != 1)
+            {
+                play_state = 1;
+                play_start = Clock::now();
+            }
+            else if (command == "1016")
+            {
+                play_state = 0;
+                start_position = 0.0;
+            }
+            else if (command == "40861" && !tabs.empty())
+            {
+                selectTabLocked((active_index + 1) % tabs.size());
+            }
+            else if (command == "40862" && !tabs.empty())
+            {
+                selectTabLocked((active_index + tabs.size() - 1) % tabs.size());
+            }
+            else if (command.substr(0, GET_EXTSTATE.size()) == GET_EXTSTATE)
+            {
+                std::string_view key = command.substr(GET_EXTSTATE.size());
+                if (key == "tabs")
+                {
+                    auto format = ext_state.find("tabsFormat");
+                    bool compact = format != ext_state.end() && format->second == "compact1";
+                    appendExtState(response, key, compact ? encodeCompact(tabs) : encodeJson(tabs));
+                }
+                else if (key == "activeIndex")
+                {
+                    appendExtState(response, key, std::to_string(active_index));
+                }
+                else
+                {
+                    auto value = ext_state.find(key);
+                    appendExtState(response, key, value != ext_state.end() ? std::string_view(value->second) : std::string_view());
+                }
+            }
+            else if (command.substr(0, SET_EXTSTATE.size()) == SET_EXTSTATE)
+            {
+                std::string_view key_value = command.substr(SET_EXTSTATE.size());
+                size_t separator = key_value.find('/');
+                if (separator != std::string_view::npos)
+                {
+                    ext_state[std::string(key_value.substr(0, separator))] = std::string(key_value.substr(separator + 1));
+                }
+            }
+            else if (command == SCRIPT_ACTION_ID)
+            {
+                script_runs++; // The refresh, on REAPER's UI thread
+            }
+            // Anything else is accepted without a response line
+        }
+
+    public:
+        // The tabs ExtState value as the ReaperSetlist script writes it, JSON or compact
+        static std::string encodeJson(const std::vector<Tab> &setlist)
+        {
+            std::string json = "[";
+            for (size_t i = 0; i < setlist.size(); ++i)
+            {
+                char entry[192];
+                snprintf(entry, sizeof(entry), "%s{\"length\":%.0f,\"name\":\"%s\",\"index\":%zu,\"dirty\":false}",
+                         i > 0 ? "," : "", setlist[i].length_seconds, setlist[i].name.c_str(), i);
+                json += entry;
+            }
+            return json + "]";
+        }
+
+        static std::string encodeCompact(const std::vector<Tab> &setlist)
+        {
+            std::string table;
+            std::string records;
+            for (const Tab &tab : setlist)
+            {
+                std::string_view name = tab.name;
+                if (name.size() >= 4 && (name.substr(name.size() - 4) == ".RPP" || name.substr(name.size() - 4) == ".rpp"))
+                {
+                    name.remove_suffix(4);
+                }
+                char record[48];
+                snprintf(record, sizeof(record), "%.0f,%zu,%zu;", tab.length_seconds * 1000.0, table.size(), name.size());
+                records += record;
+                table.append(name);
+            }
+            return "S1:" + std::to_string(setlist.size()) + ":" + std::to_string(table.size()) + ":" + table + records;
+        }
+
+        FakeReaper()
+        {
+            tabs = {{"Believer.RPP", 297}, {"Thunder.RPP", 187}, {"Radioactive.RPP", 186},
+                    {"Demons.RPP", 177}, {"Natural.RPP", 189}, {"Bones.RPP", 165}};
+            ext_state["ScriptActionId"] = SCRIPT_ACTION_ID;
+        }
+
+        void setConditions(const Conditions &network_conditions)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            conditions = network_conditions;
+        }
+
+        // Changes made on the REAPER side, as a user at the computer would
+        void selectTab(unsigned int index)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (index < tabs.size())
+            {
+                selectTabLocked(index);
+            }
+        }
+
+        void seek(double position_seconds)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            start_position = position_seconds;
+            play_start = Clock::now();
+        }
+
+        uint32_t getRequests() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return requests;
+        }
+
+        uint32_t getRequestsLost() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return requests_lost;
+        }
+
+        uint32_t getCommands() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return commands;
+        }
+
+        uint32_t getScriptRuns() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return script_runs;
+        }
+
+        // A script that keeps tabs/activeIndex current by itself flags it in the live ExtState
+        void setScriptKeepsState(bool keeps_state)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (keeps_state)
+            {
+                ext_state["live"] = "1";
+            }
+            else
+            {
+                ext_state.erase("live");
+            }
+        }
+
+        // Serve one request URL ("http://host:port/_/CMD;CMD;..."). Blocks for the simulated round
+        // trip; a lost request blocks for it too and then fails like a timeout.
+        bool handle(const char *url, std::string &response, int &status_code)
+        {
+            uint32_t round_trip_ms = 0;
+            bool lost = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                requests++;
+                round_trip_ms = conditions.latency_ms;
+                if (conditions.jitter_ms > 0)
+                {
+                    round_trip_ms += std::uniform_int_distribution<uint32_t>(0, conditions.jitter_ms)(rng);
+                }
+                lost = conditions.loss_percent > 0 && std::uniform_int_distribution<uint32_t>(0, 99)(rng) < conditions.loss_percent;
+                if (lost)
+                {
+                    requests_lost++;
+                }
+            }
+
+            if (round_trip_ms > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(round_trip_ms));
+            }
+
+            response.clear();
+            if (lost)
+            {
+                status_code = 0;
+                return false;
+            }
+
+            std::string_view batch(url);
+            size_t commands_start = batch.find("/_/");
+            if (commands_start == std::string_view::npos)
+            {
+                status_code = 404;
+                return true;
+            }
+            batch.remove_prefix(commands_start + 3);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            while (!batch.empty())
+            {
+                size_t separator = batch.find(';');
+                runCommand(batch.substr(0, separator), response);
+                batch.remove_prefix(separator == std::string_view::npos ? batch.size() : separator + 1);
+            }
+            status_code = 200;
+            return true;
+        }
+    };
+
+} // namespace bench
+
+#endif // NATIVE_BENCH
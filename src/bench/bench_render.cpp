@@ -0,0 +1,241 @@
+#ifdef NATIVE_BENCH
+
+#include "bench.h"
+#include "bench_hal.h"
+#include "ui_manager.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace bench
+{
+    // LVGL render cost of the real screens: a UIManager on the headless display (the device's
+    // strip buffer and LV_MEM_SIZE pool) is driven through scripted state changes, one frame
+    // after each. Reports the frame time, the area redrawn and how many strips that took, and
+    // finally how much of the LVGL pool the screens used and how much degraded mode gives back.
+
+    struct RenderScript
+    {
+        const char *name;
+        // Apply step i to the UI - a frame is rendered after each call
+        std::function<void(UIManager &ui, uint32_t i, unsigned long now)> step;
+    };
+
+    static const uint32_t RENDER_ITERATIONS = 200;
+    static const uint32_t SCREEN_PIXELS = 320 * 240;
+
+    static const char *const TAB_NAMES[] = {
+        "Believer.RPP",
+        "Smells Like Teen Spirit (Extended Live Version).RPP",
+        "Mr. Brightside.RPP",
+        "Bohemian Rhapsody.RPP",
+        "Don't Stop Me Now (Encore, Key Change).RPP",
+        "Seven Nation Army.RPP",
+        "Sweet Child O' Mine.RPP",
+        "Everlong.RPP",
+        "Take On Me.RPP",
+        "Livin' On A Prayer.RPP",
+        "Song 2.RPP",
+        "Wonderwall.RPP",
+    };
+
+    static const size_t TAB_NAME_COUNT = sizeof(TAB_NAMES) / sizeof(TAB_NAMES[0]);
+
+    // The names above, repeated as needed - a full setlist (MAX_TABS) is the picker's worst case
+    static reaper::ReaperState makeSetlist(size_t tab_count = TAB_NAME_COUNT)
+    {
+        reaper::ReaperState state;
+        state.tabs = std::make_unique<reaper::Setlist>();
+        for (unsigned int i = 0; i < tab_count; ++i)
+        {
+            if (!state.tabs->add(180.0f + 17.0f * (i % TAB_NAME_COUNT), i, TAB_NAMES[i % TAB_NAME_COUNT]))
+            {
+                break;
+            }
+        }
+        state.tabs_digest = 1;
+        state.success = true;
+        return state;
+    }
+
+    static reaper::TransportState makeTransport(int play_state, double position)
+    {
+        reaper::TransportState transport;
+        transport.play_state = play_state;
+        transport.position_seconds = position;
+        transport.success = true;
+        return transport;
+    }
+
+    static void reportPool(const char *name)
+    {
+        lv_mem_monitor_t mem;
+        lv_mem_monitor(&mem);
+        fprintf(stderr, "%-10s %-32s used %6zu of %6zu bytes  peak %6zu  block %6zu  frag %3u%%\n", "render", name,
+                (size_t)(mem.total_size - mem.free_size), (size_t)mem.total_size, (size_t)mem.max_used,
+                (size_t)mem.free_biggest_size, (unsigned)mem.frag_pct);
+    }
+
+    void runRenderBench()
+    {
+        BenchSystemHAL system;
+        system.init();
+        BenchDisplayManager &display = system.getBenchDisplayManager();
+
+        UIManager ui(&system);
+        ui.createUI();
+        ui.showMainUI();
+        ui.updateConnectionState(true, true);
+
+        reaper::ReaperState state = makeSetlist();
+        reaper::ReaperState full = makeSetlist(reaper::Setlist::MAX_TABS);
+        reaper::TransportState stopped = makeTransport(0, 0.0);
+        ui.setUIState(UIState::STOPPED);
+        ui.updateReaperStateUI(state);
+        ui.updateTransportUI(stopped, state, 0.0);
+        ui.updateButtonLabelsUI();
+        ui.refreshIfDirty();
+
+        const std::vector<RenderScript> scripts = {
+            // Everything redrawn, as after waking or a screen change
+            {"full screen", [](UIManager &, uint32_t, unsigned long)
+             { lv_obj_invalidate(lv_screen_active()); }},
+            // Next tab in REAPER: name, length and position in the setlist
+            {"tab change", [&](UIManager &ui, uint32_t i, unsigned long)
+             {
+                 state.active_index = (i + 1) % state.tabCount();
+                 ui.updateReaperStateUI(state);
+             }},
+            // Playing: the time display moves on by a second
+            {"clock tick", [&](UIManager &ui, uint32_t i, unsigned long)
+             {
+                 double position = 1.0 + i;
+                 ui.updateTransportUI(makeTransport(1, position), state, position);
+             }},
+            // Play and stop in turn: icon, button labels
+            {"play/stop", [&](UIManager &ui, uint32_t i, unsigned long)
+             {
+                 bool playing = i % 2 == 0;
+                 ui.setUIState(playing ? UIState::PLAYING : UIState::STOPPED);
+                 ui.updateTransportUI(makeTransport(playing ? 1 : 0, 0.0), state, 0.0);
+                 ui.updateButtonLabelsUI();
+             }},
+            // The stop confirmation shown and dismissed
+            {"confirm prompt", [&](UIManager &ui, uint32_t i, unsigned long)
+             {
+                 ui.setUIState(i % 2 == 0 ? UIState::ARE_YOU_SURE : UIState::STOPPED);
+                 ui.updateButtonLabelsUI();
+             }},
+            // Rollback tint on the tab name, then cleared
+            {"rollback hint", [&](UIManager &ui, uint32_t i, unsigned long now)
+             {
+                 if (i % 2 == 0)
+                 {
+                     ui.showRollbackHint(now);
+                 }
+                 else
+                 {
+                     ui.updatePeriodicUI(now + 60000);
+                 }
+             }},
+            {"wifi status", [](UIManager &ui, uint32_t i, unsigned long)
+             { ui.updateWiFiUI(i % 2 == 1); }},
+            // Setlist picker opened from stopped, closed again
+            {"picker open", [&](UIManager &ui, uint32_t i, unsigned long now)
+             {
+                 if (i % 2 == 0)
+                 {
+                     ui.openTabPicker(state, now);
+                 }
+                 else
+                 {
+                     ui.setUIState(UIState::STOPPED);
+                 }
+                 ui.updateButtonLabelsUI();
+             }},
+            // Selection moved down the open picker, scrolling the list
+            {"picker move", [&](UIManager &ui, uint32_t i, unsigned long now)
+             {
+                 if (i == 0)
+                 {
+                     ui.openTabPicker(state, now);
+                     ui.updateButtonLabelsUI();
+                 }
+                 ui.moveTabPicker(state, 1, now);
+             }},
+            // The same with a full setlist, opened on its last tab and wrapping round it
+            {"picker open, full setlist", [&](UIManager &ui, uint32_t i, unsigned long now)
+             {
+                 if (i % 2 == 0)
+                 {
+                     full.active_index = (unsigned int)full.tabCount() - 1;
+                     ui.openTabPicker(full, now);
+                 }
+                 else
+                 {
+                     ui.setUIState(UIState::STOPPED);
+                 }
+                 ui.updateButtonLabelsUI();
+             }},
+            {"picker move, full setlist", [&](UIManager &ui, uint32_t i, unsigned long now)
+             {
+                 if (i == 0)
+                 {
+                     full.active_index = 0;
+                     ui.openTabPicker(full, now);
+                     ui.updateButtonLabelsUI();
+                 }
+                 ui.moveTabPicker(full, 1, now);
+             }},
+        };
+
+        for (const auto &script : scripts)
+        {
+            std::vector<uint64_t> frame_ns;
+            frame_ns.reserve(RENDER_ITERATIONS);
+            uint64_t pixels = 0;
+            uint64_t flushes = 0;
+
+            for (uint32_t i = 0; i < RENDER_ITERATIONS; ++i)
+            {
+                script.step(ui, i, system.getMillis());
+                uint64_t pixels_before = display.getPixelsFlushed();
+                uint64_t flushes_before = display.getFlushCount();
+                uint64_t start = nowNs();
+                if (ui.refreshIfDirty())
+                {
+                    frame_ns.push_back(nowNs() - start);
+                    pixels += display.getPixelsFlushed() - pixels_before;
+                    flushes += display.getFlushCount() - flushes_before;
+                }
+            }
+
+            if (frame_ns.empty())
+            {
+                fprintf(stderr, "%-10s %-32s nothing redrawn\n", "render", script.name);
+                continue;
+            }
+            size_t frames = frame_ns.size();
+            reportLatency("render", script.name, frame_ns);
+            fprintf(stderr, "%-10s %-32s %8.0f px/frame %5.1f%% of screen %5.1f strips/frame %4zu frames\n", "render", "",
+                    (double)pixels / frames, 100.0 * pixels / frames / SCREEN_PIXELS, (double)flushes / frames, frames);
+
+            // Leave the next script the stopped main screen
+            ui.setUIState(UIState::STOPPED);
+            state.active_index = 0;
+            ui.updateReaperStateUI(state);
+            ui.updateTransportUI(stopped, state, 0.0);
+            ui.updateButtonLabelsUI();
+            ui.refreshIfDirty();
+        }
+
+        reportPool("lvgl pool");
+        // What degraded mode (MemoryBudget) hands back: the neighbouring tab labels and picker rows
+        ui.setMemoryDegraded(true);
+        ui.refreshIfDirty();
+        reportPool("lvgl pool, degraded");
+    }
+
+} // namespace bench
+
+#endif // NATIVE_BENCH
@@ -0,0 +1,301 @@
+#ifdef NATIVE_BENCH
+
+#include "bench.h"
+#include "bench_hal.h"
+#include "bench_reaper.h"
+#include "button_handler.h"
+#include "http_job_manager.h"
+#include "network_manager.h"
+#include "result_handlers.h"
+#include "state_manager.h"
+#include "ui_manager.h"
+#include <algorithm>
+#include <ctime>
+#include <vector>
+
+namespace bench
+{
+    // Scenario scripts: the application components (ButtonHandler, StateManager, HttpJobManager,
+    // UIManager on a headless LVGL display) run the main loop against a FakeReaper, while the
+    // script presses buttons and changes things on the REAPER side. Everything runs in real
+    // time, so rates come out as they would on the device with the same network conditions.
+
+    enum class StepAction
+    {
+        PRESS,       // value = button (0 = A, 1 = B, 2 = C)
+        SELECT_TAB,  // value = tab index, switched to in REAPER
+        SEEK,        // value = position in seconds, REAPER's play cursor moved
+        PRIMARY_LOSS, // value = percent of requests the primary host drops, 100 takes it down
+        HOLD,         // value = button, pressed and kept down
+        RELEASE       // value = button
+    };
+
+    struct ScenarioStep
+    {
+        uint32_t at_ms; // From the first transport state
+        StepAction action;
+        uint32_t value;
+    };
+
+    struct Scenario
+    {
+        const char *name;
+        FakeReaper::Conditions conditions;
+        uint32_t duration_ms;
+        std::vector<ScenarioStep> steps; // In time order
+        bool script_keeps_state = false; // ReaperSetlist keeps its ExtState current (live)
+        bool backup_host = false;        // A second FakeReaper follows the first
+    };
+
+    static const uint8_t BUTTON_A = 0;
+    static const uint8_t BUTTON_B = 1;
+    static const uint8_t BUTTON_C = 2;
+
+    static const uint32_t CONNECT_TIMEOUT_MS = 10000;
+    static const uint32_t MAX_IDLE_WAIT_MS = 1000; // As the main loop
+
+    static const Scenario scenarios[] = {
+        // Nothing happens - what the polls alone cost
+        {"idle-stopped", {5, 0, 0}, 15000, {}},
+        // The same with a script that keeps the setlist current, polls are read-only
+        {"idle-live", {5, 0, 0}, 15000, {}, true},
+        // Start a song and let it play; REAPER's cursor jumps half way through
+        {"playing", {5, 0, 0}, 15000, {
+            {500, StepAction::PRESS, BUTTON_B},
+            {8000, StepAction::SEEK, 120},
+        }},
+        // Step through the setlist, three presses in quick succession get folded into one job
+        {"browse", {30, 20, 0}, 15000, {
+            {1000, StepAction::PRESS, BUTTON_C},
+            {1150, StepAction::PRESS, BUTTON_C},
+            {1300, StepAction::PRESS, BUTTON_C},
+            {4000, StepAction::PRESS, BUTTON_A},
+            {7000, StepAction::PRESS, BUTTON_C},
+            {10000, StepAction::SELECT_TAB, 0},
+        }},
+        // Slow, lossy WiFi: browse, play, confirm a stop
+        {"lossy-wifi", {80, 120, 10}, 15000, {
+            {1000, StepAction::PRESS, BUTTON_C},
+            {3000, StepAction::PRESS, BUTTON_B},
+            {8000, StepAction::PRESS, BUTTON_B},
+            {8500, StepAction::PRESS, BUTTON_A},
+            {11000, StepAction::PRESS, BUTTON_A},
+        }},
+        // Hold C for the setlist picker, move down three tabs and jump there in one request
+        {"jump", {30, 20, 0}, 15000, {
+            {1000, StepAction::HOLD, BUTTON_C},
+            {2000, StepAction::RELEASE, BUTTON_C},
+            {3000, StepAction::PRESS, BUTTON_C},
+            {3200, StepAction::PRESS, BUTTON_C},
+            {3400, StepAction::PRESS, BUTTON_C},
+            {4000, StepAction::PRESS, BUTTON_B},
+        }},
+        // Two rigs: browse, the primary goes down mid-set and comes back, the backup keeps up
+        {"failover", {5, 0, 0}, 15000, {
+            {1000, StepAction::PRESS, BUTTON_C},
+            {2000, StepAction::PRESS, BUTTON_B},
+            {4000, StepAction::PRIMARY_LOSS, 100},
+            {6000, StepAction::PRESS, BUTTON_C},
+            {8000, StepAction::PRESS, BUTTON_B},
+            {11000, StepAction::PRIMARY_LOSS, 0},
+        }, false, true},
+    };
+
+    // CPU time of the calling thread - the main loop, not the workers or the fake server
+    static uint64_t threadCpuNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+    static void runStep(const ScenarioStep &step, const Scenario &scenario, BenchSystemHAL &system, FakeReaper &reaper)
+    {
+        switch (step.action)
+        {
+        case StepAction::PRESS:
+            system.getBenchInputManager().press((uint8_t)step.value);
+            break;
+        case StepAction::SELECT_TAB:
+            reaper.selectTab(step.value);
+            break;
+        case StepAction::SEEK:
+            reaper.seek(step.value);
+            break;
+        case StepAction::PRIMARY_LOSS:
+        {
+            FakeReaper::Conditions conditions = scenario.conditions;
+            conditions.loss_percent = step.value;
+            reaper.setConditions(conditions);
+            break;
+        }
+        case StepAction::HOLD:
+        case StepAction::RELEASE:
+            system.getBenchInputManager().hold((uint8_t)step.value, step.action == StepAction::HOLD);
+            break;
+        }
+    }
+
+    static void runScenario(const Scenario &scenario)
+    {
+        // Declared so the job manager, whose workers talk to the server, is destroyed first
+        FakeReaper reaper;
+        FakeReaper backup;
+        reaper.setConditions(scenario.conditions);
+        reaper.setScriptKeepsState(scenario.script_keeps_state);
+        backup.setConditions(scenario.conditions);
+        backup.setScriptKeepsState(scenario.script_keeps_state);
+        BenchSystemHAL system;
+        system.init();
+        system.getBenchNetworkManager().setServer(&reaper);
+        system.getBenchUserNetworkManager().setServer(&reaper);
+        system.getBenchBackupNetworkManager().setServer(&backup);
+
+        NetworkManager network(&system.getNetworkManager());
+        UIManager ui(&system);
+        ui.createUI();
+        http::HttpJobManager http_manager(&system, &network, "http://127.0.0.1:8080/_",
+                                          scenario.backup_host ? "http://127.0.0.2:8080/_" : "");
+        StateManager state_manager(&http_manager, &ui);
+        ButtonHandler button_handler(&system.getInputManager(), &http_manager, &ui);
+        button_handler.setStateManager(&state_manager);
+
+        http::ResultDispatcher results;
+        AppComponents components;
+        components.system = &system;
+        components.ui = &ui;
+        components.button_handler = &button_handler;
+        components.state_manager = &state_manager;
+        components.http_manager = &http_manager;
+        registerResultHandlers(results, components);
+
+        // Measured from the first transport state, connecting is not part of the scenario
+        bool started = false;
+        uint32_t start_time = 0;
+        uint32_t frames_before = 0;
+        uint64_t allocs_before = 0;
+        uint32_t requests_before = 0;
+        uint32_t backup_requests_before = 0;
+        uint32_t lost_before = 0;
+        uint32_t script_runs_before = 0;
+        uint64_t cpu_before = 0;
+        size_t next_step = 0;
+
+        while (true)
+        {
+            uint32_t now = system.getMillis();
+            if (!started)
+            {
+                if (ui.getCurrentUIState() != UIState::DISCONNECTED && state_manager.getTransportState().success)
+                {
+                    started = true;
+                    start_time = now;
+                    frames_before = ui.getFramesRendered();
+                    allocs_before = allocation_count.load();
+                    requests_before = reaper.getRequests();
+                    backup_requests_before = backup.getRequests();
+                    lost_before = reaper.getRequestsLost();
+                    script_runs_before = reaper.getScriptRuns();
+                    cpu_before = threadCpuNs();
+                }
+                else if (now >= CONNECT_TIMEOUT_MS)
+                {
+                    fprintf(stderr, "%-10s %-32s did not connect within %u ms\n", "scenario", scenario.name, CONNECT_TIMEOUT_MS);
+                    return;
+                }
+            }
+            if (started)
+            {
+                uint32_t elapsed = now - start_time;
+                if (elapsed >= scenario.duration_ms)
+                {
+                    break;
+                }
+                while (next_step < scenario.steps.size() && scenario.steps[next_step].at_ms <= elapsed)
+                {
+                    runStep(scenario.steps[next_step++], scenario, system, reaper);
+                }
+            }
+
+            // The main loop, without power management
+            system.update();
+            now = system.getMillis();
+            if (button_handler.handleButtonPress(now))
+            {
+                state_manager.onUserInput();
+            }
+            state_manager.update(now);
+            http_manager.checkAndRetryConnections(now);
+
+            http::HttpJobResult result;
+            while (http_manager.nextResult(result))
+            {
+                results.dispatch(result, now);
+            }
+
+            ui.updateReaperStateUI(state_manager.getReaperState());
+            ui.updateTransportUI(state_manager.getTransportState(), state_manager.getReaperState(),
+                                 state_manager.getPredictedPosition(now));
+            ui.updateButtonLabelsUI();
+            ui.updatePeriodicUI(now);
+            if (ui.refreshIfDirty())
+            {
+                state_manager.onFrameRendered(system.getMillis());
+            }
+
+            now = system.getMillis();
+            uint32_t wait_ms = MAX_IDLE_WAIT_MS;
+            wait_ms = std::min(wait_ms, state_manager.msUntilNextUpdate(now));
+            wait_ms = std::min(wait_ms, http_manager.msUntilNextUpdate(now));
+            wait_ms = std::min(wait_ms, ui.msUntilNextUpdate(now));
+            wait_ms = std::min(wait_ms, button_handler.msUntilNextUpdate(now));
+            if (started)
+            {
+                uint32_t elapsed = now - start_time;
+                uint32_t next_due = next_step < scenario.steps.size() ? scenario.steps[next_step].at_ms : scenario.duration_ms;
+                wait_ms = std::min(wait_ms, next_due > elapsed ? next_due - elapsed : 0);
+            }
+            system.waitForEvent(wait_ms);
+        }
+
+        uint64_t cpu_ns = threadCpuNs() - cpu_before;
+        uint64_t allocs = allocation_count.load() - allocs_before;
+        uint32_t frames = ui.getFramesRendered() - frames_before;
+        uint32_t requests = reaper.getRequests() - requests_before;
+        uint32_t lost = reaper.getRequestsLost() - lost_before;
+        uint32_t script_runs = reaper.getScriptRuns() - script_runs_before;
+        double minutes = scenario.duration_ms / 60000.0;
+        uint32_t backup_requests = backup.getRequests() - backup_requests_before;
+        const LatencyHistogram &press_to_render = state_manager.getPressToRender();
+        const LatencyHistogram &press_to_confirm = state_manager.getPressToConfirm();
+
+        fprintf(stderr, "%-10s %-32s %7.1f requests/min (%u lost), %.1f script runs/min, %u frames, %.1f frames/min\n",
+                "scenario", scenario.name, requests / minutes, lost, script_runs / minutes, frames, frames / minutes);
+        if (http_manager.getHostCount() > 1)
+        {
+            const http::HostHealth &primary = http_manager.getHostHealth(0);
+            fprintf(stderr, "%-10s %-32s backup %.1f requests/min, primary %u failures, reading from host %zu at the end\n",
+                    "scenario", scenario.name, backup_requests / minutes, primary.failures.load(), http_manager.getActiveHost());
+        }
+        if (press_to_render.count() > 0)
+        {
+            fprintf(stderr, "%-10s %-32s press->render p50 %u ms p90 %u ms max %u ms, press->confirm p50 %u ms max %u ms (%u presses)\n",
+                    "scenario", scenario.name, press_to_render.percentileMs(50), press_to_render.percentileMs(90),
+                    press_to_render.maxMs(), press_to_confirm.percentileMs(50), press_to_confirm.maxMs(), press_to_render.count());
+        }
+        fprintf(stderr, "%-10s %-32s %8.1f us CPU/frame (render avg %u us, max %u us), %.2f allocs/frame, %.1f allocs/request\n",
+                "scenario", scenario.name, frames ? cpu_ns / 1000.0 / frames : 0.0, ui.getAverageFrameMicros(),
+                ui.getMaxFrameMicros(), frames ? (double)allocs / frames : 0.0, requests ? (double)allocs / requests : 0.0);
+    }
+
+    void runScenarioBench()
+    {
+        for (const Scenario &scenario : scenarios)
+        {
+            runScenario(scenario);
+        }
+    }
+
+} // namespace bench
+
+#endif // NATIVE_BENCH
@@ -1,32 +1,42 @@
 #include "button_handler.h"
 #include "http_job_manager.h"
+#include "state_manager.h"
+#include "config.h"
 #include "log.h"
 
 ButtonHandler::ButtonHandler(hal::IInputManager *input, http::HttpJobManager *http_manager, UIManager *ui)
     : input_mgr(input), http_job_manager(http_manager), ui_manager(ui),
-      current_reaper_state(nullptr), current_transport_state(nullptr)
+      state_manager(nullptr)
 {
 }
 
-void ButtonHandler::setStateReferences(reaper::ReaperState *reaper_state, reaper::TransportState *transport_state)
+uint32_t ButtonHandler::knownTabsDigest() const
 {
-    current_reaper_state = reaper_state;
-    current_transport_state = transport_state;
+    return state_manager ? state_manager->getReaperState().tabs_digest : 0;
 }
 
-bool ButtonHandler::handleButtonPress()
+bool ButtonHandler::handleButtonPress(unsigned long current_time)
 {
     if (!input_mgr || !http_job_manager || !ui_manager)
         return false;
 
+#if PERF_METRICS
+    if (handlePerfOverlayCombo(current_time))
+        return false;
+#endif
+    if (handleTabPickerHold(current_time))
+        return true;
+    bool stepped = handleTabStepRelease();
+
     // Check for button presses
     bool btn1_pressed = input_mgr->wasButtonPressed(0); // Button A
     bool btn2_pressed = input_mgr->wasButtonPressed(1); // Button B
     bool btn3_pressed = input_mgr->wasButtonPressed(2); // Button C
 
     if (!btn1_pressed && !btn2_pressed && !btn3_pressed)
-        return false;
+        return stepped;
 
+    press_time = current_time;
     UIState current_state = ui_manager->getCurrentUIState();
 
     switch (current_state)
@@ -40,11 +50,110 @@ bool ButtonHandler::handleButtonPress()
     case UIState::ARE_YOU_SURE:
         handleAreYouSureState();
         break;
+    case UIState::TAB_PICKER:
+        handleTabPickerState();
+        break;
     }
 
     return true; // Button was handled
 }
 
+#if PERF_METRICS
+bool ButtonHandler::handlePerfOverlayCombo(unsigned long current_time)
+{
+    if (!input_mgr->isButtonPressed(0) || !input_mgr->isButtonPressed(2))
+    {
+        combo_held = false;
+        return false;
+    }
+
+    if (!combo_held)
+    {
+        combo_held = true;
+        combo_fired = false;
+        combo_start = current_time;
+        next_tab_pending = false; // Part of the combo, not a step
+        previous_tab_pending = false;
+    }
+    else if (!combo_fired && current_time - combo_start >= PERF_OVERLAY_HOLD_MS)
+    {
+        combo_fired = true;
+        ui_manager->togglePerfOverlay(current_time);
+    }
+    return true;
+}
+#endif
+
+bool ButtonHandler::handleTabPickerHold(unsigned long current_time)
+{
+    if (ui_manager->getCurrentUIState() != UIState::STOPPED || !input_mgr->isButtonPressed(2) || input_mgr->isButtonPressed(0))
+    {
+        picker_held = false;
+        return false;
+    }
+
+    if (!picker_held)
+    {
+        picker_held = true;
+        picker_hold_fired = false;
+        picker_hold_start = current_time;
+    }
+    else if (!picker_hold_fired && current_time - picker_hold_start >= TAB_PICKER_HOLD_MS)
+    {
+        picker_hold_fired = true;
+        next_tab_pending = false; // A hold, not a step
+        if (state_manager && ui_manager->openTabPicker(state_manager->getReaperState(), current_time))
+        {
+            LOG_INFO("UI", "Setlist picker opened");
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ButtonHandler::handleTabStepRelease()
+{
+    bool previous_released = previous_tab_pending && !input_mgr->isButtonPressed(0);
+    bool next_released = next_tab_pending && !input_mgr->isButtonPressed(2);
+    if (!previous_released && !next_released)
+        return false;
+
+    // Released before a hold or the combo took it - an ordinary step, if still stopped
+    if (previous_released)
+        previous_tab_pending = false;
+    if (next_released)
+        next_tab_pending = false;
+    if (ui_manager->getCurrentUIState() != UIState::STOPPED)
+        return false;
+
+    if (previous_released)
+    {
+        press_time = previous_tab_press_time;
+        handlePreviousTab();
+    }
+    if (next_released)
+    {
+        press_time = next_tab_press_time;
+        handleNextTab();
+    }
+    return true;
+}
+
+uint32_t ButtonHandler::msUntilNextUpdate(unsigned long current_time) const
+{
+    if (picker_held && !picker_hold_fired)
+    {
+        return hal::msRemaining(current_time - picker_hold_start, TAB_PICKER_HOLD_MS);
+    }
+#if PERF_METRICS
+    if (combo_held && !combo_fired)
+    {
+        return hal::msRemaining(current_time - combo_start, PERF_OVERLAY_HOLD_MS);
+    }
+#endif
+    return UINT32_MAX;
+}
+
 void ButtonHandler::handleStoppedState()
 {
     bool btn1_pressed = input_mgr->wasButtonPressed(0);
@@ -53,7 +162,12 @@ void ButtonHandler::handleStoppedState()
 
     if (btn1_pressed)
     {
+#if PERF_METRICS
+        previous_tab_pending = true; // Stepped on release, unless it becomes the overlay combo
+        previous_tab_press_time = press_time;
+#else
         handlePreviousTab();
+#endif
     }
     else if (btn2_pressed)
     {
@@ -61,7 +175,8 @@ void ButtonHandler::handleStoppedState()
     }
     else if (btn3_pressed)
     {
-        handleNextTab();
+        next_tab_pending = true; // Stepped on release, unless the hold opens the picker
+        next_tab_press_time = press_time;
     }
 }
 
@@ -92,25 +207,59 @@ void ButtonHandler::handleAreYouSureState()
     }
 }
 
+void ButtonHandler::handleTabPickerState()
+{
+    bool btn1_pressed = input_mgr->wasButtonPressed(0);
+    bool btn2_pressed = input_mgr->wasButtonPressed(1);
+    bool btn3_pressed = input_mgr->wasButtonPressed(2);
+
+    if (btn2_pressed)
+    {
+        handleJumpToTab();
+    }
+    else if ((btn1_pressed || btn3_pressed) && state_manager)
+    {
+        ui_manager->moveTabPicker(state_manager->getReaperState(), btn1_pressed ? -1 : 1, press_time);
+    }
+}
+
 void ButtonHandler::handlePreviousTab()
 {
     LOG_INFO("UI", "Previous tab");
     awaiting_state_update = true;
-    http_job_manager->submitChangeTabJob(http::TabDirection::PREVIOUS);
+    uint32_t job_id = http_job_manager->submitChangeTabJob(http::TabDirection::PREVIOUS, knownTabsDigest());
+#if OPTIMISTIC_UPDATES
+    if (state_manager)
+    {
+        state_manager->applyTabChange(-1, job_id, press_time);
+    }
+#endif
 }
 
 void ButtonHandler::handlePlay()
 {
     LOG_INFO("UI", "Play");
     awaiting_transport_update = true;
-    http_job_manager->submitChangePlaystateJob(http::PlayAction::PLAY);
+    uint32_t job_id = http_job_manager->submitChangePlaystateJob(http::PlayAction::PLAY);
+#if OPTIMISTIC_UPDATES
+    if (state_manager)
+    {
+        state_manager->applyPlayState(1, job_id, press_time);
+    }
+#endif
 }
 
 void ButtonHandler::handleNextTab()
 {
     LOG_INFO("UI", "Next tab");
     awaiting_state_update = true;
-    http_job_manager->submitChangeTabJob(http::TabDirection::NEXT);
+    uint32_t job_id = http_job_manager->submitChangeTabJob(http::TabDirection::NEXT, knownTabsDigest());
+#if OPTIMISTIC_UPDATES
+    if (state_manager)
+    {
+        state_manager->applyTabChange(1, job_id, press_time);
+    }
+#endif
 }
 
 void ButtonHandler::handleStopConfirmation()
@@ -123,7 +272,38 @@ void ButtonHandler::handleStop()
 {
     LOG_INFO("UI", "Stop confirmed");
     awaiting_transport_update = true;
-    http_job_manager->submitChangePlaystateJob(http::PlayAction::STOP);
+    uint32_t job_id = http_job_manager->submitChangePlaystateJob(http::PlayAction::STOP);
+#if OPTIMISTIC_UPDATES
+    if (state_manager)
+    {
+        state_manager->applyPlayState(0, job_id, press_time);
+    }
+#endif
+}
+
+void ButtonHandler::handleJumpToTab()
+{
+    ui_manager->setUIState(UIState::STOPPED);
+    if (!state_manager)
+        return;
+
+    // One request however far the jump, rather than a tab change per step
+    const reaper::ReaperState &state = state_manager->getReaperState();
+    unsigned int target = ui_manager->getTabPickerSelection();
+    unsigned int tab_count = (unsigned int)state.tabCount();
+    if (!state.success || target >= tab_count || target == state.active_index)
+        return;
+
+    LOG_INFO("UI", "Jump to tab %u", target + 1);
+    awaiting_state_update = true;
+    int steps = http::ChangeTabJob::stepsBetween(state.active_index, target, tab_count);
+    uint32_t job_id = http_job_manager->submitJumpToTabJob(target, state.active_index, tab_count, knownTabsDigest());
+#if OPTIMISTIC_UPDATES
+    state_manager->applyTabChange(steps, job_id, press_time);
+#else
+    (void)steps;
+    (void)job_id;
+#endif
 }
 
 void ButtonHandler::handleCancel()
@@ -1,6 +1,9 @@
 #include "http_job_manager.h"
 #include "network_manager.h"
 #include "log.h"
+#include "perf_metrics.h"
+#include "config.h"
+#include <algorithm>
 #include <atomic>
 #include <stdexcept>
 
@@ -8,79 +11,93 @@ namespace http
 {
 
 #ifdef ARDUINO
-    // Queue sizes for FreeRTOS
-    static const int JOB_QUEUE_SIZE = 10;
-    static const int RESULT_QUEUE_SIZE = 10;
+    // Worker task configuration for FreeRTOS
     static const int WORKER_STACK_SIZE = 8192;
     static const int WORKER_PRIORITY = 1;
+    static const TickType_t WORKER_IDLE_WAIT = pdMS_TO_TICKS(100); // Re-check worker_running while idle
 #endif
 
     // HttpJobManager implementation
-    HttpJobManager::HttpJobManager(hal::ISystemHAL *system, NetworkManager *network, const std::string &reaper_base_url)
-        : system_hal(system), network_manager(network), base_url(reaper_base_url),
-          wifi_connected(false), last_wifi_attempt(0), last_action_id_attempt(0),
-          next_job_id(1), worker_running(false)
-#ifdef ARDUINO
-          ,
-          job_queue(nullptr), main_result_queue(nullptr), worker_task_handle(nullptr)
-#else
+    HttpJobManager::HttpJobManager(hal::ISystemHAL *system, NetworkManager *network, const std::string &reaper_base_url,
+                                   const std::string &backup_base_url)
+        : system_hal(system), network_manager(network),
+          wifi_connected(false), last_wifi_attempt(0), last_action_id_attempt(0), setlist_live(false),
+          next_job_id(1), worker_running(false),
+          pending_transport_job(0), pending_status_job(0),
+          pending_tab_steps(NO_PENDING_TAB_CHANGE), pending_tab_job(0)
+#ifndef ARDUINO
           ,
           should_stop(false)
 #endif
     {
         LOG_INFO("HttpJobManager", "Initializing HTTP job manager");
 
-#ifdef ARDUINO
-        // Create FreeRTOS queue for jobs
-        job_queue = xQueueCreate(JOB_QUEUE_SIZE, sizeof(HttpJob *));
-        if (!job_queue)
-        {
-            LOG_ERROR("HttpJobManager", "Failed to create job queue");
-            throw std::runtime_error("Failed to create job queue");
+        // The first worker serves everything the user worker (if any) does not
+        Worker &main_worker = workers[0];
+        main_worker.manager = this;
+        main_worker.network = &system_hal->getNetworkManager();
+        main_worker.name = "http_worker";
+        main_worker.first_priority = WORKER_COUNT > 1 ? JobPriority::TRANSPORT : JobPriority::USER;
+        main_worker.last_priority = JobPriority::BACKGROUND;
+        if (WORKER_COUNT > 1)
+        {
+            Worker &user_worker = workers[WORKER_COUNT - 1];
+            user_worker.manager = this;
+            user_worker.network = &system_hal->getUserNetworkManager();
+            user_worker.name = "http_user_worker";
+            user_worker.first_priority = JobPriority::USER;
+            user_worker.last_priority = JobPriority::USER;
+        }
+
+        hosts[0].base_url = reaper_base_url;
+        hosts[0].network = &system_hal->getNetworkManager();
+        if (!backup_base_url.empty())
+        {
+            // Mirroring pipelines over the worker's connection to each host, so it needs the one worker
+            if (WORKER_COUNT > 1)
+            {
+                LOG_ERROR("HttpJobManager", "A backup host needs HTTP_USER_WORKER disabled, ignoring %s", backup_base_url.c_str());
+            }
+            else
+            {
+                hosts[1].base_url = backup_base_url;
+                hosts[1].network = &system_hal->getBackupNetworkManager();
+                host_count = 2;
+                LOG_INFO("HttpJobManager", "Following backup host %s", backup_base_url.c_str());
+            }
         }
-
-        // Create FreeRTOS queue for results (main thread receives from this)
-        main_result_queue = xQueueCreate(RESULT_QUEUE_SIZE, sizeof(HttpJobResult *));
-        if (!main_result_queue)
+        for (size_t host = 0; host < host_count; ++host)
         {
-            LOG_ERROR("HttpJobManager", "Failed to create result queue");
-            vQueueDelete(job_queue);
-            job_queue = nullptr;
-            throw std::runtime_error("Failed to create result queue");
+            hosts[host].base = hosts[host].base_url + "/";
+            hosts[host].request_urls = std::make_shared<const RequestUrls>(hosts[host].base_url, hosts[host].script_action_id);
         }
 
-        // Create worker task
-        BaseType_t result = xTaskCreate(
-            workerTaskWrapper,
-            "http_worker",
-            WORKER_STACK_SIZE,
-            this,
-            WORKER_PRIORITY,
-            &worker_task_handle);
-
-        if (result != pdPASS)
+        // Known from before deep sleep, so the wake does not wait on GetScriptActionIdJob
+        const char *cached_script_action_id = system_hal->getCachedScriptActionId();
+        if (cached_script_action_id[0] != '\0')
         {
-            LOG_ERROR("HttpJobManager", "Failed to create worker task");
-            vQueueDelete(job_queue);
-            vQueueDelete(main_result_queue);
-            job_queue = nullptr;
-            main_result_queue = nullptr;
-            throw std::runtime_error("Failed to create worker task");
+            hosts[0].script_action_id = cached_script_action_id;
+            hosts[0].request_urls = std::make_shared<const RequestUrls>(hosts[0].base_url, hosts[0].script_action_id);
+            LOG_INFO("HttpJobManager", "Using cached script action ID %s", cached_script_action_id);
         }
-#else
-        // Create worker thread
+
+        worker_running = true;
         try
         {
-            worker_thread = std::thread(&HttpJobManager::workerThreadFunction, this);
+            for (Worker &worker : workers)
+            {
+                startWorker(worker);
+            }
         }
-        catch (const std::exception &e)
+        catch (const std::exception &)
         {
-            LOG_ERROR("HttpJobManager", "Failed to create worker thread: %s", e.what());
+            shutdown(); // Stop any worker already started
             throw;
         }
-#endif
 
-        worker_running = true;
+#if REAPER_PUSH_PORT
+        push_listener.reset(new PushListener(system_hal, REAPER_PUSH_PORT));
+#endif
 
         // Submit WiFi connection job as the first job
         uint32_t wifi_job_id = submitWiFiConnectJob();
@@ -101,32 +118,29 @@ namespace http
 
         LOG_INFO("HttpJobManager", "Shutting down HTTP job manager");
         worker_running = false;
+        push_listener.reset();
 
 #ifdef ARDUINO
-        if (worker_task_handle)
-        {
-            vTaskDelete(worker_task_handle);
-            worker_task_handle = nullptr;
-        }
-
-        if (job_queue)
+        for (Worker &worker : workers)
         {
-            vQueueDelete(job_queue);
-            job_queue = nullptr;
-        }
-
-        if (main_result_queue)
-        {
-            vQueueDelete(main_result_queue);
-            main_result_queue = nullptr;
+            if (worker.task_handle)
+            {
+                vTaskDelete(worker.task_handle);
+                worker.task_handle = nullptr;
+            }
         }
 #else
         should_stop = true;
-        job_available.notify_all();
-
-        if (worker_thread.joinable())
+        for (Worker &worker : workers)
         {
-            worker_thread.join();
+            {
+                std::lock_guard<std::mutex> lock(worker.idle_mutex);
+                worker.job_available.notify_all();
+            }
+            if (worker.thread.joinable())
+            {
+                worker.thread.join();
+            }
         }
 #endif
 
@@ -138,55 +152,105 @@ namespace http
         return next_job_id.fetch_add(1);
     }
 
-    void HttpJobManager::sendResult(std::unique_ptr<HttpJobResult> result)
+    void HttpJobManager::startWorker(Worker &worker)
     {
-        // Worker thread sends result to main thread's queue
 #ifdef ARDUINO
-        HttpJobResult *result_ptr = result.release();
-        if (xQueueSend(main_result_queue, &result_ptr, 0) != pdTRUE)
+        BaseType_t result = xTaskCreate(
+            workerTaskWrapper,
+            worker.name,
+            WORKER_STACK_SIZE,
+            &worker,
+            WORKER_PRIORITY,
+            &worker.task_handle);
+
+        if (result != pdPASS)
         {
-            LOG_ERROR("HttpJobManager", "Failed to send result for job %d - main queue full", result_ptr->job_id);
-            delete result_ptr; // Clean up if queue is full
+            LOG_ERROR("HttpJobManager", "Failed to create %s task", worker.name);
+            throw std::runtime_error("Failed to create worker task");
         }
 #else
-        std::lock_guard<std::mutex> lock(results_mutex);
-        results.push(std::move(result));
+        try
+        {
+            worker.thread = std::thread(&HttpJobManager::workerLoop, this, std::ref(worker));
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("HttpJobManager", "Failed to create %s thread: %s", worker.name, e.what());
+            throw;
+        }
 #endif
     }
 
-    uint32_t HttpJobManager::submitWiFiConnectJob()
+    HttpJobManager::Worker &HttpJobManager::workerFor(JobPriority priority)
     {
-        if (!worker_running)
+        return priority < workers[0].first_priority ? workers[WORKER_COUNT - 1] : workers[0];
+    }
+
+    bool HttpJobManager::isHostUsable(size_t host) const
+    {
+        return !hosts[host].script_action_id.empty() &&
+               hosts[host].health.consecutive_failures.load(std::memory_order_relaxed) < HOST_FAILOVER_FAILURES;
+    }
+
+    size_t HttpJobManager::selectActiveHost()
+    {
+        if (host_count < 2 || (active_host == 0 && isHostUsable(0)))
         {
-            LOG_ERROR("HttpJobManager", "Cannot submit job - worker not running");
-            return 0;
+            return active_host;
         }
 
-        uint32_t job_id = generateJobId();
-        auto job = std::unique_ptr<WiFiConnectJob>(new WiFiConnectJob(job_id, network_manager));
-        job->timestamp = system_hal->getMillis();
-
-#ifdef ARDUINO
-        HttpJob *job_ptr = job.release();
-        if (xQueueSend(job_queue, &job_ptr, 0) != pdTRUE)
+        // The primary is taken back as soon as it answers again
+        for (size_t host = 0; host < host_count; ++host)
         {
-            LOG_ERROR("HttpJobManager", "Failed to submit WiFi connect job - queue full");
-            delete job_ptr;
-            return 0;
+            if (isHostUsable(host))
+            {
+                if (host != active_host)
+                {
+                    LOG_WARNING("HttpJobManager", "Reading from %s host %s", host == 0 ? "primary" : "backup",
+                                hosts[host].base_url.c_str());
+                    active_host = host;
+                }
+                break;
+            }
         }
-#else
+        return active_host;
+    }
+
+    size_t HttpJobManager::collectMirrors(size_t host, MirrorHost *mirrors)
+    {
+        uint32_t now = system_hal->getMillis();
+        size_t count = 0;
+        for (size_t other = 0; other < host_count; ++other)
         {
-            std::lock_guard<std::mutex> lock(job_queue_mutex);
-            job_queue.push(std::move(job));
+            Host &mirror = hosts[other];
+            if (other == host)
+            {
+                continue;
+            }
+            bool down = mirror.health.consecutive_failures.load(std::memory_order_relaxed) >= HOST_FAILOVER_FAILURES;
+            if (down && now - mirror.last_mirrored < HOST_PROBE_INTERVAL_MS)
+            {
+                continue;
+            }
+            mirror.last_mirrored = now;
+            mirrors[count++] = MirrorHost{mirror.network, &mirror.base, &mirror.health, &mirror.mirror_response};
         }
-        job_available.notify_one();
-#endif
+        return count;
+    }
 
-        LOG_DEBUG("HttpJobManager", "Submitted WiFi connect job %d", job_id);
-        return job_id;
+    void HttpJobManager::sendResult(Worker &worker, HttpJobResult &&result)
+    {
+        // Worker thread sends result to main thread's ring
+        if (!worker.result_queue.push(std::move(result)))
+        {
+            LOG_ERROR("HttpJobManager", "Failed to send result for job %u - main queue full", result.job_id);
+            results_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        system_hal->signalEvent(); // Wake the main loop to process it
     }
 
-    uint32_t HttpJobManager::submitChangeTabJob(TabDirection direction)
+    uint32_t HttpJobManager::submitJob(uint32_t job_id, JobPayload &&payload, size_t host)
     {
         if (!worker_running)
         {
@@ -194,32 +258,46 @@ namespace http
             return 0;
         }
 
-        uint32_t job_id = generateJobId();
-        auto job = std::unique_ptr<ChangeTabJob>(new ChangeTabJob(job_id, direction, script_action_id));
-        job->timestamp = system_hal->getMillis();
+        HttpJob job;
+        job.job_id = job_id;
+        job.timestamp = system_hal->getMillis();
+        job.payload = std::move(payload);
+        job.urls = hosts[host].request_urls;
+        job.host = (uint8_t)host;
 
-#ifdef ARDUINO
-        HttpJob *job_ptr = job.release();
-        if (xQueueSend(job_queue, &job_ptr, 0) != pdTRUE)
+        const char *name = job.name();
+        JobPriority priority = jobPriority(job.type());
+        if (!job_queues[(size_t)priority].push(std::move(job)))
         {
-            LOG_ERROR("HttpJobManager", "Failed to submit change tab job - queue full");
-            delete job_ptr;
+            LOG_ERROR("HttpJobManager", "Failed to submit %s job - %s queue full", name, jobPriorityName(priority));
+            jobs_rejected++;
             return 0;
         }
+        PERF_RECORD(perf::Metric::QUEUE_DEPTH, getQueuedJobs());
+
+        Worker &worker = workerFor(priority);
+#ifdef ARDUINO
+        xTaskNotifyGive(worker.task_handle);
 #else
+        // Pairs with the fence in waitForJob(): either the worker sees the new job before it
+        // sleeps, or we see it idle and wake it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (worker.idle.load(std::memory_order_relaxed))
         {
-            std::lock_guard<std::mutex> lock(job_queue_mutex);
-            job_queue.push(std::move(job));
+            std::lock_guard<std::mutex> lock(worker.idle_mutex);
+            worker.job_available.notify_one();
         }
-        job_available.notify_one();
 #endif
-
-        LOG_DEBUG("HttpJobManager", "Submitted change tab job %d (direction: %s)",
-                  job_id, direction == TabDirection::NEXT ? "NEXT" : "PREVIOUS");
+        LOG_DEBUG("HttpJobManager", "Submitted %s job %u", name, job_id);
         return job_id;
     }
 
-    uint32_t HttpJobManager::submitChangePlaystateJob(PlayAction action)
+    uint32_t HttpJobManager::submitWiFiConnectJob()
+    {
+        return submitJob(WiFiConnectJob{network_manager});
+    }
+
+    uint32_t HttpJobManager::submitChangeTabJob(TabDirection direction, uint32_t known_tabs_digest)
     {
         if (!worker_running)
         {
@@ -227,64 +305,83 @@ namespace http
             return 0;
         }
 
-        uint32_t job_id = generateJobId();
-        auto job = std::unique_ptr<ChangePlaystateJob>(new ChangePlaystateJob(job_id, action));
-        job->timestamp = system_hal->getMillis();
+        int32_t delta = (direction == TabDirection::NEXT) ? 1 : -1;
 
-#ifdef ARDUINO
-        HttpJob *job_ptr = job.release();
-        if (xQueueSend(job_queue, &job_ptr, 0) != pdTRUE)
+        // Fold into a tab change that is still waiting in the queue
+        int32_t steps = pending_tab_steps.load();
+        while (steps != NO_PENDING_TAB_CHANGE)
         {
-            LOG_ERROR("HttpJobManager", "Failed to submit change playstate job - queue full");
-            delete job_ptr;
-            return 0;
+            int32_t folded = steps + delta;
+            if (folded > ChangeTabJob::MAX_STEPS || folded < -ChangeTabJob::MAX_STEPS)
+            {
+                // The queued job is at its limit - the press is dropped, not folded, so nothing is
+                // applied optimistically for it either
+                LOG_WARNING("HttpJobManager", "Tab press dropped, queued job %u already at %d steps", pending_tab_job, (int)steps);
+                return 0;
+            }
+            if (pending_tab_steps.compare_exchange_weak(steps, folded))
+            {
+                coalesce_stats.tab_presses_folded++;
+                LOG_DEBUG("HttpJobManager", "Folded tab press into queued job %u (net steps: %d)", pending_tab_job, (int)folded);
+                return pending_tab_job;
+            }
         }
-#else
+
+        // No tab job can be in the queue here, so the worker cannot claim these steps before the push
+        uint32_t job_id = generateJobId();
+        pending_tab_job = job_id;
+        pending_tab_steps.store(delta);
+        if (submitJob(job_id, ChangeTabJob{delta, known_tabs_digest}) == 0)
         {
-            std::lock_guard<std::mutex> lock(job_queue_mutex);
-            job_queue.push(std::move(job));
+            pending_tab_steps.store(NO_PENDING_TAB_CHANGE);
+            return 0;
         }
-        job_available.notify_one();
-#endif
-
-        LOG_DEBUG("HttpJobManager", "Submitted change playstate job %d (action: %d)",
-                  job_id, static_cast<int>(action));
         return job_id;
     }
 
-    uint32_t HttpJobManager::submitGetStatusJob()
+    uint32_t HttpJobManager::submitJumpToTabJob(unsigned int target_index, unsigned int current_index, unsigned int tab_count,
+                                                uint32_t known_tabs_digest)
     {
         if (!worker_running)
         {
             LOG_ERROR("HttpJobManager", "Cannot submit job - worker not running");
             return 0;
         }
+        if (target_index >= tab_count)
+        {
+            LOG_ERROR("HttpJobManager", "Cannot jump to tab %u of %u", target_index, tab_count);
+            return 0;
+        }
 
-        uint32_t job_id = generateJobId();
-        auto job = std::unique_ptr<GetStatusJob>(new GetStatusJob(job_id, script_action_id));
-        job->timestamp = system_hal->getMillis();
+        ChangeTabJob job;
+        job.steps = ChangeTabJob::stepsBetween(current_index, target_index, tab_count);
+        job.known_tabs_digest = known_tabs_digest;
+        job.target_index = (int)target_index;
+        job.tab_count = tab_count;
+        LOG_DEBUG("HttpJobManager", "Jumping to tab %u (steps: %d)", target_index, job.steps);
+        return submitJob(std::move(job));
+    }
 
-#ifdef ARDUINO
-        HttpJob *job_ptr = job.release();
-        if (xQueueSend(job_queue, &job_ptr, 0) != pdTRUE)
+    uint32_t HttpJobManager::submitChangePlaystateJob(PlayAction action)
+    {
+        if (!worker_running)
         {
-            LOG_ERROR("HttpJobManager", "Failed to submit get status job - queue full");
-            delete job_ptr;
+            LOG_ERROR("HttpJobManager", "Cannot submit job - worker not running");
             return 0;
         }
-#else
+
+        // The playstate batch returns TRANSPORT, so a queued transport poll is redundant
+        uint32_t superseded_id = pending_transport_job.exchange(0);
+        if (superseded_id != 0)
         {
-            std::lock_guard<std::mutex> lock(job_queue_mutex);
-            job_queue.push(std::move(job));
+            coalesce_stats.transport_jobs_dropped++;
+            LOG_DEBUG("HttpJobManager", "Dropped queued transport job %u", superseded_id);
         }
-        job_available.notify_one();
-#endif
 
-        LOG_DEBUG("HttpJobManager", "Submitted get status job %d", job_id);
-        return job_id;
+        return submitJob(ChangePlaystateJob{action});
     }
 
-    uint32_t HttpJobManager::submitGetScriptActionIdJob()
+    uint32_t HttpJobManager::submitGetStatusJob(uint32_t known_tabs_digest)
     {
         if (!worker_running)
         {
@@ -292,30 +389,35 @@ namespace http
             return 0;
         }
 
-        uint32_t job_id = generateJobId();
-        auto job = std::unique_ptr<GetScriptActionIdJob>(new GetScriptActionIdJob(job_id));
-        job->timestamp = system_hal->getMillis();
-
-#ifdef ARDUINO
-        HttpJob *job_ptr = job.release();
-        if (xQueueSend(job_queue, &job_ptr, 0) != pdTRUE)
+        uint32_t pending_id = pending_status_job.load();
+        if (pending_id != 0)
         {
-            LOG_ERROR("HttpJobManager", "Failed to submit get script action ID job - queue full");
-            delete job_ptr;
-            return 0;
+            coalesce_stats.read_jobs_merged++;
+            LOG_DEBUG("HttpJobManager", "Merged get status request into queued job %u", pending_id);
+            return pending_id;
         }
-#else
+
+        // Status includes the transport state - a queued transport poll is redundant
+        if (pending_transport_job.exchange(0) != 0)
         {
-            std::lock_guard<std::mutex> lock(job_queue_mutex);
-            job_queue.push(std::move(job));
+            coalesce_stats.read_jobs_merged++;
         }
-        job_available.notify_one();
-#endif
 
-        LOG_DEBUG("HttpJobManager", "Submitted get script action ID job %d", job_id);
+        uint32_t job_id = generateJobId();
+        pending_status_job.store(job_id);
+        if (submitJob(job_id, GetStatusJob{known_tabs_digest}) == 0)
+        {
+            pending_status_job.store(0);
+            return 0;
+        }
         return job_id;
     }
 
+    uint32_t HttpJobManager::submitGetScriptActionIdJob()
+    {
+        return submitJob(GetScriptActionIdJob{});
+    }
+
     uint32_t HttpJobManager::submitGetTransportJob()
     {
         if (!worker_running)
@@ -324,28 +426,37 @@ namespace http
             return 0;
         }
 
-        uint32_t job_id = generateJobId();
-        auto job = std::unique_ptr<GetTransportJob>(new GetTransportJob(job_id));
-        job->timestamp = system_hal->getMillis();
+        // A queued status or transport poll will already return the transport state
+        uint32_t pending_id = pending_status_job.load();
+        if (pending_id == 0)
+        {
+            pending_id = pending_transport_job.load();
+        }
+        if (pending_id != 0)
+        {
+            coalesce_stats.read_jobs_merged++;
+            LOG_DEBUG("HttpJobManager", "Merged get transport request into queued job %u", pending_id);
+            return pending_id;
+        }
 
-#ifdef ARDUINO
-        HttpJob *job_ptr = job.release();
-        if (xQueueSend(job_queue, &job_ptr, 0) != pdTRUE)
+        uint32_t job_id = generateJobId();
+        pending_transport_job.store(job_id);
+        if (submitJob(job_id, GetTransportJob{}) == 0)
         {
-            LOG_ERROR("HttpJobManager", "Failed to submit get transport job - queue full");
-            delete job_ptr;
+            pending_transport_job.store(0);
             return 0;
         }
-#else
+        return job_id;
+    }
+
+    uint32_t HttpJobManager::submitSubscribeJob()
+    {
+        if (!push_listener)
         {
-            std::lock_guard<std::mutex> lock(job_queue_mutex);
-            job_queue.push(std::move(job));
+            return 0;
         }
-        job_available.notify_one();
-#endif
 
-        LOG_DEBUG("HttpJobManager", "Submitted get transport job {}", job_id);
-        return job_id;
+        return submitJob(SubscribeJob{push_listener->getPort()});
     }
 
     void HttpJobManager::checkAndRetryConnections(uint32_t current_time)
@@ -365,7 +476,7 @@ namespace http
             }
         }
         // If WiFi is connected but we don't have script action ID, retry that
-        else if (wifi_connected.load() && script_action_id.empty())
+        else if (wifi_connected.load() && getScriptActionId().empty())
         {
             uint32_t last_attempt = last_action_id_attempt.load();
             if (current_time - last_attempt >= SCRIPT_ID_RETRY_INTERVAL_MS)
@@ -375,130 +486,260 @@ namespace http
                 last_action_id_attempt.store(current_time);
             }
         }
+        // Register (and keep renewing) the push target once the script is reachable
+        else if (push_listener && (!subscribe_requested || current_time - last_subscribe_attempt >= PUSH_SUBSCRIBE_INTERVAL_MS))
+        {
+            if (submitSubscribeJob() != 0)
+            {
+                subscribe_requested = true;
+                last_subscribe_attempt = current_time;
+            }
+        }
+
+        // Look the standby's script action ID up ahead of time, failing over must not wait on it
+        if (wifi_connected.load() && !getScriptActionId().empty() && !memory_degraded && hasStandbyWithoutScriptId() &&
+            current_time - last_action_id_attempt.load() >= SCRIPT_ID_RETRY_INTERVAL_MS)
+        {
+            for (size_t host = 0; host < host_count; ++host)
+            {
+                if (host != active_host && hosts[host].script_action_id.empty())
+                {
+                    LOG_DEBUG("HttpJobManager", "Requesting script action ID from %s", hosts[host].base_url.c_str());
+                    submitJob(generateJobId(), GetScriptActionIdJob{}, host);
+                }
+            }
+            last_action_id_attempt.store(current_time);
+        }
     }
 
-    std::vector<std::unique_ptr<HttpJobResult>> HttpJobManager::processResults()
+    bool HttpJobManager::hasStandbyWithoutScriptId() const
     {
-        std::vector<std::unique_ptr<HttpJobResult>> results_vec;
+        for (size_t host = 0; host < host_count; ++host)
+        {
+            if (host != active_host && hosts[host].script_action_id.empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
 
+    uint32_t HttpJobManager::msUntilNextUpdate(uint32_t current_time) const
+    {
         if (!worker_running)
-            return results_vec;
+            return hal::NO_DEADLINE;
 
-#ifdef ARDUINO
-        HttpJobResult *result_ptr;
-        while (xQueueReceive(main_result_queue, &result_ptr, 0) == pdTRUE)
+        if (!wifi_connected.load())
         {
-            LOG_DEBUG("HttpJobManager", "Processing result for job {}", result_ptr->job_id);
-            results_vec.emplace_back(result_ptr);
+            return hal::msRemaining(current_time - last_wifi_attempt.load(), WIFI_RETRY_INTERVAL_MS);
         }
-#else
-        std::lock_guard<std::mutex> lock(results_mutex);
-        while (!results.empty())
+        if (getScriptActionId().empty())
         {
-            auto result = std::move(results.front());
-            results.pop();
-            LOG_DEBUG("HttpJobManager", "Processing result for job {}", result->job_id);
-            results_vec.push_back(std::move(result));
+            return hal::msRemaining(current_time - last_action_id_attempt.load(), SCRIPT_ID_RETRY_INTERVAL_MS);
         }
-#endif
+        uint32_t deadline = hal::NO_DEADLINE;
+        if (!memory_degraded && hasStandbyWithoutScriptId())
+        {
+            deadline = hal::msRemaining(current_time - last_action_id_attempt.load(), SCRIPT_ID_RETRY_INTERVAL_MS);
+        }
+        if (push_listener)
+        {
+            deadline = std::min(deadline, subscribe_requested ? hal::msRemaining(current_time - last_subscribe_attempt, PUSH_SUBSCRIBE_INTERVAL_MS) : 0);
+        }
+        return deadline;
+    }
 
-        return results_vec;
+    bool HttpJobManager::nextResult(HttpJobResult &result)
+    {
+        if (!worker_running)
+            return false;
+
+        for (Worker &worker : workers)
+        {
+            if (worker.result_queue.pop(result))
+            {
+                LOG_DEBUG("HttpJobManager", "Processing result for job %u", result.job_id);
+                return true;
+            }
+        }
+        return push_listener && push_listener->nextResult(result);
     }
 
-#ifdef ARDUINO
-    void HttpJobManager::workerTaskWrapper(void *parameter)
+    hal::HttpStats HttpJobManager::getHttpStats() const
     {
-        HttpJobManager *manager = static_cast<HttpJobManager *>(parameter);
-        manager->workerTask();
-        vTaskDelete(nullptr);
+        hal::HttpStats stats = system_hal->getNetworkManager().getHttpStats();
+        // Totals cover every connection, the last_* fields stay those of the main one
+        auto add = [&stats](const hal::HttpStats &other)
+        {
+            stats.requests += other.requests;
+            stats.failures += other.failures;
+            stats.connections_opened += other.connections_opened;
+            stats.reconnects += other.reconnects;
+            stats.total_connect_ms += other.total_connect_ms;
+            stats.total_ttfb_ms += other.total_ttfb_ms;
+        };
+        if (WORKER_COUNT > 1)
+        {
+            add(system_hal->getUserNetworkManager().getHttpStats());
+        }
+        if (host_count > 1)
+        {
+            add(system_hal->getBackupNetworkManager().getHttpStats());
+        }
+        return stats;
+    }
+
+    bool HttpJobManager::popJob(Worker &worker, HttpJob &job)
+    {
+        for (size_t priority = (size_t)worker.first_priority; priority <= (size_t)worker.last_priority; ++priority)
+        {
+            if (job_queues[priority].pop(job))
+            {
+                queue_wait[priority].record(system_hal->getMillis() - job.timestamp);
+                return true;
+            }
+        }
+        return false;
     }
 
-    void HttpJobManager::workerTask()
+    bool HttpJobManager::hasJob(Worker &worker) const
     {
-        LOG_INFO("HttpJobManager", "Worker task started");
-        HttpJob *job_ptr;
+        for (size_t priority = (size_t)worker.first_priority; priority <= (size_t)worker.last_priority; ++priority)
+        {
+            if (!job_queues[priority].empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
 
-        while (worker_running)
+    bool HttpJobManager::claimJob(HttpJob &job)
+    {
+        switch (job.type())
         {
-            if (xQueueReceive(job_queue, &job_ptr, pdMS_TO_TICKS(100)) == pdTRUE)
+        case JobType::GET_TRANSPORT:
+        {
+            uint32_t expected = job.job_id;
+            return pending_transport_job.compare_exchange_strong(expected, 0);
+        }
+        case JobType::GET_STATUS:
+        {
+            uint32_t expected = job.job_id;
+            return pending_status_job.compare_exchange_strong(expected, 0);
+        }
+        case JobType::CHANGE_TAB:
+        {
+            // Take every press folded in so far, later presses start a new job. Jumps are never
+            // folded into, the presses belong to the job announced under pending_tab_job.
+            ChangeTabJob &change_tab = std::get<ChangeTabJob>(job.payload);
+            if (change_tab.target_index >= 0)
+            {
+                return true;
+            }
+            int32_t steps = pending_tab_steps.exchange(NO_PENDING_TAB_CHANGE);
+            if (steps != NO_PENDING_TAB_CHANGE)
             {
-                LOG_DEBUG("HttpJobManager", "Processing job {} of type {}", job_ptr->job_id, job_ptr->getJobTypeName());
+                change_tab.steps = steps;
+            }
+            return true;
+        }
+        default:
+            return true;
+        }
+    }
+
+    void HttpJobManager::executeJob(Worker &worker, HttpJob &job)
+    {
+        if (!claimJob(job))
+        {
+            LOG_DEBUG("HttpJobManager", "Skipping superseded job %u of type %s", job.job_id, job.name());
+            return;
+        }
 
-                // Execute the job
-                auto result = job_ptr->execute(&system_hal->getNetworkManager(), base_url);
-                result->timestamp = system_hal->getMillis();
+        LOG_DEBUG("HttpJobManager", "Processing job %u of type %s", job.job_id, job.name());
 
-                // Update connection state if this was a WiFi job
-                if (result->result_type == http::ResultType::WIFI_CONNECT)
-                {
-                    auto wifi_result = static_cast<http::WiFiConnectResult *>(result.get());
-                    wifi_connected.store(wifi_result->connected);
-                    if (wifi_result->connected)
-                    {
-                        last_wifi_attempt.store(0); // Reset retry timer
-                    }
-                }
+        // Execute the job
+        // Only jobs with transport or tab commands, or a status read to probe with, use the mirrors
+        Host &host = hosts[job.host];
+        MirrorHost mirrors[MAX_HOSTS];
+        JobType type = job.type();
+        bool mirrored = type == JobType::CHANGE_TAB || type == JobType::CHANGE_PLAYSTATE || type == JobType::GET_STATUS;
+        size_t mirror_count = mirrored ? collectMirrors(job.host, mirrors) : 0;
 
-                // Send result back
-                sendResult(std::move(result));
+        hal::INetworkManager *network = job.host == 0 ? worker.network : host.network;
+        JobContext context{network, *job.urls, worker.response, type, setlist_live, host.health, mirrors, mirror_count};
+        HttpJobResult result;
+        runJob(job, context, result);
+        result.timestamp = system_hal->getMillis();
 
-                delete job_ptr;
+        if (auto script_result = std::get_if<GetScriptActionIdResult>(&result.payload))
+        {
+            script_result->host = job.host;
+        }
+
+        // Update connection state if this was a WiFi job
+        if (auto wifi_result = std::get_if<WiFiConnectResult>(&result.payload))
+        {
+            wifi_connected.store(wifi_result->connected);
+            if (wifi_result->connected)
+            {
+                last_wifi_attempt.store(0); // Reset retry timer
             }
         }
 
-        LOG_INFO("HttpJobManager", "Worker task ended");
+        // Send result back
+        sendResult(worker, std::move(result));
+    }
+
+#ifdef ARDUINO
+    void HttpJobManager::workerTaskWrapper(void *parameter)
+    {
+        Worker *worker = static_cast<Worker *>(parameter);
+        worker->manager->workerLoop(*worker);
+        vTaskDelete(nullptr);
     }
 #else
-    void HttpJobManager::workerThreadFunction()
+    void HttpJobManager::waitForJob(Worker &worker)
+    {
+        std::unique_lock<std::mutex> lock(worker.idle_mutex);
+        worker.idle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        worker.job_available.wait(lock, [this, &worker]
+                                  { return hasJob(worker) || should_stop; });
+        worker.idle.store(false, std::memory_order_relaxed);
+    }
+#endif
+
+    void HttpJobManager::workerLoop(Worker &worker)
     {
-        LOG_INFO("HttpJobManager", "Worker thread started");
+        LOG_INFO("HttpJobManager", "Worker %s started", worker.name);
 
+#ifdef ARDUINO
+        while (worker_running)
+#else
         while (!should_stop)
+#endif
         {
-            std::unique_ptr<HttpJob> job;
-
-            // Wait for a job
+            // Priorities are re-checked after every job, so a button press waits at most for the
+            // request already in flight
+            HttpJob job;
+            if (popJob(worker, job))
             {
-                std::unique_lock<std::mutex> lock(job_queue_mutex);
-                job_available.wait(lock, [this]
-                                   { return !job_queue.empty() || should_stop; });
-
-                if (should_stop)
-                    break;
-
-                if (!job_queue.empty())
-                {
-                    job = std::move(job_queue.front());
-                    job_queue.pop();
-                }
+                executeJob(worker, job);
             }
-
-            if (job)
+            else
             {
-                LOG_DEBUG("HttpJobManager", "Processing job {} of type {}", job->job_id, job->getJobTypeName());
-
-                // Execute the job
-                auto result = job->execute(&system_hal->getNetworkManager(), base_url);
-                result->timestamp = system_hal->getMillis();
-
-                // Update connection state if this was a WiFi job
-                if (result->result_type == http::ResultType::WIFI_CONNECT)
-                {
-                    auto wifi_result = static_cast<http::WiFiConnectResult *>(result.get());
-                    wifi_connected.store(wifi_result->connected);
-                    if (wifi_result->connected)
-                    {
-                        last_wifi_attempt.store(0); // Reset retry timer
-                    }
-                }
-
-                // Send result back
-                sendResult(std::move(result));
+#ifdef ARDUINO
+                // Sleep until submitJob() notifies us
+                ulTaskNotifyTake(pdTRUE, WORKER_IDLE_WAIT);
+#else
+                waitForJob(worker);
+#endif
             }
         }
 
-        LOG_INFO("HttpJobManager", "Worker thread ended");
+        LOG_INFO("HttpJobManager", "Worker %s ended", worker.name);
     }
-#endif
 
 } // namespace http
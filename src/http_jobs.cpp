@@ -2,178 +2,304 @@
 #include "log.h"
 #include "config.h"
 #include "network_manager.h"
+#include "response_parser.h"
+#include "perf_metrics.h"
+#include <cstdio>
 #include <cstring>
-#include <sstream>
+#include <string_view>
 #include <ArduinoJson.h>
 
 namespace http
 {
-    // Reaper command constants
+    // Reaper command constants - arrays rather than pointers so batches can be joined at compile time
     namespace commands
     {
         // Transport commands
-        static const char *TRANSPORT = "TRANSPORT";
-        static const char *PLAY = "1007";
-        static const char *STOP = "1016";
+        static constexpr char TRANSPORT[] = "TRANSPORT";
+        static constexpr char PLAY[] = "1007";
+        static constexpr char STOP[] = "1016";
 
         // Tab navigation commands
-        static const char *NEXT_TAB = "40861";
-        static const char *PREVIOUS_TAB = "40862";
+        static constexpr char NEXT_TAB[] = "40861";
+        static constexpr char PREVIOUS_TAB[] = "40862";
 
         // ReaperSetlist commands
-        static const char *GET_SCRIPT_ACTION_ID = "GET/EXTSTATE/ReaperSetlist/ScriptActionId";
-        static const char *SET_OPERATION_GET_OPEN_TABS = "SET/EXTSTATE/ReaperSetlist/Operation/getOpenTabs";
-        static const char *GET_TABS = "GET/EXTSTATE/ReaperSetlist/tabs";
-        static const char *GET_ACTIVE_INDEX = "GET/EXTSTATE/ReaperSetlist/activeIndex";
-
-        // Response prefixes
-        static const char *EXTSTATE_PREFIX = "EXTSTATE";
-        static const char *REAPER_SETLIST = "ReaperSetlist";
-        static const char *SCRIPT_ACTION_ID_KEY = "ScriptActionId";
+        static constexpr char GET_SCRIPT_ACTION_ID[] = "GET/EXTSTATE/ReaperSetlist/ScriptActionId";
+        static constexpr char SET_OPERATION_GET_OPEN_TABS[] = "SET/EXTSTATE/ReaperSetlist/Operation/getOpenTabs";
+        static constexpr char GET_TABS[] = "GET/EXTSTATE/ReaperSetlist/tabs";
+        static constexpr char GET_ACTIVE_INDEX[] = "GET/EXTSTATE/ReaperSetlist/activeIndex";
+        static constexpr char GET_LIVE[] = "GET/EXTSTATE/ReaperSetlist/live";
+        static constexpr char SET_TABS_FORMAT_COMPACT[] = "SET/EXTSTATE/ReaperSetlist/tabsFormat/compact1";
+        static constexpr char SET_PUSH_TARGET[] = "SET/EXTSTATE/ReaperSetlist/pushTarget/"; // + "<ip>:<port>"
+
+        // ExtState response keys
+        static constexpr char REAPER_SETLIST[] = "ReaperSetlist";
+        static constexpr char SCRIPT_ACTION_ID_KEY[] = "ScriptActionId";
+        static constexpr char TABS_KEY[] = "tabs";
+        static constexpr char ACTIVE_INDEX_KEY[] = "activeIndex";
+        static constexpr char LIVE_KEY[] = "live";
     }
 
-    // Helper function to parse tab-separated response
-    static std::vector<std::string> parseTabSeparatedResponse(const std::string &response)
+    // Semicolon-separated command batch joined at compile time
+    template <size_t Size>
+    struct CommandBatch
     {
-        std::vector<std::string> items;
-        std::stringstream ss(response);
-        std::string item;
+        char text[Size] = {};
 
-        while (std::getline(ss, item, '\t'))
+        constexpr std::string_view view() const { return std::string_view(text, Size - 1); }
+    };
+
+    // Sizes include each command's terminator, which leaves room for the separators and one NUL
+    template <size_t... Sizes>
+    constexpr CommandBatch<(Sizes + ...)> makeBatch(const char (&...parts)[Sizes])
+    {
+        CommandBatch<(Sizes + ...)> batch;
+        const char *texts[] = {parts...};
+        const size_t lengths[] = {(Sizes - 1)...};
+        size_t pos = 0;
+        for (size_t i = 0; i < sizeof...(Sizes); ++i)
         {
-            // Remove newline at end if present
-            if (!item.empty() && item.back() == '\n')
+            if (i > 0)
             {
-                item.pop_back();
+                batch.text[pos++] = ';';
             }
-            if (!item.empty())
+            for (size_t j = 0; j < lengths[i]; ++j)
             {
-                items.push_back(item);
+                batch.text[pos++] = texts[i][j];
             }
         }
+        return batch;
+    }
 
-        return items;
+    namespace batches
+    {
+        static constexpr auto PLAY = makeBatch(commands::PLAY, commands::TRANSPORT);
+        static constexpr auto STOP = makeBatch(commands::STOP, commands::TRANSPORT);
+        // Read back after the script has refreshed the setlist, or on its own while the script
+        // keeps the setlist current (live)
+        static constexpr auto STATUS_QUERY = makeBatch(commands::GET_TABS, commands::GET_ACTIVE_INDEX, commands::TRANSPORT,
+                                                       commands::GET_LIVE);
+        static_assert(PLAY.view() == "1007;TRANSPORT", "Batch joined incorrectly");
     }
 
-    // WiFi Connection Job Constructor
-    WiFiConnectJob::WiFiConnectJob(uint32_t id, NetworkManager *network)
-        : HttpJob(id), network_manager(network)
+    RequestUrls::RequestUrls(const std::string &base_url, const std::string &script_action_id)
+        : base(base_url + "/")
     {
+#if SETLIST_COMPACT_FORMAT
+        // Sent with every refresh so a restarted script picks the format up again
+        status_refresh.append(commands::SET_TABS_FORMAT_COMPACT).append(";");
+#endif
+        status_refresh.append(commands::SET_OPERATION_GET_OPEN_TABS)
+            .append(";")
+            .append(script_action_id)
+            .append(";")
+            .append(batches::STATUS_QUERY.view());
+
+        transport = base + commands::TRANSPORT;
+        play = base;
+        play.append(batches::PLAY.view());
+        stop = base;
+        stop.append(batches::STOP.view());
+        script_action_id_query = base + commands::GET_SCRIPT_ACTION_ID;
+        status = base + status_refresh;
+        status_read = base;
+        status_read.append(batches::STATUS_QUERY.view());
+        next_tab = base + commands::NEXT_TAB + ";" + status_refresh;
+        previous_tab = base + commands::PREVIOUS_TAB + ";" + status_refresh;
     }
 
-    // WiFi Connection Job Implementation
-    std::unique_ptr<HttpJobResult> WiFiConnectJob::execute(hal::INetworkManager *network_mgr, const std::string &base_url)
+    // Request URL assembled in a fixed buffer on the worker stack, for URLs that are not cached
+    class RequestUrl
     {
-        auto result = std::unique_ptr<WiFiConnectResult>(new WiFiConnectResult(job_id));
+    private:
+        static const size_t MAX_LENGTH = 512; // Fits a jump across half of a full setlist plus the refresh
+        char url[MAX_LENGTH];
+        size_t length = 0;
+        bool overflow = false;
+        bool first_command = true;
 
-        LOG_INFO("WiFiConnectJob", "Attempting to connect to WiFi...");
+    public:
+        explicit RequestUrl(const RequestUrls &urls) : RequestUrl(urls.getBase()) {}
 
-        try
+        explicit RequestUrl(std::string_view base)
         {
-            // Try to connect to WiFi using NetworkManager
-            bool connected = network_manager->connectToWiFi();
+            append(base);
+        }
 
-            if (connected && network_mgr->isConnected())
+        RequestUrl &append(std::string_view text)
+        {
+            if (length + text.size() >= MAX_LENGTH)
             {
-                result->success = true;
-                result->connected = true;
-                result->ip_address = network_mgr->getIP();
-                LOG_INFO("WiFiConnectJob", "WiFi connected successfully. IP: {}", result->ip_address);
+                overflow = true;
+                return *this;
             }
-            else
+            memcpy(url + length, text.data(), text.size());
+            length += text.size();
+            url[length] = '\0';
+            return *this;
+        }
+
+        // Append one command (or batch) to the semicolon-separated list
+        RequestUrl &command(std::string_view text)
+        {
+            if (!first_command)
             {
-                result->success = false;
-                result->connected = false;
-                LOG_ERROR("WiFiConnectJob", "Failed to connect to WiFi");
+                append(";");
             }
+            first_command = false;
+            return append(text);
         }
-        catch (const std::exception &e)
+
+        bool ok() const { return !overflow; }
+        const char *c_str() const { return url; }
+    };
+
+    // Maximum number of lines expected in a batch response
+    static const size_t MAX_BATCH_LINES = 8;
+
+    static_assert(perf::httpMetric(JobType::SUBSCRIBE) == perf::Metric::HTTP_SUBSCRIBE, "HTTP metrics must follow JobType");
+
+    // Reads (and the idempotent subscribe) may be sent again after a lost response, the commands
+    // must not - REAPER may already have stepped the tab or started playback
+    static bool isRepeatable(JobType type)
+    {
+        return type == JobType::GET_STATUS || type == JobType::GET_TRANSPORT ||
+               type == JobType::GET_SCRIPT_ACTION_ID || type == JobType::SUBSCRIBE;
+    }
+
+    // Issue the request into the worker's response buffer
+    static bool request(JobContext &context, const char *url, const char *tag)
+    {
+        PERF_SCOPE(perf::httpMetric(context.type));
+        int status_code = 0;
+        uint32_t start_us = perf::nowMicros();
+        bool ok = context.network->httpGetBlocking(url, context.response, status_code, isRepeatable(context.type)) &&
+                  status_code == 200;
+        context.health.record(ok, (perf::nowMicros() - start_us) / 1000);
+        if (!ok)
         {
-            result->success = false;
-            result->connected = false;
-            LOG_ERROR("WiFiConnectJob", "Exception during WiFi connection: {}", e.what());
+            LOG_ERROR(tag, "Request failed: status %d", status_code);
         }
-
-        return std::move(result);
+        return ok;
     }
 
-    // Helper function to build URL for single command
-    static std::string buildCommandUrl(const std::string &base_url, const std::string &command)
+    static bool request(JobContext &context, const std::string &url, const char *tag)
     {
-        return base_url + "/" + command;
+        return request(context, url.c_str(), tag);
     }
 
-    // Helper function to build URL for multiple commands (separated by semicolons)
-    static std::string buildCommandUrl(const std::string &base_url, const std::vector<std::string> &commands)
+    static bool request(JobContext &context, const RequestUrl &url, const char *tag)
     {
-        if (commands.empty())
+        if (!url.ok())
         {
-            return base_url;
+            LOG_ERROR(tag, "Request URL too long");
+            return false;
         }
+        return request(context, url.c_str(), tag);
+    }
 
-        std::string url = base_url + "/";
-        for (size_t i = 0; i < commands.size(); ++i)
+    // Fans a job's command out to the mirror hosts: the requests are all sent before the job's own
+    // one goes out, and collected after it (or when the job returns), so every host gets the
+    // command within a few ms
+    class MirrorFanOut
+    {
+    private:
+        JobContext &context;
+        const char *tag;
+        bool sent[MAX_HOSTS] = {};
+        uint32_t sent_at_us[MAX_HOSTS] = {};
+
+    public:
+        // Send command (repeated count times in one batch) to every mirror
+        MirrorFanOut(JobContext &job_context, const char *command, int count, const char *job_tag)
+            : context(job_context), tag(job_tag)
         {
-            if (i > 0)
+            for (size_t i = 0; i < context.mirror_count && i < MAX_HOSTS && count > 0; ++i)
             {
-                url += ";";
+                const MirrorHost &mirror = context.mirrors[i];
+                RequestUrl url(*mirror.base);
+                for (int repeat = 0; repeat < count; ++repeat)
+                {
+                    url.command(command);
+                }
+                int status_code = 0;
+                sent_at_us[i] = perf::nowMicros();
+                sent[i] = url.ok() && mirror.network->httpSend(url.c_str(), status_code);
+                if (!sent[i])
+                {
+                    mirror.health->record(false, 0);
+                    LOG_WARNING(tag, "Mirror host %u unreachable: status %d", (unsigned)i + 1, status_code);
+                }
             }
-            url += commands[i];
         }
-        return url;
-    }
 
-    // Helper function to parse newline-separated batch response
-    static std::vector<std::string> parseBatchResponse(const std::string &response)
-    {
-        std::vector<std::string> lines;
-        std::stringstream ss(response);
-        std::string line;
+        ~MirrorFanOut() { finish(); }
 
-        while (std::getline(ss, line, '\n'))
+        MirrorFanOut(const MirrorFanOut &) = delete;
+        MirrorFanOut &operator=(const MirrorFanOut &) = delete;
+
+        void finish()
         {
-            // Remove carriage return if present
-            if (!line.empty() && line.back() == '\r')
+            for (size_t i = 0; i < context.mirror_count && i < MAX_HOSTS; ++i)
             {
-                line.pop_back();
-            }
-            if (!line.empty())
-            {
-                lines.push_back(line);
+                if (!sent[i])
+                {
+                    continue;
+                }
+                sent[i] = false;
+                const MirrorHost &mirror = context.mirrors[i];
+                int status_code = 0;
+                bool ok = mirror.network->httpReceive(*mirror.response, status_code) && status_code == 200;
+                mirror.health->record(ok, (perf::nowMicros() - sent_at_us[i]) / 1000);
+                if (!ok)
+                {
+                    LOG_WARNING(tag, "Mirror host %u failed: status %d", (unsigned)i + 1, status_code);
+                }
             }
         }
+    };
 
-        return lines;
-    }
-
-    // Helper function to parse transport state from tab-separated response
-    static bool parseTransportState(const std::string &response, reaper::TransportState &transport_state)
+    // WiFi Connection Job Implementation
+    static bool execute(const WiFiConnectJob &job, JobContext &context, WiFiConnectResult &result)
     {
-        auto items = parseTabSeparatedResponse(response);
-        if (items.size() >= 4)
+        LOG_INFO("WiFiConnectJob", "Attempting to connect to WiFi...");
+        PERF_SCOPE(perf::Metric::HTTP_WIFI_CONNECT);
+
+        try
+        {
+            // Try to connect to WiFi using NetworkManager
+            bool connected = job.network_manager->connectToWiFi();
+
+            if (connected && context.network->isConnected())
+            {
+                result.connected = true;
+                snprintf(result.ip_address, sizeof(result.ip_address), "%s", context.network->getIP());
+                LOG_INFO("WiFiConnectJob", "WiFi connected successfully. IP: %s", result.ip_address);
+                return true;
+            }
+            LOG_ERROR("WiFiConnectJob", "Failed to connect to WiFi");
+        }
+        catch (const std::exception &e)
         {
-            transport_state.play_state = std::stoi(items[1]);
-            transport_state.position_seconds = std::stod(items[2]);
-            transport_state.repeat_enabled = (items[3] == "1");
-            transport_state.position_bars_beats = items[4];
-            transport_state.success = true;
-            return true;
+            LOG_ERROR("WiFiConnectJob", "Exception during WiFi connection: %s", e.what());
         }
+
+        result.connected = false;
         return false;
     }
 
-    // Helper function to parse individual tabs from tab data string
-    static std::vector<reaper::TabInfo> parseTabData(const std::string &tab_data)
+    // JSON fallback, for scripts that do not know the compact format
+    static std::unique_ptr<reaper::Setlist> parseTabJson(std::string_view tab_data)
     {
-        std::vector<reaper::TabInfo> tabs;
+        std::unique_ptr<reaper::Setlist> tabs;
 
         // Tab data is JSON format: [{"length":297,"name":"Believer.RPP","index":0,"dirty":false},...]
         JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, tab_data);
+        DeserializationError error = deserializeJson(doc, tab_data.data(), tab_data.size());
 
         if (error)
         {
-            LOG_ERROR("parseTabData", "Failed to parse JSON: {}", error.c_str());
+            LOG_ERROR("parseTabData", "Failed to parse JSON: %s", error.c_str());
             return tabs;
         }
 
@@ -183,33 +309,35 @@ namespace http
             return tabs;
         }
 
+        // One block for the whole setlist, filled in place
+        tabs.reset(new reaper::Setlist());
         JsonArray tabArray = doc.as<JsonArray>();
         for (JsonObject tabObj : tabArray)
         {
             if (tabObj["length"].is<float>() && tabObj["name"].is<const char *>() && tabObj["index"].is<int>())
             {
-                reaper::TabInfo tab;
                 try
                 {
-                    tab.length = tabObj["length"].as<float>();
-                    tab.name = tabObj["name"].as<std::string>();
-                    tab.index = tabObj["index"].as<int>();
-
                     // Remove .rpp or .RPP extension if present
-                    if (tab.name.size() >= 4)
+                    std::string_view name = tabObj["name"].as<const char *>();
+                    if (name.size() >= 4)
                     {
-                        std::string extension = tab.name.substr(tab.name.size() - 4);
+                        std::string_view extension = name.substr(name.size() - 4);
                         if (extension == ".rpp" || extension == ".RPP")
                         {
-                            tab.name = tab.name.substr(0, tab.name.size() - 4);
+                            name.remove_suffix(4);
                         }
                     }
 
-                    tabs.push_back(tab);
+                    if (!tabs->add(tabObj["length"].as<float>(), tabObj["index"].as<int>(), name))
+                    {
+                        LOG_WARNING("parseTabData", "Setlist full, dropping tabs after %u", (unsigned)tabs->size());
+                        break;
+                    }
                 }
                 catch (const std::exception &e)
                 {
-                    LOG_ERROR("parseTabData", "Failed to parse tab object: {}", e.what());
+                    LOG_ERROR("parseTabData", "Failed to parse tab object: %s", e.what());
                 }
             }
             else
@@ -218,285 +346,298 @@ namespace http
             }
         }
 
-        LOG_DEBUG("parseTabData", "Successfully parsed {} tabs from JSON", tabs.size());
+        LOG_DEBUG("parseTabData", "Successfully parsed %u tabs from JSON", (unsigned)tabs->size());
         return tabs;
     }
 
-    // ChangeTabJob implementation
-    std::unique_ptr<HttpJobResult> ChangeTabJob::execute(hal::INetworkManager *network_mgr, const std::string &base_url)
+    std::unique_ptr<reaper::Setlist> parseTabData(std::string_view tab_data)
     {
-        auto result = std::unique_ptr<ChangeTabResult>(new ChangeTabResult(job_id));
-
-        LOG_DEBUG("ChangeTabJob", "Executing job {} (direction: {})", job_id,
-                  direction == TabDirection::NEXT ? "NEXT" : "PREVIOUS");
-
-        // Single HTTP call with all commands batched
-        std::string tab_command = (direction == TabDirection::NEXT) ? commands::NEXT_TAB : commands::PREVIOUS_TAB;
-
-        std::vector<std::string> batch_commands = {
-            tab_command,                           // Change tab
-            commands::SET_OPERATION_GET_OPEN_TABS, // Set operation
-            script_action_id,                      // Execute script action
-            commands::GET_TABS,                    // Get tabs
-            commands::GET_ACTIVE_INDEX,            // Get active index
-            commands::TRANSPORT                    // Get transport state
-        };
+        PERF_SCOPE(perf::Metric::PARSE_TABS);
+        if (!parser::isCompactSetlist(tab_data))
+        {
+            return parseTabJson(tab_data);
+        }
 
-        std::string batch_url = buildCommandUrl(base_url, batch_commands);
+        std::unique_ptr<reaper::Setlist> tabs(new reaper::Setlist());
+        if (!parser::parseCompactSetlist(tab_data, *tabs))
+        {
+            LOG_ERROR("parseTabData", "Malformed compact setlist");
+            tabs.reset();
+            return tabs;
+        }
+        LOG_DEBUG("parseTabData", "Successfully parsed %u tabs from compact setlist", (unsigned)tabs->size());
+        return tabs;
+    }
 
-        std::string response;
-        int status_code;
+    // The script sets live while it keeps tabs/activeIndex current by itself and clears it on exit
+    static bool isSetlistLive(std::string_view line)
+    {
+        std::string_view live;
+        return parser::parseExtStateValue(line, commands::REAPER_SETLIST, commands::LIVE_KEY, live) && live == "1";
+    }
 
-        if (!network_mgr->httpGetBlocking(batch_url.c_str(), response, status_code) || status_code != 200)
+    // Parse the lines answering STATUS_QUERY: tabs, active index, transport, live flag
+    static bool parseStatusResponse(JobContext &context, uint32_t known_tabs_digest, reaper::ReaperState &reaper_state,
+                                    reaper::TransportState &transport_state, bool &tabs_unchanged, const char *tag)
+    {
+        std::string_view lines[MAX_BATCH_LINES];
+        size_t line_count = parser::splitLines(context.response, lines, MAX_BATCH_LINES);
+        if (line_count < 3)
         {
-            LOG_ERROR("ChangeTabJob", "Batch request failed: status {}", status_code);
-            return result;
+            LOG_ERROR(tag, "Invalid batch response - expected at least 3 lines, got %u", (unsigned)line_count);
+            return false;
         }
 
-        // Parse batch response (newline-separated)
-        auto lines = parseBatchResponse(response);
-        if (lines.size() < 3)
+        // An unset ExtState still answers with an empty value, older REAPER builds may drop it
+        bool live = line_count > 3 && isSetlistLive(lines[3]);
+        if (context.setlist_live.exchange(live, std::memory_order_relaxed) != live)
         {
-            LOG_ERROR("ChangeTabJob", "Invalid batch response - expected 3 lines, got {}", lines.size());
-            return result;
+            LOG_INFO(tag, "ReaperSetlist %s", live ? "keeps the setlist current, polling read-only"
+                                                   : "is not keeping the setlist current, polling through the script");
         }
 
         // Parse transport state from last line (index 2)
-        if (parseTransportState(lines[2], result->transport_state))
+        if (parser::parseTransportLine(lines[2], transport_state))
         {
-            LOG_DEBUG("ChangeTabJob", "Successfully parsed transport state");
+            LOG_DEBUG(tag, "Successfully parsed transport state");
         }
 
         // Parse tabs from line 0 (GET_TABS response, 0-indexed so line 0)
-        auto tab_items = parseTabSeparatedResponse(lines[0]);
-        if (tab_items.size() >= 4 && tab_items[0] == commands::EXTSTATE_PREFIX &&
-            tab_items[1] == commands::REAPER_SETLIST && tab_items[2] == "tabs")
+        std::string_view tab_data;
+        if (parser::parseExtStateValue(lines[0], commands::REAPER_SETLIST, commands::TABS_KEY, tab_data))
         {
-            std::string tab_data = tab_items[3];
-            result->reaper_state.tabs = parseTabData(tab_data);
-            LOG_DEBUG("ChangeTabJob", "Parsed {} tabs", result->reaper_state.tabs.size());
+            // Skip the JSON parse (and the copies downstream) when the setlist has not changed
+            uint32_t tabs_digest = parser::digest(tab_data);
+            if (known_tabs_digest != 0 && tabs_digest == known_tabs_digest)
+            {
+                reaper_state.tabs_digest = tabs_digest;
+                tabs_unchanged = true;
+                LOG_DEBUG(tag, "Tabs unchanged (digest %08x)", (unsigned)tabs_digest);
+            }
+            else
+            {
+                reaper_state.tabs = parseTabData(tab_data);
+                // A payload that did not parse (no memory, truncated, malformed) keeps digest 0, so
+                // the next poll parses it again instead of matching it as unchanged
+                if (reaper_state.tabs)
+                {
+                    reaper_state.tabs_digest = tabs_digest;
+                }
+                LOG_DEBUG(tag, "Parsed %u tabs", (unsigned)reaper_state.tabCount());
+            }
         }
 
         // Parse active index from line 1 (GET_ACTIVE_INDEX response, 0-indexed so line 1)
-        auto index_items = parseTabSeparatedResponse(lines[1]);
-        if (index_items.size() >= 4 && index_items[0] == commands::EXTSTATE_PREFIX &&
-            index_items[1] == commands::REAPER_SETLIST && index_items[2] == "activeIndex")
+        std::string_view active_index;
+        if (parser::parseExtStateValue(lines[1], commands::REAPER_SETLIST, commands::ACTIVE_INDEX_KEY, active_index))
         {
-            try
+            if (parser::parseUnsigned(active_index, reaper_state.active_index))
             {
-                result->reaper_state.active_index = std::stoi(index_items[3]);
-                LOG_DEBUG("ChangeTabJob", "Got active index: {}", result->reaper_state.active_index);
+                LOG_DEBUG(tag, "Got active index: %u", reaper_state.active_index);
             }
-            catch (const std::exception &e)
+            else
             {
-                LOG_ERROR("ChangeTabJob", "Failed to parse active index: {}", e.what());
+                LOG_ERROR(tag, "Failed to parse active index");
             }
         }
 
-        result->success = true;
-        result->reaper_state.success = true;
-        LOG_DEBUG("ChangeTabJob", "Job {} completed successfully", job_id);
-
-        return result;
+        reaper_state.success = true;
+        return true;
     }
 
-    // ChangePlaystateJob implementation
-    std::unique_ptr<HttpJobResult> ChangePlaystateJob::execute(hal::INetworkManager *network_mgr, const std::string &base_url)
+    // Send steps worth of tab commands then the status refresh, all in one request, and parse it.
+    // The mirrors get the same steps unless fan_out is off.
+    static bool changeTabs(const ChangeTabJob &job, int steps, JobContext &context, ChangeTabResult &result,
+                           bool fan_out = true)
     {
-        auto result = std::unique_ptr<ChangePlaystateResult>(new ChangePlaystateResult(job_id));
-
-        LOG_DEBUG("ChangePlaystateJob", "Executing job {} (action: {})", job_id, static_cast<int>(action));
-
-        // Single HTTP call with both commands batched
-        std::string command;
-        switch (action)
+        // Single HTTP call with all commands batched. Single presses and a net change of zero
+        // (which just refreshes the state) use cached URLs; folded presses repeat the tab command.
+        const RequestUrls &urls = context.urls;
+        MirrorFanOut mirrors(context, steps > 0 ? commands::NEXT_TAB : commands::PREVIOUS_TAB,
+                             fan_out ? (steps > 0 ? steps : -steps) : 0, "ChangeTabJob");
+        bool sent;
+        if (steps == 1 || steps == -1 || steps == 0)
         {
-        case PlayAction::PLAY:
-            command = commands::PLAY;
-            break;
-        case PlayAction::STOP:
-            command = commands::STOP;
-            break;
+            const std::string &url = steps == 1 ? urls.getNextTab() : steps == -1 ? urls.getPreviousTab() : urls.getStatus();
+            sent = request(context, url, "ChangeTabJob");
         }
-
-        std::vector<std::string> batch_commands = {
-            command,            // Change playstate
-            commands::TRANSPORT // Get transport state
-        };
-
-        std::string batch_url = buildCommandUrl(base_url, batch_commands);
-        std::string response;
-        int status_code;
-
-        if (!network_mgr->httpGetBlocking(batch_url.c_str(), response, status_code) || status_code != 200)
+        else
         {
-            LOG_ERROR("ChangePlaystateJob", "Batch request failed: status {}", status_code);
-            return result;
-        }
+            const char *tab_command = (steps > 0) ? commands::NEXT_TAB : commands::PREVIOUS_TAB;
+            int tab_command_count = (steps > 0) ? steps : -steps;
 
-        // Parse batch response (newline-separated)
-        auto lines = parseBatchResponse(response);
-        if (lines.size() < 1)
-        {
-            LOG_ERROR("ChangePlaystateJob", "Invalid batch response - expected 1 lines, got {}", lines.size());
-            return result;
+            RequestUrl url(urls);
+            for (int i = 0; i < tab_command_count; ++i)
+            {
+                url.command(tab_command); // Change tab
+            }
+            url.command(urls.getStatusRefresh());
+            sent = request(context, url, "ChangeTabJob");
         }
 
-        // Parse transport state from first line (index 0)
-        if (parseTransportState(lines[0], result->transport_state))
+        if (!sent)
         {
-            result->success = true;
-            LOG_DEBUG("ChangePlaystateJob", "Successfully parsed transport state");
+            return false;
         }
-
-        LOG_DEBUG("ChangePlaystateJob", "Job {} completed successfully", job_id);
-
-        return result;
+        result = ChangeTabResult();
+        return parseStatusResponse(context, job.known_tabs_digest, result.reaper_state, result.transport_state,
+                                   result.tabs_unchanged, "ChangeTabJob");
     }
 
-    // GetStatusJob implementation
-    std::unique_ptr<HttpJobResult> GetStatusJob::execute(hal::INetworkManager *network_mgr, const std::string &base_url)
+    // ChangeTabJob implementation
+    static bool execute(const ChangeTabJob &job, JobContext &context, ChangeTabResult &result)
     {
-        auto result = std::unique_ptr<GetStatusResult>(new GetStatusResult(job_id));
+        LOG_DEBUG("ChangeTabJob", "Executing (steps: %d, target: %d)", job.steps, job.target_index);
 
-        LOG_DEBUG("GetStatusJob", "Executing job {}", job_id);
-
-        // Single HTTP call with all commands batched
-        std::vector<std::string> batch_commands = {
-            commands::SET_OPERATION_GET_OPEN_TABS, // Set operation
-            script_action_id,                      // Execute script action
-            commands::GET_TABS,                    // Get tabs
-            commands::GET_ACTIVE_INDEX,            // Get active index
-            commands::TRANSPORT                    // Get transport state
-        };
-
-        std::string batch_url = buildCommandUrl(base_url, batch_commands);
-        std::string response;
-        int status_code;
-
-        if (!network_mgr->httpGetBlocking(batch_url.c_str(), response, status_code) || status_code != 200)
+        if (!changeTabs(job, job.steps, context, result))
         {
-            LOG_ERROR("GetStatusJob", "Batch request failed: status {}", status_code);
-            return result;
+            return false;
         }
 
-        // Parse batch response (newline-separated)
-        auto lines = parseBatchResponse(response);
-        if (lines.size() < 3)
+        // A jump was worked out from the index the device knew - if REAPER was somewhere else
+        // (changed at the computer, a lost tab command), step from where it actually is. Only the
+        // host that was read is corrected; the mirrors' own positions are not known here.
+        if (job.target_index >= 0 && result.reaper_state.success &&
+            result.reaper_state.active_index != (unsigned int)job.target_index)
         {
-            LOG_ERROR("GetStatusJob", "Invalid batch response - expected 3 lines, got {}", lines.size());
-            return result;
+            int correction = ChangeTabJob::stepsBetween(result.reaper_state.active_index, job.target_index, job.tab_count);
+            LOG_WARNING("ChangeTabJob", "Jump landed on tab %u instead of %d, correcting by %d",
+                        result.reaper_state.active_index, job.target_index, correction);
+            return changeTabs(job, correction, context, result, false);
         }
+        return true;
+    }
 
-        // Parse transport state from last line (index 2)
-        if (parseTransportState(lines[2], result->transport_state))
+    // ChangePlaystateJob implementation
+    static bool execute(const ChangePlaystateJob &job, JobContext &context, ChangePlaystateResult &result)
+    {
+        LOG_DEBUG("ChangePlaystateJob", "Executing (action: %d)", static_cast<int>(job.action));
+
+        // Single HTTP call with both commands batched
+        const std::string &url = job.action == PlayAction::PLAY ? context.urls.getPlay() : context.urls.getStop();
+        MirrorFanOut mirrors(context, job.action == PlayAction::PLAY ? commands::PLAY : commands::STOP, 1, "ChangePlaystateJob");
+        if (!request(context, url, "ChangePlaystateJob"))
         {
-            LOG_DEBUG("GetStatusJob", "Successfully parsed transport state");
+            return false;
         }
 
-        // Parse tabs from line 0 (GET_TABS response, 0-indexed so line 0)
-        auto tab_items = parseTabSeparatedResponse(lines[0]);
-        if (tab_items.size() >= 4 && tab_items[0] == commands::EXTSTATE_PREFIX &&
-            tab_items[1] == commands::REAPER_SETLIST && tab_items[2] == "tabs")
+        // Parse transport state from first line (index 0)
+        std::string_view lines[MAX_BATCH_LINES];
+        size_t line_count = parser::splitLines(context.response, lines, MAX_BATCH_LINES);
+        if (line_count < 1 || !parser::parseTransportLine(lines[0], result.transport_state))
         {
-            std::string tab_data = tab_items[3];
-            result->reaper_state.tabs = parseTabData(tab_data);
-            LOG_DEBUG("GetStatusJob", "Parsed {} tabs", result->reaper_state.tabs.size());
+            LOG_ERROR("ChangePlaystateJob", "Invalid batch response - no transport line");
+            return false;
         }
+        return true;
+    }
 
-        // Parse active index from line 1 (GET_ACTIVE_INDEX response, 0-indexed so line 1)
-        auto index_items = parseTabSeparatedResponse(lines[1]);
-        if (index_items.size() >= 4 && index_items[0] == commands::EXTSTATE_PREFIX &&
-            index_items[1] == commands::REAPER_SETLIST && index_items[2] == "activeIndex")
+    // GetStatusJob implementation
+    static bool execute(const GetStatusJob &job, JobContext &context, GetStatusResult &result)
+    {
+        // A transport read keeps the standby hosts' health current, so polling can fail over
+        MirrorFanOut mirrors(context, commands::TRANSPORT, 1, "GetStatusJob");
+#if SETLIST_LIVE_STATE
+        // A plain read while the script keeps the setlist current - no script run on REAPER's UI
+        // thread. If it turns out to have stopped (live cleared), fall back to the script refresh.
+        if (context.setlist_live.load(std::memory_order_relaxed))
         {
-            try
+            if (!request(context, context.urls.getStatusRead(), "GetStatusJob"))
+            {
+                return false;
+            }
+            if (!parseStatusResponse(context, job.known_tabs_digest, result.reaper_state, result.transport_state,
+                                     result.tabs_unchanged, "GetStatusJob"))
             {
-                result->reaper_state.active_index = std::stoi(index_items[3]);
-                LOG_DEBUG("GetStatusJob", "Got active index: {}", result->reaper_state.active_index);
+                return false;
             }
-            catch (const std::exception &e)
+            if (context.setlist_live.load(std::memory_order_relaxed))
             {
-                LOG_ERROR("GetStatusJob", "Failed to parse active index: {}", e.what());
+                return true;
             }
+            result = GetStatusResult();
         }
-
-        result->success = true;
-        result->reaper_state.success = true;
-        LOG_DEBUG("GetStatusJob", "Job {} completed successfully", job_id);
-
-        return result;
+#endif
+        if (!request(context, context.urls.getStatus(), "GetStatusJob"))
+        {
+            return false;
+        }
+        return parseStatusResponse(context, job.known_tabs_digest, result.reaper_state, result.transport_state,
+                                   result.tabs_unchanged, "GetStatusJob");
     }
 
     // GetScriptActionIdJob implementation
-    std::unique_ptr<HttpJobResult> GetScriptActionIdJob::execute(hal::INetworkManager *network_mgr, const std::string &base_url)
+    static bool execute(const GetScriptActionIdJob &, JobContext &context, GetScriptActionIdResult &result)
     {
-        auto result = std::unique_ptr<GetScriptActionIdResult>(new GetScriptActionIdResult(job_id));
-
-        LOG_DEBUG("GetScriptActionIdJob", "Executing job {}", job_id);
-
         // Get ReaperSetlist script action ID
-        std::string command_url = buildCommandUrl(base_url, commands::GET_SCRIPT_ACTION_ID);
-
-        std::string response;
-        int status_code;
-
-        if (!network_mgr->httpGetBlocking(command_url.c_str(), response, status_code) || status_code != 200)
+        if (!request(context, context.urls.getScriptActionIdQuery(), "GetScriptActionIdJob"))
         {
-            LOG_ERROR("GetScriptActionIdJob", "Script action ID request failed: status {}", status_code);
-            return result;
+            return false;
         }
 
         // Parse the response - expected format: "EXTSTATE\tReaperSetlist\tScriptActionId\t{actual_id}"
-        auto items = parseTabSeparatedResponse(response);
-        if (items.size() >= 4 && items[0] == commands::EXTSTATE_PREFIX && items[1] == commands::REAPER_SETLIST && items[2] == commands::SCRIPT_ACTION_ID_KEY)
-        {
-            result->script_action_id = items[3];
-            result->success = true;
-            LOG_INFO("GetScriptActionIdJob", "Got ReaperSetlist script action ID: {}", result->script_action_id);
-        }
-        else
+        std::string_view action_id;
+        if (!parser::parseExtStateValue(context.response, commands::REAPER_SETLIST, commands::SCRIPT_ACTION_ID_KEY, action_id) ||
+            action_id.size() >= sizeof(result.script_action_id))
         {
             LOG_ERROR("GetScriptActionIdJob", "Invalid script action ID response format");
+            return false;
         }
 
-        LOG_DEBUG("GetScriptActionIdJob", "Job {} completed", job_id);
-
-        return result;
+        memcpy(result.script_action_id, action_id.data(), action_id.size());
+        result.script_action_id[action_id.size()] = '\0';
+        LOG_INFO("GetScriptActionIdJob", "Got ReaperSetlist script action ID: %s", result.script_action_id);
+        return true;
     }
 
-    std::unique_ptr<HttpJobResult> GetTransportJob::execute(hal::INetworkManager *network_mgr, const std::string &base_url)
+    // GetTransportJob implementation
+    static bool execute(const GetTransportJob &, JobContext &context, GetTransportResult &result)
     {
-        auto result = std::unique_ptr<GetTransportResult>(new GetTransportResult(job_id));
-
-        LOG_DEBUG("GetTransportJob", "Executing job {}", job_id);
-
         // Get transport state only
-        std::string command_url = buildCommandUrl(base_url, commands::TRANSPORT);
-
-        std::string response;
-        int status_code;
-
-        if (!network_mgr->httpGetBlocking(command_url.c_str(), response, status_code) || status_code != 200)
+        if (!request(context, context.urls.getTransport(), "GetTransportJob"))
         {
-            LOG_ERROR("GetTransportJob", "Transport request failed: status {}", status_code);
-            return result;
+            return false;
         }
 
         // Parse the transport state using existing helper function
-        if (parseTransportState(response, result->transport_state))
+        if (!parser::parseTransportLine(context.response, result.transport_state))
         {
-            result->success = true;
-            LOG_DEBUG("GetTransportJob", "Got transport state: play_state={}, position={:.2f}s",
-                      result->transport_state.play_state, result->transport_state.position_seconds);
+            LOG_ERROR("GetTransportJob", "Failed to parse transport response");
+            return false;
         }
-        else
+
+        LOG_DEBUG("GetTransportJob", "Got transport state: play_state=%d, position=%.2fs",
+                  result.transport_state.play_state, result.transport_state.position_seconds);
+        return true;
+    }
+
+    // SubscribeJob implementation
+    static bool execute(const SubscribeJob &job, JobContext &context, SubscribeResult &)
+    {
+        // The ReaperSetlist script sends its updates to whatever target was registered last
+        char target[48];
+        snprintf(target, sizeof(target), "%s:%u", context.network->getIP(), (unsigned)job.push_port);
+        RequestUrl url(context.urls);
+        url.command(commands::SET_PUSH_TARGET).append(target);
+
+        if (!request(context, url, "SubscribeJob"))
         {
-            LOG_ERROR("GetTransportJob", "Failed to parse transport response");
+            return false;
         }
 
-        LOG_DEBUG("GetTransportJob", "Job {} completed", job_id);
+        LOG_INFO("SubscribeJob", "Subscribed to ReaperSetlist push updates at %s", target);
+        return true;
+    }
 
-        return result;
+    void runJob(const HttpJob &job, JobContext &context, HttpJobResult &result)
+    {
+        result.job_id = job.job_id;
+        result.success = std::visit([&](const auto &payload)
+                                    {
+            using Job = std::decay_t<decltype(payload)>;
+            return execute(payload, context, result.payload.template emplace<typename Job::Result>()); },
+                                    job.payload);
+        LOG_DEBUG("HttpJob", "Job %u (%s) %s", job.job_id, job.name(), result.success ? "completed" : "failed");
     }
 
 } // namespace http
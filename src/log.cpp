@@ -0,0 +1,310 @@
+#include "log.h"
+
+#if LOG_DEFERRED
+
+#include "mpsc_ring.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#endif
+
+namespace logging
+{
+    static MpscRing<Record, LOG_RING_SIZE> ring;
+    static std::atomic<uint32_t> dropped{0};
+    static std::mutex drain_mutex; // The drain task and flush() take turns as the ring's consumer
+
+    // The drain task sleeps until a record is pushed
+#ifdef ARDUINO
+    static std::atomic<TaskHandle_t> drain_task{nullptr};
+#else
+    static std::atomic<bool> drain_pending{false};
+    static std::mutex wake_mutex;
+    static std::condition_variable wake;
+#endif
+
+    static const size_t LINE_SIZE = 256;
+    static const size_t SPEC_SIZE = 16;
+
+    static const char *const LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+
+    static uint32_t nowMs()
+    {
+#ifdef ARDUINO
+        return millis();
+#else
+        static const auto epoch = std::chrono::steady_clock::now();
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+#endif
+    }
+
+    static void output(const char *line, size_t length)
+    {
+#ifdef ARDUINO
+        Serial.write((const uint8_t *)line, length);
+#else
+        fwrite(line, 1, length, stdout);
+#endif
+    }
+
+    void push(Record &record)
+    {
+        record.timestamp_ms = nowMs();
+        if (!ring.push(record))
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed); // The ring is full, the drain task is already due
+            return;
+        }
+
+#ifdef ARDUINO
+        TaskHandle_t task = drain_task.load(std::memory_order_acquire);
+        if (task)
+        {
+            xTaskNotifyGive(task);
+        }
+#else
+        // Only the push that finds the drain thread idle takes the lock to wake it
+        if (!drain_pending.exchange(true))
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            wake.notify_one();
+        }
+#endif
+    }
+
+    // Reads the encoded arguments back in call order
+    class RecordReader
+    {
+    private:
+        const Record &record;
+        size_t position = 0;
+
+        template <typename T>
+        T take()
+        {
+            T value;
+            memcpy(&value, record.payload + position, sizeof(value));
+            position += sizeof(value);
+            return value;
+        }
+
+    public:
+        explicit RecordReader(const Record &source) : record(source) {}
+
+        bool done() const { return position >= record.payload_size; }
+
+        // Format the next argument with a printf conversion spec from the record's format
+        // (length modifiers already stripped, conversion last). Returns snprintf's result.
+        int formatNext(char *buffer, size_t size, char *spec, size_t spec_length)
+        {
+            ArgType type = (ArgType)record.payload[position++];
+            char conversion = spec[spec_length - 1];
+            bool wants_integer = strchr("diouxXc", conversion) != nullptr;
+            bool wants_double = strchr("fFeEgGaA", conversion) != nullptr;
+
+            switch (type)
+            {
+            case ArgType::INT32:
+            case ArgType::UINT32:
+            case ArgType::INT64:
+            case ArgType::UINT64:
+            {
+                // Formatted at the argument's own width, as printf would have: a negative int
+                // printed with %u or %x comes out as 32 bits, not 64
+                bool wide = type == ArgType::INT64 || type == ArgType::UINT64;
+                bool is_signed = type == ArgType::INT32 || type == ArgType::INT64;
+                uint64_t bits = wide ? take<uint64_t>() : take<uint32_t>();
+                int64_t number = wide || !is_signed ? (int64_t)bits : (int64_t)(int32_t)(uint32_t)bits;
+                if (wants_double)
+                {
+                    return snprintf(buffer, size, spec, is_signed ? (double)number : (double)bits);
+                }
+                if (!wants_integer)
+                {
+                    return is_signed ? snprintf(buffer, size, "%lld", (long long)number)
+                                     : snprintf(buffer, size, "%llu", (unsigned long long)bits);
+                }
+                if (conversion == 'c')
+                {
+                    return snprintf(buffer, size, spec, (int)number);
+                }
+                bool signed_conversion = conversion == 'd' || conversion == 'i';
+                if (!wide)
+                {
+                    return signed_conversion ? snprintf(buffer, size, spec, (int)(int32_t)(uint32_t)bits)
+                                             : snprintf(buffer, size, spec, (unsigned int)(uint32_t)bits);
+                }
+                // 64-bit arguments get back the ll modifier stripped from the spec
+                char wide_spec[SPEC_SIZE + 2];
+                memcpy(wide_spec, spec, spec_length - 1);
+                memcpy(wide_spec + spec_length - 1, "ll", 2);
+                wide_spec[spec_length + 1] = conversion;
+                wide_spec[spec_length + 2] = '\0';
+                return signed_conversion ? snprintf(buffer, size, wide_spec, (long long)bits)
+                                         : snprintf(buffer, size, wide_spec, (unsigned long long)bits);
+            }
+            case ArgType::DOUBLE:
+            {
+                double number = take<double>();
+                return wants_double ? snprintf(buffer, size, spec, number) : snprintf(buffer, size, "%g", number);
+            }
+            case ArgType::STRING:
+            {
+                size_t length = record.payload[position++];
+                char text[sizeof(record.payload)];
+                memcpy(text, record.payload + position, length);
+                text[length] = '\0';
+                position += length;
+                return conversion == 's' ? snprintf(buffer, size, spec, text) : snprintf(buffer, size, "%s", text);
+            }
+            case ArgType::POINTER:
+            default:
+            {
+                uint64_t address = take<uint64_t>();
+                return snprintf(buffer, size, "%p", (void *)(uintptr_t)address);
+            }
+            }
+        }
+    };
+
+    size_t formatRecord(const Record &record, char *buffer, size_t size)
+    {
+        size_t length = 0;
+        auto append = [&](int written)
+        {
+            if (written > 0)
+            {
+                length = std::min(length + (size_t)written, size - 2); // Keep room for the newline
+            }
+        };
+
+        const char *level = record.level < sizeof(LEVEL_NAMES) / sizeof(LEVEL_NAMES[0]) ? LEVEL_NAMES[record.level] : "?";
+        append(snprintf(buffer, size, "[%lu][%s] [%s] ", (unsigned long)record.timestamp_ms, level, record.tag));
+
+        RecordReader reader(record);
+        for (const char *p = record.format; *p && length < size - 2; ++p)
+        {
+            if (*p != '%')
+            {
+                buffer[length++] = *p;
+                continue;
+            }
+            if (p[1] == '%')
+            {
+                buffer[length++] = '%';
+                ++p;
+                continue;
+            }
+
+            // Copy flags, width and precision, drop length modifiers, stop at the conversion
+            char spec[SPEC_SIZE];
+            size_t spec_length = 0;
+            spec[spec_length++] = *p++;
+            while (*p && strchr("-+ #0123456789.", *p) && spec_length < SPEC_SIZE - 2)
+            {
+                spec[spec_length++] = *p++;
+            }
+            while (*p && strchr("hlLqjzt", *p))
+            {
+                ++p;
+            }
+            if (!*p)
+            {
+                break;
+            }
+            spec[spec_length++] = *p;
+            spec[spec_length] = '\0';
+
+            if (reader.done())
+            {
+                append(snprintf(buffer + length, size - length, "?"));
+            }
+            else
+            {
+                append(reader.formatNext(buffer + length, size - length, spec, spec_length));
+            }
+        }
+        buffer[length++] = '\n';
+        buffer[length] = '\0';
+        return length;
+    }
+
+    static void drain()
+    {
+        std::lock_guard<std::mutex> lock(drain_mutex);
+        char line[LINE_SIZE];
+
+        uint32_t lost = dropped.exchange(0, std::memory_order_relaxed);
+        if (lost > 0)
+        {
+            int length = snprintf(line, sizeof(line), "[%lu][WARN] [Log] %u messages dropped - log ring full\n",
+                                  (unsigned long)nowMs(), (unsigned)lost);
+            output(line, std::min((size_t)length, sizeof(line) - 1));
+        }
+
+        Record record;
+        while (ring.pop(record))
+        {
+            output(line, formatRecord(record, line, sizeof(line)));
+        }
+    }
+
+    void flush()
+    {
+        drain();
+#ifdef ARDUINO
+        Serial.flush();
+#else
+        fflush(stdout);
+#endif
+    }
+
+#ifdef ARDUINO
+    static void drainTask(void *)
+    {
+        while (true)
+        {
+            drain();
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Given by push(), pending if one came in while draining
+        }
+    }
+
+    void start()
+    {
+        // Lowest priority above idle - formatting and UART writes only use otherwise idle time
+        TaskHandle_t task = nullptr;
+        xTaskCreate(drainTask, "log_drain", 3072, nullptr, tskIDLE_PRIORITY + 1, &task);
+        drain_task.store(task, std::memory_order_release);
+    }
+#else
+    void start()
+    {
+        std::thread([]
+                    {
+            while (true)
+            {
+                // Cleared before draining, so a record pushed meanwhile wakes the next round
+                drain_pending.store(false);
+                drain();
+                fflush(stdout);
+                std::unique_lock<std::mutex> lock(wake_mutex);
+                wake.wait(lock, []
+                          { return drain_pending.load(); });
+            } })
+            .detach();
+    }
+#endif
+
+} // namespace logging
+
+#endif // LOG_DEFERRED
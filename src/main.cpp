@@ -1,6 +1,7 @@
 #include <lv_conf.h>
 #include <lvgl.h>
 #include <string>
+#include <algorithm>
 #include "config.h"
 #include "log.h"
 #include "ui_manager.h"
@@ -9,6 +10,9 @@
 #include "network_manager.h"
 #include "http_job_manager.h"
 #include "power_manager.h"
+#include "memory_budget.h"
+#include "result_handlers.h"
+#include "perf_metrics.h"
 
 #ifdef ARDUINO
 #include "m5stack_hal.h"
@@ -26,6 +30,26 @@ StateManager *g_state_manager = nullptr;
 NetworkManager *g_network = nullptr;
 http::HttpJobManager *g_http_manager = nullptr;
 PowerManager *g_power_manager = nullptr;
+MemoryBudget *g_memory_budget = nullptr;
+static http::ResultDispatcher g_results;
+
+// Longest the main loop sleeps without an event or deadline, bounds any timing a component
+// does not report through msUntilNextUpdate()
+static const uint32_t MAX_IDLE_WAIT_MS = 1000;
+
+// Sleep until the earliest component deadline, a button edge or an HTTP result
+static void waitForNextEvent()
+{
+    unsigned long now = g_system->getMillis();
+    uint32_t wait_ms = MAX_IDLE_WAIT_MS;
+    wait_ms = std::min(wait_ms, g_state_manager->msUntilNextUpdate(now));
+    wait_ms = std::min(wait_ms, g_http_manager->msUntilNextUpdate(now));
+    wait_ms = std::min(wait_ms, g_power_manager->msUntilNextUpdate(now));
+    wait_ms = std::min(wait_ms, g_ui->msUntilNextUpdate(now));
+    wait_ms = std::min(wait_ms, g_button_handler->msUntilNextUpdate(now));
+    wait_ms = std::min(wait_ms, g_memory_budget->msUntilNextUpdate(now));
+    g_system->waitForEvent(wait_ms);
+}
 
 #ifdef ARDUINO
 void setup()
@@ -61,14 +85,20 @@ int main()
     char url_buffer[256];
     snprintf(url_buffer, sizeof(url_buffer), "http://%s:%d/_", getReaperServer(), getReaperPort());
     std::string reaper_base_url(url_buffer);
+    std::string backup_base_url;
+    if (REAPER_BACKUP_SERVER[0] != '\0')
+    {
+        snprintf(url_buffer, sizeof(url_buffer), "http://%s:%d/_", REAPER_BACKUP_SERVER, REAPER_BACKUP_PORT);
+        backup_base_url = url_buffer;
+    }
 
     try
     {
-        g_http_manager = new http::HttpJobManager(g_system, g_network, reaper_base_url);
+        g_http_manager = new http::HttpJobManager(g_system, g_network, reaper_base_url, backup_base_url);
     }
     catch (const std::exception &e)
     {
-        LOG_ERROR("Main", "Failed to initialize HTTP job manager: {}", e.what());
+        LOG_ERROR("Main", "Failed to initialize HTTP job manager: %s", e.what());
 #ifdef ARDUINO
         return; // Cannot continue without HTTP manager
 #else
@@ -81,12 +111,35 @@ int main()
 
     // Initialize button handler
     g_button_handler = new ButtonHandler(&g_system->getInputManager(), g_http_manager, g_ui);
-    g_button_handler->setStateReferences(&g_state_manager->getReaperState(), &g_state_manager->getTransportState());
+    g_button_handler->setStateManager(g_state_manager);
 
     // Initialize power manager
     g_power_manager = new PowerManager(g_system, g_ui);
 
+    // Route HTTP results to their handlers
+    AppComponents components;
+    components.system = g_system;
+    components.ui = g_ui;
+    components.button_handler = g_button_handler;
+    components.state_manager = g_state_manager;
+    components.http_manager = g_http_manager;
+    registerResultHandlers(g_results, components);
+
+    g_power_manager->setStateManager(g_state_manager);
+
+    // Heap, LVGL pool and stacks are logged at startup and then periodically by the budget
+    g_memory_budget = new MemoryBudget(g_system);
+
+    // Back from deep sleep - show the last known state in the first frame, the first polls refresh it
+    UIState restored_ui_state = UIState::DISCONNECTED;
+    if (g_system->wokeFromSleep() && g_state_manager->restoreSnapshot(*g_system, restored_ui_state))
+    {
+        g_ui->setUIState(restored_ui_state);
+        g_ui->showRestoredState();
+    }
+
     LOG_INFO("Main", "Application initialized");
+    g_memory_budget->logStats("after init");
 
 #ifdef ARDUINO
 }
@@ -109,10 +162,11 @@ void loop()
     unsigned long current_time = g_system->getMillis();
 
     // Handle button presses
-    auto button_pressed = g_button_handler->handleButtonPress();
+    auto button_pressed = g_button_handler->handleButtonPress(current_time);
     if (button_pressed)
     {
         g_power_manager->onButtonPress();
+        g_state_manager->onUserInput();
     }
 
     // Update state management
@@ -127,141 +181,51 @@ void loop()
     // Process HTTP job results
     if (g_http_manager)
     {
-        auto results = g_http_manager->processResults();
-        for (const auto &result : results)
+        http::HttpJobResult result;
+        while (g_http_manager->nextResult(result))
         {
-            // Handle different types of results
-            if (result->result_type == http::ResultType::WIFI_CONNECT)
-            {
-                auto wifi_result = static_cast<const http::WiFiConnectResult *>(result.get());
-                if (wifi_result->success && wifi_result->connected)
-                {
-                    LOG_INFO("Main", "WiFi connected successfully. IP: {}", wifi_result->ip_address);
-                    // Submit script action ID job now that WiFi is connected
-                    g_http_manager->submitGetScriptActionIdJob();
-                }
-                else
-                {
-                    LOG_ERROR("Main", "WiFi connection failed");
-                    g_http_manager->submitWiFiConnectJob();
-                }
-                g_ui->setUIState(UIState::DISCONNECTED);
-                g_ui->updateWiFiUI();
-                g_ui->updateBatteryUI();
-            }
-            else if (result->result_type == http::ResultType::CHANGE_TAB)
-            {
-                auto change_tab_result = static_cast<const http::ChangeTabResult *>(result.get());
-                LOG_DEBUG("Main", "Processing change tab result - tabs: {}, active_index: {}, play_state: {}",
-                          change_tab_result->reaper_state.tabs.size(),
-                          change_tab_result->reaper_state.active_index,
-                          change_tab_result->transport_state.play_state);
-                g_state_manager->updateReaperState(change_tab_result->reaper_state);
-                g_state_manager->updateTransportState(change_tab_result->transport_state);
-                g_button_handler->setAwaitingStateUpdate(false);
-
-                // Update UI state based on transport state
-                if (g_ui->getCurrentUIState() != UIState::ARE_YOU_SURE)
-                {
-                    if (change_tab_result->transport_state.play_state == 0)
-                    {
-                        g_ui->setUIState(UIState::STOPPED);
-                    }
-                    else if (change_tab_result->transport_state.play_state == 1)
-                    {
-                        g_ui->setUIState(UIState::PLAYING);
-                    }
-                }
-            }
-            else if (result->result_type == http::ResultType::CHANGE_PLAYSTATE)
-            {
-                auto change_playstate_result = static_cast<const http::ChangePlaystateResult *>(result.get());
-                LOG_DEBUG("Main", "Processing change playstate result - play_state: {}",
-                          change_playstate_result->transport_state.play_state);
-                g_state_manager->updateTransportState(change_playstate_result->transport_state);
-                g_button_handler->setAwaitingTransportUpdate(false);
-
-                // Update UI state based on transport state
-                if (change_playstate_result->transport_state.play_state == 0)
-                {
-                    g_ui->setUIState(UIState::STOPPED);
-                }
-                else if (change_playstate_result->transport_state.play_state == 1)
-                {
-                    g_ui->setUIState(UIState::PLAYING);
-                }
-            }
-            else if (result->result_type == http::ResultType::GET_STATUS)
-            {
-                auto get_status_result = static_cast<const http::GetStatusResult *>(result.get());
-                LOG_DEBUG("Main", "Processing get status result - tabs: {}, active_index: {}, play_state: {}",
-                          get_status_result->reaper_state.tabs.size(),
-                          get_status_result->reaper_state.active_index,
-                          get_status_result->transport_state.play_state);
-                g_state_manager->updateReaperState(get_status_result->reaper_state);
-                g_state_manager->updateTransportState(get_status_result->transport_state);
-                g_state_manager->setAwaitingStateUpdate(false);
-                g_state_manager->setHaveReaperState(true);
-            }
-            else if (result->result_type == http::ResultType::GET_SCRIPT_ACTION_ID)
-            {
-                auto script_result = static_cast<const http::GetScriptActionIdResult *>(result.get());
-                LOG_TRACE("Main", "Processing script action ID result");
-                if (script_result->success && !script_result->script_action_id.empty())
-                {
-                    g_http_manager->setScriptActionId(script_result->script_action_id);
-                    LOG_INFO("Main", "ReaperSetlist script action ID set: {}", script_result->script_action_id);
-                    g_ui->setUIState(UIState::STOPPED);
-                }
-                else
-                {
-                    LOG_ERROR("Main", "Failed to get ReaperSetlist script action ID");
-                }
-            }
-            else if (result->result_type == http::ResultType::GET_TRANSPORT)
+            if (!g_results.dispatch(result, current_time))
             {
-                auto transport_result = static_cast<const http::GetTransportResult *>(result.get());
-                LOG_DEBUG("Main", "Processing transport result - play_state: {}",
-                          transport_result->transport_state.play_state);
-                g_state_manager->updateTransportState(transport_result->transport_state);
-
-                // Update UI state based on transport state if not in ARE_YOU_SURE mode
-                if (g_ui->getCurrentUIState() != UIState::ARE_YOU_SURE)
-                {
-                    if (transport_result->transport_state.play_state == 0)
-                    {
-                        g_ui->setUIState(UIState::STOPPED);
-                    }
-                    else if (transport_result->transport_state.play_state == 1)
-                    {
-                        g_ui->setUIState(UIState::PLAYING);
-                    }
-                }
+                LOG_WARNING("Main", "No handler for result of job %u", result.job_id);
             }
         }
+
+        checkStartupTiming(current_time);
     }
 
     // Update UI elements based on current state
     g_ui->updateReaperStateUI(g_state_manager->getReaperState());
-    g_ui->updateTransportUI(g_state_manager->getTransportState(), g_state_manager->getReaperState());
+    g_ui->updateTransportUI(g_state_manager->getTransportState(), g_state_manager->getReaperState(),
+                            g_state_manager->getPredictedPosition(current_time));
     g_ui->updateButtonLabelsUI();
 
     // Periodic UI updates (battery, WiFi, etc.)
     g_ui->updatePeriodicUI(current_time);
 
-    // Force LVGL to refresh the display
-    lv_obj_invalidate(lv_scr_act());
-
-    // Force immediate display refresh
-    lv_disp_t *disp = lv_disp_get_default();
-    if (disp)
+    // Redraw only if a widget actually changed
+    if (g_ui->refreshIfDirty())
     {
-        lv_refr_now(disp);
+        g_state_manager->onFrameRendered(g_system->getMillis());
     }
 
     // Debug logging
     g_state_manager->periodicDebugLog(current_time);
 
+    // Memory budget - shed what is only there to be quicker while memory is low
+    if (g_memory_budget->update(current_time))
+    {
+        g_ui->setMemoryDegraded(g_memory_budget->isDegraded());
+        g_http_manager->setMemoryDegraded(g_memory_budget->isDegraded());
+    }
+#if PERF_METRICS && PERF_DUMP_INTERVAL_MS
+    static uint32_t last_perf_dump = 0;
+    if (current_time - last_perf_dump >= PERF_DUMP_INTERVAL_MS)
+    {
+        perf::dump(g_system->getHeapStats());
+        last_perf_dump = current_time;
+    }
+#endif
+
     // Check for UI state changes and notify power manager
     UIState current_ui_state = g_ui->getCurrentUIState();
     if (current_ui_state != last_ui_state)
@@ -271,13 +235,14 @@ void loop()
     }
 
     // Update power manager with current transport state
-    g_power_manager->onTransportUpdate(g_state_manager->getTransportState(), g_state_manager->getReaperState());
+    g_power_manager->onTransportUpdate(g_state_manager->getTransportState(), g_state_manager->getReaperState(),
+                                       g_state_manager->getTransportClock());
 
     // Update power management (check for sleep conditions)
     g_power_manager->update(current_time);
 
-    // Small delay to prevent overwhelming the system
-    g_system->delay(1000 / 60);
+    // Sleep until there is something to do
+    waitForNextEvent();
 
 #ifndef ARDUINO
 }
@@ -0,0 +1,124 @@
+#include "memory_budget.h"
+#include "config.h"
+#include "log.h"
+#include <lvgl.h>
+
+const char *const MemoryBudget::WATCHED_TASKS[WATCHED_TASK_COUNT] = {
+    "loopTask", "http_worker", "http_user_worker", "push_listener", "log_drain"};
+
+MemoryBudget::MemoryBudget(hal::ISystemHAL *system)
+    : system_hal(system)
+{
+    LOG_INFO("Memory", "Memory budget: degraded below a %u byte heap block or %u byte LVGL block",
+             (unsigned)MEMORY_RESERVE_HEAP_BLOCK, (unsigned)MEMORY_RESERVE_LVGL_BLOCK);
+}
+
+void MemoryBudget::sample()
+{
+    last.heap = system_hal->getHeapStats();
+
+    lv_mem_monitor_t lvgl;
+    lv_mem_monitor(&lvgl);
+    last.lvgl_total = (uint32_t)lvgl.total_size;
+    last.lvgl_used = (uint32_t)(lvgl.total_size - lvgl.free_size);
+    last.lvgl_peak = (uint32_t)lvgl.max_used;
+    last.lvgl_largest_free = (uint32_t)lvgl.free_biggest_size;
+    last.lvgl_frag_pct = lvgl.frag_pct;
+
+    // A zero block is a platform that does not report it, not an empty heap
+    if (last.heap.largest_free_block && last.heap.largest_free_block < lowest_heap_block)
+        lowest_heap_block = last.heap.largest_free_block;
+    if (last.heap.psram_largest_free_block && last.heap.psram_largest_free_block < lowest_psram_block)
+        lowest_psram_block = last.heap.psram_largest_free_block;
+    if (last.lvgl_largest_free < lowest_lvgl_block)
+        lowest_lvgl_block = last.lvgl_largest_free;
+
+    for (size_t i = 0; i < WATCHED_TASK_COUNT; ++i)
+    {
+        last.stack_free[i] = system_hal->getStackHighWaterMark(WATCHED_TASKS[i]);
+        // A stack cannot grow at runtime - warn once, its size needs raising
+        if (last.stack_free[i] && last.stack_free[i] < STACK_RESERVE_BYTES && !stack_warned[i])
+        {
+            LOG_WARNING("Memory", "Task %s has come within %u bytes of its stack end",
+                        WATCHED_TASKS[i], (unsigned)last.stack_free[i]);
+            stack_warned[i] = true;
+        }
+    }
+}
+
+bool MemoryBudget::isLow(uint32_t margin_pct) const
+{
+    uint32_t heap_reserve = MEMORY_RESERVE_HEAP_BLOCK + MEMORY_RESERVE_HEAP_BLOCK * margin_pct / 100;
+    uint32_t lvgl_reserve = MEMORY_RESERVE_LVGL_BLOCK + MEMORY_RESERVE_LVGL_BLOCK * margin_pct / 100;
+    bool heap_low = last.heap.largest_free_block && last.heap.largest_free_block < heap_reserve;
+    return heap_low || last.lvgl_largest_free < lvgl_reserve;
+}
+
+bool MemoryBudget::update(unsigned long current_time)
+{
+    if (sampled && current_time - last_sample_time < SAMPLE_INTERVAL_MS)
+        return false;
+
+    sample();
+    sampled = true;
+    last_sample_time = current_time;
+
+    if (current_time - last_log_time >= LOG_INTERVAL_MS)
+    {
+        logSnapshot("in use");
+        last_log_time = current_time;
+    }
+
+    bool was_degraded = degraded;
+    degraded = degraded ? isLow(RECOVERY_MARGIN_PCT) : isLow(0);
+    if (degraded != was_degraded)
+    {
+        if (degraded)
+        {
+            LOG_WARNING("Memory", "Memory low (heap block %u, LVGL block %u bytes) - shedding prefetches and the picker",
+                        last.heap.largest_free_block, last.lvgl_largest_free);
+        }
+        else
+        {
+            LOG_INFO("Memory", "Memory recovered (heap block %u, LVGL block %u bytes)",
+                     last.heap.largest_free_block, last.lvgl_largest_free);
+        }
+        return true;
+    }
+    return false;
+}
+
+uint32_t MemoryBudget::msUntilNextUpdate(unsigned long current_time) const
+{
+    return sampled ? hal::msRemaining(current_time - last_sample_time, SAMPLE_INTERVAL_MS) : 0;
+}
+
+void MemoryBudget::logStats(const char *when)
+{
+    sample();
+    logSnapshot(when);
+}
+
+void MemoryBudget::logSnapshot(const char *when) const
+{
+    const hal::HeapStats &heap = last.heap;
+    LOG_INFO("Memory", "Heap %s: free %u, low-water %u, largest block %u (lowest %u) bytes",
+             when, heap.free_bytes, heap.min_free_bytes, heap.largest_free_block,
+             lowest_heap_block == UINT32_MAX ? 0 : lowest_heap_block);
+    if (heap.psram_free_bytes)
+    {
+        LOG_INFO("Memory", "PSRAM %s: free %u, largest block %u (lowest %u) bytes",
+                 when, heap.psram_free_bytes, heap.psram_largest_free_block,
+                 lowest_psram_block == UINT32_MAX ? 0 : lowest_psram_block);
+    }
+    LOG_INFO("Memory", "LVGL pool %s: used %u of %u, peak %u, largest block %u (lowest %u), frag %u%%",
+             when, last.lvgl_used, last.lvgl_total, last.lvgl_peak, last.lvgl_largest_free,
+             lowest_lvgl_block == UINT32_MAX ? 0 : lowest_lvgl_block, (unsigned)last.lvgl_frag_pct);
+    for (size_t i = 0; i < WATCHED_TASK_COUNT; ++i)
+    {
+        if (last.stack_free[i])
+        {
+            LOG_INFO("Memory", "Stack %s: %u bytes never used", WATCHED_TASKS[i], last.stack_free[i]);
+        }
+    }
+}
@@ -37,6 +37,7 @@ namespace hal
         printf("Initializing LVGL...\n");
         // Initialize LVGL
         lv_init();
+        lv_tick_set_cb(tick_cb);
         printf("LVGL initialized\n");
 
         printf("Creating LVGL display...\n");
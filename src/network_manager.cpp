@@ -13,14 +13,14 @@ bool NetworkManager::connectToWiFi()
     const char *ssid = getWiFiSSID();
     const char *password = getWiFiPassword();
 
-    LOG_INFO("WiFi", "Connecting to network: {}", ssid);
+    LOG_INFO("WiFi", "Connecting to network: %s", ssid);
 
     // Attempt to connect
     bool connected = network_mgr->connect(ssid, password);
 
     if (connected)
     {
-        LOG_INFO("WiFi", "Connected successfully! IP: {}", network_mgr->getIP());
+        LOG_INFO("WiFi", "Connected successfully! IP: %s", network_mgr->getIP());
         return true;
     }
     else
@@ -0,0 +1,138 @@
+#include "perf_metrics.h"
+#include "log.h"
+#include <algorithm>
+#include <cstdio>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+namespace perf
+{
+    static SampleRing rings[(size_t)Metric::COUNT];
+
+    struct MetricInfo
+    {
+        const char *name;
+        bool microseconds; // Shown as milliseconds on the overlay
+    };
+
+    static const MetricInfo METRIC_INFO[] = {
+        {"http.wifi", true},
+        {"http.tab", true},
+        {"http.play", true},
+        {"http.status", true},
+        {"http.script_id", true},
+        {"http.transport", true},
+        {"http.subscribe", true},
+        {"parse.tabs", true},
+        {"render", true},
+        {"flush.bytes", false},
+        {"queue.depth", false},
+    };
+    static_assert(sizeof(METRIC_INFO) / sizeof(METRIC_INFO[0]) == (size_t)Metric::COUNT, "Every metric needs its info");
+
+    const char *metricName(Metric metric)
+    {
+        return METRIC_INFO[(size_t)metric].name;
+    }
+
+    SampleRing &ring(Metric metric)
+    {
+        return rings[(size_t)metric];
+    }
+
+    uint32_t nowMicros()
+    {
+#ifdef ARDUINO
+        return micros();
+#else
+        static const auto epoch = std::chrono::steady_clock::now();
+        return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+#endif
+    }
+
+    Summary SampleRing::summarize() const
+    {
+        Summary summary;
+        summary.count = recorded.load(std::memory_order_relaxed);
+        size_t held = std::min<size_t>(summary.count, SIZE);
+        if (held == 0)
+        {
+            return summary;
+        }
+
+        uint32_t sorted[SIZE];
+        for (size_t i = 0; i < held; ++i)
+        {
+            sorted[i] = samples[i].load(std::memory_order_relaxed);
+        }
+        std::sort(sorted, sorted + held);
+        summary.p50 = sorted[(held - 1) * 50 / 100];
+        summary.p99 = sorted[(held - 1) * 99 / 100];
+        summary.max = sorted[held - 1];
+        return summary;
+    }
+
+    size_t formatOverlay(char *buffer, size_t size, const hal::HeapStats &heap)
+    {
+        size_t length = 0;
+        auto append = [&](int written)
+        {
+            if (written > 0)
+            {
+                length = std::min(length + (size_t)written, size - 1);
+            }
+        };
+
+        buffer[0] = '\0';
+        for (size_t i = 0; i < (size_t)Metric::COUNT; ++i)
+        {
+            Summary summary = rings[i].summarize();
+            if (summary.count == 0)
+            {
+                continue;
+            }
+            if (METRIC_INFO[i].microseconds)
+            {
+                append(snprintf(buffer + length, size - length, "%-14s p50 %6.1f p99 %6.1f ms\n", METRIC_INFO[i].name,
+                                summary.p50 / 1000.0, summary.p99 / 1000.0));
+            }
+            else
+            {
+                append(snprintf(buffer + length, size - length, "%-14s p50 %6u p99 %6u\n", METRIC_INFO[i].name,
+                                summary.p50, summary.p99));
+            }
+        }
+        append(snprintf(buffer + length, size - length, "heap %u kB free, %u kB block, %u kB low",
+                        heap.free_bytes / 1024, heap.largest_free_block / 1024, heap.min_free_bytes / 1024));
+        if (heap.psram_free_bytes)
+        {
+            append(snprintf(buffer + length, size - length, "\npsram %u kB free, %u kB block",
+                            heap.psram_free_bytes / 1024, heap.psram_largest_free_block / 1024));
+        }
+        return length;
+    }
+
+    void dump(const hal::HeapStats &heap)
+    {
+        for (size_t i = 0; i < (size_t)Metric::COUNT; ++i)
+        {
+            Summary summary = rings[i].summarize();
+            if (summary.count == 0)
+            {
+                continue;
+            }
+            LOG_INFO("Perf", "%s n=%u p50=%u p99=%u max=%u", METRIC_INFO[i].name, summary.count, summary.p50, summary.p99,
+                     summary.max);
+        }
+        LOG_INFO("Perf", "heap free=%u low=%u block=%u", heap.free_bytes, heap.min_free_bytes, heap.largest_free_block);
+        if (heap.psram_free_bytes)
+        {
+            LOG_INFO("Perf", "psram free=%u block=%u", heap.psram_free_bytes, heap.psram_largest_free_block);
+        }
+    }
+
+} // namespace perf
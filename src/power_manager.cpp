@@ -1,4 +1,5 @@
 #include "power_manager.h"
+#include "state_manager.h"
 #include "log.h"
 
 PowerManager::PowerManager(hal::ISystemHAL *hal, UIManager *ui)
@@ -23,6 +24,7 @@ void PowerManager::onButtonPress()
         is_in_light_sleep = false;
         play_sleep_scheduled = false;
     }
+    setRadioPowerSave(false); // The press is about to be sent
 
     LOG_INFO("PowerManager", "Button press recorded at time %lu (was %lu, diff=%lu)",
              current_time, old_time, (current_time >= old_time) ? (current_time - old_time) : 0);
@@ -38,6 +40,9 @@ void PowerManager::onUIStateChange(UIState new_state, UIState old_state)
         play_start_time = current_time;
         play_sleep_scheduled = true;
         is_in_play_sleep = false;
+        is_in_light_sleep = false; // An idle light sleep from before would hold off the play segments
+        rate_sample_time = 0;
+        play_rate = 1.0;
         LOG_INFO("PowerManager", "Play started from %d - scheduling sleep in %lu ms", (int)old_state, PLAY_SLEEP_DELAY);
     }
     else if (old_state == UIState::PLAYING && new_state != UIState::PLAYING)
@@ -45,6 +50,9 @@ void PowerManager::onUIStateChange(UIState new_state, UIState old_state)
         // Stopped playing
         play_sleep_scheduled = false;
         is_in_play_sleep = false;
+        setRadioPowerSave(false);
+        endSongStats(current_time);
+        last_button_press_time = current_time; // Idle timeouts are held while playing, count from here
         LOG_INFO("PowerManager", "Play stopped - canceling play sleep");
     }
     else if (new_state == UIState::PLAYING && old_state == UIState::PLAYING)
@@ -54,16 +62,63 @@ void PowerManager::onUIStateChange(UIState new_state, UIState old_state)
     }
 }
 
-void PowerManager::onTransportUpdate(const reaper::TransportState &transport_state, const reaper::ReaperState &reaper_state)
+void PowerManager::onTransportUpdate(const reaper::TransportState &transport_state, const reaper::ReaperState &reaper_state,
+                                     const TransportClock &clock)
 {
-    if (transport_state.success && reaper_state.success &&
-        reaper_state.active_index < reaper_state.tabs.size())
+    if (!transport_state.success || !reaper_state.success || !reaper_state.hasActiveTab())
+        return;
+
+    bool playing = ui_manager && ui_manager->getCurrentUIState() == UIState::PLAYING;
+    unsigned long current_time = system_hal->getMillis();
+    if (playing && (!song_stats.active || song_stats.tab_index != reaper_state.active_index))
     {
-        current_song_length = reaper_state.tabs[reaper_state.active_index].length;
-        last_known_position = transport_state.position_seconds;
+        endSongStats(current_time);
+        startSongStats(reaper_state.active_index, current_time);
+        rate_sample_time = 0; // Another song, another tempo
+    }
 
-        LOG_TRACE("PowerManager", "Transport update: position=%.1fs, length=%.1fs",
-                  last_known_position, current_song_length);
+    current_song_length = reaper_state.activeTab().length;
+    repeat_enabled = transport_state.repeat_enabled;
+    unsigned long sample_time = clock.anchorTime();
+    if (sample_time == last_sample_time)
+        return;
+
+    // A new sample from REAPER (or a press applied to the clock)
+    last_known_position = clock.anchorPosition();
+    last_sample_time = sample_time;
+    LOG_TRACE("PowerManager", "Transport update: position=%.1fs, length=%.1fs",
+              last_known_position, current_song_length);
+
+    // Measure the play rate over samples far enough apart. A jump outside the plausible range
+    // is a seek or a loop, which restarts the measurement instead.
+    if (transport_state.play_state == 1 && rate_sample_time != 0 && sample_time - rate_sample_time >= RATE_SAMPLE_MIN_INTERVAL)
+    {
+        double rate = (last_known_position - rate_sample_position) / ((sample_time - rate_sample_time) / 1000.0);
+        if (rate >= 0.25 && rate <= 4.0)
+        {
+            play_rate = rate;
+        }
+        rate_sample_time = 0;
+    }
+    if (transport_state.play_state == 1 && rate_sample_time == 0)
+    {
+        rate_sample_position = last_known_position;
+        rate_sample_time = sample_time;
+    }
+
+    // Checkpoint after a play sleep segment - plan the next one from this sample
+    if (is_in_play_sleep && sample_time >= play_wake_time)
+    {
+        unsigned long lead = sample_time - play_wake_time;
+        wake_lead_ms = (wake_lead_ms + lead) / 2;
+        if (wake_lead_ms < PLAY_WAKE_LEAD_MIN)
+        {
+            wake_lead_ms = PLAY_WAKE_LEAD_MIN;
+        }
+        is_in_play_sleep = false;
+        play_sleep_scheduled = true;
+        LOG_DEBUG("PowerManager", "Play checkpoint %lu ms after wake: position %.1fs, rate %.2f",
+                  lead, last_known_position, play_rate);
     }
 }
 
@@ -77,8 +132,9 @@ void PowerManager::update(unsigned long current_time)
 
     UIState current_ui_state = ui_manager->getCurrentUIState();
 
-    // Check for tiered idle timeout (only if not on external power)
-    if (!isOnExternalPower() || true)
+    // Check for tiered idle timeout (only if not on external power). Not while playing - the play
+    // sleep segments cover that, and would otherwise be cut off by the idle light and deep sleep.
+    if ((!isOnExternalPower() || true) && current_ui_state != UIState::PLAYING)
     {
         // Protect against unsigned integer underflow
         if (current_time < last_button_press_time)
@@ -132,7 +188,7 @@ void PowerManager::update(unsigned long current_time)
         unsigned long time_since_button = current_time - last_button_press_time;
 
         // Don't sleep if there was recent button activity (within last 10 seconds)
-        if (time_since_button < 10000) // 10 seconds grace period after button press
+        if (time_since_button < PLAY_SLEEP_GRACE)
         {
             LOG_INFO("PowerManager", "Play sleep delayed - button pressed %lu ms ago", time_since_button);
             return;
@@ -140,34 +196,104 @@ void PowerManager::update(unsigned long current_time)
 
         if (time_since_play_start >= PLAY_SLEEP_DELAY)
         {
-            // Time to enter play sleep (light sleep to preserve state)
-            if (current_song_length > 0.0)
-            {
-                unsigned long sleep_duration = calculateSleepDuration(current_song_length, last_known_position);
-
-                if (sleep_duration > 1000) // Only sleep if more than 1 second
-                {
-                    LOG_INFO("PowerManager", "Entering play light sleep for %lu ms (song ends in %.1fs)",
-                             sleep_duration, current_song_length - last_known_position);
-
-                    is_in_play_sleep = true;
-                    play_sleep_scheduled = false;
-                    enterLightSleep(sleep_duration); // Use light sleep for play mode
-                }
-                else
-                {
-                    LOG_INFO("PowerManager", "Song ending soon (%.1fs left) - not entering sleep",
-                             current_song_length - last_known_position);
-                    play_sleep_scheduled = false;
-                }
-            }
-            else
-            {
-                LOG_WARNING("PowerManager", "Unknown song length - cannot calculate sleep duration");
-                play_sleep_scheduled = false;
-            }
+            enterPlaySleep(current_time);
+        }
+    }
+}
+
+void PowerManager::enterPlaySleep(unsigned long current_time)
+{
+    if (current_song_length <= 0.0)
+    {
+        LOG_WARNING("PowerManager", "Unknown song length - cannot calculate sleep duration");
+        play_sleep_scheduled = false;
+        return;
+    }
+
+    unsigned long sleep_duration = calculateSleepDuration(current_time);
+    if (sleep_duration < PLAY_SLEEP_MIN)
+    {
+        LOG_INFO("PowerManager", "Song ending soon (%.1fs left) - not entering sleep",
+                 current_song_length - positionAt(current_time));
+        play_sleep_scheduled = false;
+        return;
+    }
+
+    LOG_INFO("PowerManager", "Entering play light sleep for %lu ms (position %.1fs of %.1fs, rate %.2f%s)",
+             sleep_duration, positionAt(current_time), current_song_length, play_rate, repeat_enabled ? ", repeat" : "");
+
+    setRadioPowerSave(true);
+    play_sleep_scheduled = false;
+    unsigned long sleep_start = system_hal->getMillis();
+    enterLightSleep(sleep_duration); // Light sleep keeps state and the WiFi association
+
+    // Awake again - hold off the next segment until a fresh transport sample arrives
+    play_wake_time = system_hal->getMillis();
+    is_in_play_sleep = true;
+    song_stats.asleep_ms += play_wake_time - sleep_start;
+    song_stats.sleep_segments++;
+}
+
+void PowerManager::setRadioPowerSave(bool enable)
+{
+    if (!system_hal || enable == radio_power_save)
+        return;
+
+    system_hal->getPowerManager().enableWiFiPowerSave(enable);
+    radio_power_save = enable;
+}
+
+void PowerManager::startSongStats(unsigned int tab_index, unsigned long current_time)
+{
+    song_stats = SongPowerStats();
+    song_stats.active = true;
+    song_stats.tab_index = tab_index;
+    song_stats.start_time = current_time;
+    song_stats.start_battery = system_hal->getPowerManager().getBatteryPercentage();
+}
+
+void PowerManager::endSongStats(unsigned long current_time)
+{
+    if (!song_stats.active)
+        return;
+
+    song_stats.active = false;
+    unsigned long played_ms = current_time - song_stats.start_time;
+    if (played_ms == 0)
+        return;
+
+    uint8_t end_battery = system_hal->getPowerManager().getBatteryPercentage();
+    int drained = (int)song_stats.start_battery - (int)end_battery;
+    LOG_INFO("PowerManager", "Song %u: played %lu s, asleep %lu s (%u%%) in %u segments, battery %u%% -> %u%% (%.1f%%/h)%s",
+             song_stats.tab_index + 1, played_ms / 1000, song_stats.asleep_ms / 1000,
+             (unsigned)(song_stats.asleep_ms * 100 / played_ms), song_stats.sleep_segments,
+             song_stats.start_battery, end_battery, drained * 3600000.0 / played_ms,
+             isOnExternalPower() ? " on external power" : "");
+}
+
+uint32_t PowerManager::msUntilNextUpdate(unsigned long current_time) const
+{
+    if (current_time < last_button_press_time)
+        return 0; // Let update() handle the wraparound
+
+    // Idle timeouts - deep sleep follows light sleep. Held while playing, as in update().
+    unsigned long time_since_button = current_time - last_button_press_time;
+    bool playing = ui_manager && ui_manager->getCurrentUIState() == UIState::PLAYING;
+    uint32_t next = playing ? UINT32_MAX
+                            : hal::msRemaining(time_since_button, is_in_light_sleep ? DEEP_SLEEP_TIMEOUT : LIGHT_SLEEP_TIMEOUT);
+
+    // Play sleep - after the play delay and outside the button grace period
+    if (playing && play_sleep_scheduled && !is_in_play_sleep && !is_in_light_sleep)
+    {
+        uint32_t play_due = hal::msRemaining(current_time - play_start_time, PLAY_SLEEP_DELAY);
+        uint32_t grace_due = hal::msRemaining(time_since_button, PLAY_SLEEP_GRACE);
+        uint32_t play_sleep_due = play_due > grace_due ? play_due : grace_due;
+        if (play_sleep_due < next)
+        {
+            next = play_sleep_due;
         }
     }
+    return next;
 }
 
 bool PowerManager::isOnExternalPower() const
@@ -194,17 +320,30 @@ bool PowerManager::isOnExternalPower() const
     return cached_external_power_status;
 }
 
-unsigned long PowerManager::calculateSleepDuration(double song_length, double current_position) const
+double PowerManager::positionAt(unsigned long current_time) const
 {
-    double remaining_time = song_length - current_position;
-    double sleep_time = remaining_time - (WAKEUP_BEFORE_END / 1000.0);
+    return last_known_position + (current_time - last_sample_time) / 1000.0 * play_rate;
+}
+
+unsigned long PowerManager::calculateSleepDuration(unsigned long current_time) const
+{
+    // With repeat on the song loops instead of ending - just check back periodically
+    if (repeat_enabled)
+    {
+        return PLAY_CHECK_INTERVAL;
+    }
+
+    // Wall clock time until the end at the measured play rate, from where the song is now
+    double position = positionAt(current_time);
+    double remaining_ms = (current_song_length - position) / play_rate * 1000.0;
+    double sleep_time = remaining_ms - WAKEUP_BEFORE_END - wake_lead_ms;
 
     if (sleep_time <= 0.0)
     {
         return 0; // Don't sleep if less than wakeup time remaining
     }
 
-    return (unsigned long)(sleep_time * 1000.0); // Convert to milliseconds
+    return sleep_time < PLAY_CHECK_INTERVAL ? (unsigned long)sleep_time : PLAY_CHECK_INTERVAL;
 }
 
 void PowerManager::enterLightSleep(unsigned long duration_ms)
@@ -233,14 +372,22 @@ void PowerManager::enterDeepSleep(unsigned long duration_ms)
 
     auto &power = system_hal->getPowerManager();
 
+    // Deep sleep resets the device - keep what is on screen for the wake
+    if (state_manager && ui_manager)
+    {
+        state_manager->saveSnapshot(*system_hal, ui_manager->getCurrentUIState(), duration_ms);
+    }
+
     if (duration_ms == 0)
     {
         LOG_INFO("PowerManager", "Entering indefinite deep sleep");
+        log_flush(); // Queued log lines would be lost with the reset
         power.deepSleep(0);
     }
     else
     {
         LOG_INFO("PowerManager", "Entering deep sleep for %lu ms", duration_ms);
+        log_flush();
         power.deepSleep(duration_ms);
     }
 }
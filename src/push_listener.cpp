@@ -0,0 +1,142 @@
+#include "push_listener.h"
+#include "response_parser.h"
+#include "log.h"
+#include <stdexcept>
+
+namespace http
+{
+    static const std::string_view REAPER_SETLIST = "ReaperSetlist";
+    static const std::string_view ACTIVE_INDEX_KEY = "activeIndex";
+    static const std::string_view TABS_KEY = "tabs";
+    static const std::string_view TABS_CHANGED = "TABS";
+
+#ifdef ARDUINO
+    static const int LISTENER_STACK_SIZE = 4096;
+    static const int LISTENER_PRIORITY = 1;
+#endif
+
+    PushListener::PushListener(hal::ISystemHAL *system, uint16_t push_port)
+        : system_hal(system), port(push_port)
+    {
+#ifdef ARDUINO
+        BaseType_t result = xTaskCreate(listenerTaskWrapper, "push_listener", LISTENER_STACK_SIZE, this,
+                                        LISTENER_PRIORITY, &listener_task_handle);
+        if (result != pdPASS)
+        {
+            LOG_ERROR("PushListener", "Failed to create listener task");
+            throw std::runtime_error("Failed to create push listener task");
+        }
+#else
+        listener_thread = std::thread(&PushListener::run, this);
+#endif
+        LOG_INFO("PushListener", "Listening for ReaperSetlist push updates on UDP port %u", (unsigned)port);
+    }
+
+    PushListener::~PushListener()
+    {
+        should_stop = true;
+#ifdef ARDUINO
+        if (listener_task_handle)
+        {
+            vTaskDelete(listener_task_handle);
+            listener_task_handle = nullptr;
+        }
+#else
+        if (listener_thread.joinable())
+        {
+            listener_thread.join(); // Wakes within RECEIVE_TIMEOUT_MS
+        }
+#endif
+        system_hal->getNetworkManager().udpClose();
+    }
+
+#ifdef ARDUINO
+    void PushListener::listenerTaskWrapper(void *parameter)
+    {
+        static_cast<PushListener *>(parameter)->run();
+        vTaskDelete(nullptr);
+    }
+#endif
+
+    void PushListener::run()
+    {
+        hal::INetworkManager &network = system_hal->getNetworkManager();
+        bool open_failed_logged = false;
+
+        while (!should_stop.load())
+        {
+            if (!network.udpOpen(port))
+            {
+                if (!open_failed_logged)
+                {
+                    LOG_WARNING("PushListener", "Failed to open UDP port %u, retrying", (unsigned)port);
+                    open_failed_logged = true;
+                }
+                system_hal->delay(OPEN_RETRY_MS);
+                continue;
+            }
+
+            int length = network.udpReceive(datagram, sizeof(datagram), RECEIVE_TIMEOUT_MS);
+            if (length < 0)
+            {
+                LOG_WARNING("PushListener", "UDP receive failed, reopening port %u", (unsigned)port);
+                network.udpClose();
+                continue;
+            }
+            if (length == 0)
+            {
+                continue;
+            }
+
+            HttpJobResult update;
+            if (!parseDatagram(std::string_view(datagram, (size_t)length), update))
+            {
+                LOG_WARNING("PushListener", "Ignoring unrecognised %d byte datagram", length);
+                continue;
+            }
+
+            update.timestamp = system_hal->getMillis();
+            last_message_time.store(update.timestamp);
+            have_message.store(true);
+            messages_received.fetch_add(1, std::memory_order_relaxed);
+
+            if (!result_queue.push(std::move(update)))
+            {
+                LOG_WARNING("PushListener", "Dropping push update - main queue full");
+                continue;
+            }
+            system_hal->signalEvent(); // Wake the main loop to apply it
+        }
+    }
+
+    bool PushListener::parseDatagram(std::string_view data, HttpJobResult &result) const
+    {
+        PushUpdateResult &update = result.payload.emplace<PushUpdateResult>();
+        bool recognised = false;
+
+        parser::Tokenizer lines(data, '\n');
+        std::string_view line;
+        std::string_view value;
+        while (lines.next(line))
+        {
+            if (parser::parseTransportLine(line, update.transport_state))
+            {
+                recognised = true;
+            }
+            else if (parser::parseExtStateValue(line, REAPER_SETLIST, ACTIVE_INDEX_KEY, value))
+            {
+                update.has_active_index = parser::parseUnsigned(value, update.active_index);
+                recognised |= update.has_active_index;
+            }
+            else if (line == TABS_CHANGED || parser::parseExtStateValue(line, REAPER_SETLIST, TABS_KEY, value))
+            {
+                update.tabs_changed = true;
+                recognised = true;
+            }
+        }
+
+        result.success = recognised;
+        return recognised;
+    }
+
+} // namespace http
@@ -0,0 +1,223 @@
+#include "response_parser.h"
+#include "log.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace http
+{
+    namespace parser
+    {
+        static const std::string_view EXTSTATE_PREFIX = "EXTSTATE";
+        static const std::string_view TRANSPORT_PREFIX = "TRANSPORT";
+        static const std::string_view COMPACT_SETLIST_PREFIX = "S1:";
+
+        bool Tokenizer::next(std::string_view &token)
+        {
+            while (!remaining.empty())
+            {
+                size_t pos = remaining.find(delimiter);
+                if (pos == std::string_view::npos)
+                {
+                    token = remaining;
+                    remaining = std::string_view();
+                }
+                else
+                {
+                    token = remaining.substr(0, pos);
+                    remaining.remove_prefix(pos + 1);
+                }
+
+                // Remove carriage return / newline at end if present
+                while (!token.empty() && (token.back() == '\r' || token.back() == '\n'))
+                {
+                    token.remove_suffix(1);
+                }
+                if (!token.empty())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        size_t split(std::string_view input, char delimiter, std::string_view *tokens, size_t max_tokens)
+        {
+            Tokenizer tokenizer(input, delimiter);
+            size_t count = 0;
+            while (count < max_tokens && tokenizer.next(tokens[count]))
+            {
+                count++;
+            }
+            return count;
+        }
+
+        bool parseInt(std::string_view token, int &value)
+        {
+            const char *end = token.data() + token.size();
+            auto res = std::from_chars(token.data(), end, value);
+            return res.ec == std::errc() && res.ptr == end;
+        }
+
+        bool parseUnsigned(std::string_view token, unsigned int &value)
+        {
+            const char *end = token.data() + token.size();
+            auto res = std::from_chars(token.data(), end, value);
+            return res.ec == std::errc() && res.ptr == end;
+        }
+
+        bool parseDecimal(std::string_view token, double &value)
+        {
+            // Floating point from_chars is not available in the ESP32 toolchain, so parse the
+            // fixed-point format Reaper emits by hand
+            size_t pos = 0;
+            bool negative = false;
+            if (pos < token.size() && (token[pos] == '-' || token[pos] == '+'))
+            {
+                negative = token[pos] == '-';
+                pos++;
+            }
+
+            uint64_t integer_part = 0;
+            size_t integer_digits = 0;
+            while (pos < token.size() && token[pos] >= '0' && token[pos] <= '9')
+            {
+                integer_part = integer_part * 10 + (token[pos] - '0');
+                integer_digits++;
+                pos++;
+            }
+
+            uint64_t fraction_part = 0;
+            uint64_t fraction_scale = 1;
+            size_t fraction_digits = 0;
+            if (pos < token.size() && token[pos] == '.')
+            {
+                pos++;
+                while (pos < token.size() && token[pos] >= '0' && token[pos] <= '9')
+                {
+                    // Digits beyond 18 are below double precision anyway
+                    if (fraction_digits < 18)
+                    {
+                        fraction_part = fraction_part * 10 + (token[pos] - '0');
+                        fraction_scale *= 10;
+                    }
+                    fraction_digits++;
+                    pos++;
+                }
+            }
+
+            if (pos != token.size() || (integer_digits == 0 && fraction_digits == 0))
+            {
+                return false;
+            }
+
+            double result = (double)integer_part + (double)fraction_part / (double)fraction_scale;
+            value = negative ? -result : result;
+            return true;
+        }
+
+        uint32_t digest(std::string_view data)
+        {
+            uint32_t hash = 2166136261u;
+            for (char c : data)
+            {
+                hash ^= (uint8_t)c;
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        bool parseExtStateValue(std::string_view line, std::string_view section, std::string_view key, std::string_view &value)
+        {
+            std::string_view fields[4];
+            if (splitFields(line, fields, 4) < 4)
+            {
+                return false;
+            }
+            if (fields[0] != EXTSTATE_PREFIX || fields[1] != section || fields[2] != key)
+            {
+                return false;
+            }
+            value = fields[3];
+            return true;
+        }
+
+        // Take the unsigned number at the front of input up to the terminator, consuming both
+        static bool takeUnsigned(std::string_view &input, char terminator, unsigned int &value)
+        {
+            const char *end = input.data() + input.size();
+            auto res = std::from_chars(input.data(), end, value);
+            if (res.ec != std::errc() || res.ptr == end || *res.ptr != terminator)
+            {
+                return false;
+            }
+            input.remove_prefix(res.ptr - input.data() + 1);
+            return true;
+        }
+
+        bool parseCompactSetlist(std::string_view payload, reaper::Setlist &setlist)
+        {
+            if (payload.substr(0, COMPACT_SETLIST_PREFIX.size()) != COMPACT_SETLIST_PREFIX)
+            {
+                return false;
+            }
+            payload.remove_prefix(COMPACT_SETLIST_PREFIX.size());
+
+            unsigned int count = 0;
+            unsigned int table_length = 0;
+            if (!takeUnsigned(payload, ':', count) || !takeUnsigned(payload, ':', table_length) ||
+                table_length > payload.size())
+            {
+                return false;
+            }
+            std::string_view table = payload.substr(0, table_length);
+            payload.remove_prefix(table_length);
+
+            for (unsigned int index = 0; index < count; ++index)
+            {
+                unsigned int length_ms = 0;
+                unsigned int name_offset = 0;
+                unsigned int name_length = 0;
+                if (!takeUnsigned(payload, ',', length_ms) || !takeUnsigned(payload, ',', name_offset) ||
+                    !takeUnsigned(payload, ';', name_length) || name_offset > table.size() ||
+                    name_length > table.size() - name_offset)
+                {
+                    return false;
+                }
+                if (!setlist.add(length_ms / 1000.0f, index, table.substr(name_offset, name_length)))
+                {
+                    LOG_WARNING("parseCompactSetlist", "Setlist full, dropping tabs after %u", (unsigned)setlist.size());
+                    break;
+                }
+            }
+            return true;
+        }
+
+        bool parseTransportLine(std::string_view line, reaper::TransportState &transport_state)
+        {
+            std::string_view fields[5];
+            if (splitFields(line, fields, 5) < 5 || fields[0] != TRANSPORT_PREFIX)
+            {
+                return false;
+            }
+
+            int play_state = 0;
+            double position = 0.0;
+            if (!parseInt(fields[1], play_state) || !parseDecimal(fields[2], position))
+            {
+                return false;
+            }
+
+            transport_state.play_state = play_state;
+            transport_state.position_seconds = position;
+            transport_state.repeat_enabled = (fields[3] == "1");
+            size_t bars_beats_length = std::min(fields[4].size(), sizeof(transport_state.position_bars_beats) - 1);
+            memcpy(transport_state.position_bars_beats, fields[4].data(), bars_beats_length);
+            transport_state.position_bars_beats[bars_beats_length] = '\0';
+            transport_state.success = true;
+            return true;
+        }
+
+    } // namespace parser
+
+} // namespace http
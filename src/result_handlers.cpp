@@ -0,0 +1,240 @@
+#include "result_handlers.h"
+#include "log.h"
+#include "ui_manager.h"
+#include "button_handler.h"
+#include "state_manager.h"
+#include "http_job_manager.h"
+
+// Boot (or wake from deep sleep) to the first transport state, split at the WiFi connection
+// and the script action ID. millis() restarts at each wake, so these are times since wake.
+struct StartupTiming
+{
+    uint32_t wifi_ms = 0;
+    uint32_t script_id_ms = 0;
+    bool script_id_cached = false;
+    bool transport_seen = false; // A live result, not the snapshot restored after deep sleep
+    bool reported = false;
+};
+static StartupTiming startup;
+static AppComponents app;
+
+static void reportStartupTiming(uint32_t current_time)
+{
+    startup.reported = true;
+    LOG_INFO("Main", "%s to first transport: %u ms (WiFi %u ms, script ID %u ms%s)",
+             app.system->wokeFromSleep() ? "Wake" : "Boot", current_time, startup.wifi_ms, startup.script_id_ms,
+             startup.script_id_cached ? ", cached" : "");
+}
+
+static void noteTransportResult(const reaper::TransportState &transport_state)
+{
+    if (transport_state.success)
+    {
+        startup.transport_seen = true;
+    }
+}
+
+// Show the transport state REAPER reported, unless the user is confirming a stop or a play/stop
+// is still waiting on its own result
+static void updatePlayUIState(int play_state)
+{
+    UIState ui_state = app.ui->getCurrentUIState();
+    if (ui_state != UIState::ARE_YOU_SURE && !app.state_manager->isPlayStatePending())
+    {
+        // An open picker stays open while stopped
+        if (play_state == 0 && ui_state != UIState::TAB_PICKER)
+        {
+            app.ui->setUIState(UIState::STOPPED);
+        }
+        else if (play_state == 1)
+        {
+            app.ui->setUIState(UIState::PLAYING);
+        }
+    }
+}
+
+// HTTP result handlers
+
+static void onWiFiConnectResult(const http::HttpJobResult &result, http::WiFiConnectResult &wifi_result, uint32_t)
+{
+    bool ready = false;
+    if (result.success && wifi_result.connected)
+    {
+        LOG_INFO("Main", "WiFi connected successfully. IP: %s", wifi_result.ip_address);
+        if (startup.wifi_ms == 0)
+        {
+            startup.wifi_ms = result.timestamp;
+        }
+
+        // Submit script action ID job now that WiFi is connected, unless it was cached before deep sleep
+        if (app.http_manager->getScriptActionId().empty())
+        {
+            app.http_manager->submitGetScriptActionIdJob();
+        }
+        else
+        {
+            ready = true;
+            if (startup.script_id_ms == 0)
+            {
+                startup.script_id_ms = result.timestamp;
+                startup.script_id_cached = true;
+            }
+        }
+    }
+    else
+    {
+        LOG_ERROR("Main", "WiFi connection failed");
+        app.http_manager->submitWiFiConnectJob();
+        app.ui->clearRestoredState(); // Stop presenting stale state as current
+    }
+    if (!ready)
+    {
+        app.ui->setUIState(UIState::DISCONNECTED);
+    }
+    else if (app.ui->getCurrentUIState() == UIState::DISCONNECTED)
+    {
+        app.ui->setUIState(UIState::STOPPED);
+    }
+    app.ui->updateWiFiUI();
+    app.ui->updateBatteryUI();
+}
+
+static void onChangeTabResult(const http::HttpJobResult &result, http::ChangeTabResult &change_tab_result, uint32_t current_time)
+{
+    LOG_DEBUG("Main", "Processing change tab result - tabs: %u, active_index: %u, play_state: %d",
+              (unsigned)change_tab_result.reaper_state.tabCount(),
+              change_tab_result.reaper_state.active_index,
+              change_tab_result.transport_state.play_state);
+    app.state_manager->confirmTabChange(result.job_id, std::move(change_tab_result.reaper_state),
+                                      change_tab_result.tabs_unchanged, current_time);
+    app.state_manager->updateTransportState(change_tab_result.transport_state, current_time);
+    noteTransportResult(change_tab_result.transport_state);
+    app.button_handler->setAwaitingStateUpdate(false);
+
+    updatePlayUIState(change_tab_result.transport_state.play_state);
+}
+
+static void onChangePlaystateResult(const http::HttpJobResult &result, http::ChangePlaystateResult &change_playstate_result,
+                                    uint32_t current_time)
+{
+    LOG_DEBUG("Main", "Processing change playstate result - play_state: %d",
+              change_playstate_result.transport_state.play_state);
+    app.state_manager->confirmPlayState(result.job_id, change_playstate_result.transport_state, current_time);
+    noteTransportResult(change_playstate_result.transport_state);
+    app.button_handler->setAwaitingTransportUpdate(false);
+
+    // Update UI state from the reconciled transport state
+    int play_state = app.state_manager->getTransportState().play_state;
+    if (!app.state_manager->isPlayStatePending())
+    {
+        if (play_state == 0)
+        {
+            app.ui->setUIState(UIState::STOPPED);
+        }
+        else if (play_state == 1)
+        {
+            app.ui->setUIState(UIState::PLAYING);
+        }
+    }
+}
+
+static void onGetStatusResult(const http::HttpJobResult &, http::GetStatusResult &get_status_result, uint32_t current_time)
+{
+    LOG_DEBUG("Main", "Processing get status result - tabs: %u, active_index: %u, play_state: %d",
+              (unsigned)get_status_result.reaper_state.tabCount(),
+              get_status_result.reaper_state.active_index,
+              get_status_result.transport_state.play_state);
+    app.state_manager->updateReaperState(std::move(get_status_result.reaper_state), get_status_result.tabs_unchanged);
+    app.state_manager->updateTransportState(get_status_result.transport_state, current_time);
+    noteTransportResult(get_status_result.transport_state);
+    app.state_manager->setAwaitingStateUpdate(false);
+    app.state_manager->setHaveReaperState(true);
+}
+
+static void onGetScriptActionIdResult(const http::HttpJobResult &result, http::GetScriptActionIdResult &script_result, uint32_t)
+{
+    LOG_TRACE("Main", "Processing script action ID result");
+    if (result.success && script_result.script_action_id[0] != '\0')
+    {
+        // A standby looked up ahead of failover leaves the UI to the host it reads from
+        bool standby = script_result.host != app.http_manager->getActiveHost() &&
+                       !app.http_manager->getScriptActionId().empty();
+        app.http_manager->setScriptActionId(script_result.script_action_id, script_result.host);
+        if (standby)
+        {
+            LOG_INFO("Main", "Standby host %u script action ID set: %s", (unsigned)script_result.host,
+                     script_result.script_action_id);
+            return;
+        }
+        LOG_INFO("Main", "ReaperSetlist script action ID set: %s", script_result.script_action_id);
+        if (startup.script_id_ms == 0)
+        {
+            startup.script_id_ms = result.timestamp;
+        }
+        app.ui->setUIState(UIState::STOPPED);
+    }
+    else
+    {
+        LOG_ERROR("Main", "Failed to get ReaperSetlist script action ID");
+    }
+}
+
+static void onGetTransportResult(const http::HttpJobResult &, http::GetTransportResult &transport_result, uint32_t current_time)
+{
+    LOG_DEBUG("Main", "Processing transport result - play_state: %d",
+              transport_result.transport_state.play_state);
+    app.state_manager->updateTransportState(transport_result.transport_state, current_time);
+    noteTransportResult(transport_result.transport_state);
+
+    updatePlayUIState(transport_result.transport_state.play_state);
+}
+
+static void onSubscribeResult(const http::HttpJobResult &result, http::SubscribeResult &, uint32_t)
+{
+    if (!result.success)
+    {
+        LOG_WARNING("Main", "Push subscription failed, staying on polling");
+    }
+}
+
+static void onPushUpdateResult(const http::HttpJobResult &, http::PushUpdateResult &push_result, uint32_t current_time)
+{
+    LOG_DEBUG("Main", "Processing push update - transport: %d, active_index: %d, tabs changed: %d",
+              push_result.transport_state.success, push_result.has_active_index, push_result.tabs_changed);
+    if (push_result.has_active_index)
+    {
+        app.state_manager->setActiveIndex(push_result.active_index);
+    }
+    if (push_result.tabs_changed)
+    {
+        app.http_manager->submitGetStatusJob(app.state_manager->getReaperState().tabs_digest);
+    }
+    if (push_result.transport_state.success)
+    {
+        app.state_manager->updateTransportState(push_result.transport_state, current_time);
+        noteTransportResult(push_result.transport_state);
+        updatePlayUIState(push_result.transport_state.play_state);
+    }
+}
+
+void registerResultHandlers(http::ResultDispatcher &results, const AppComponents &components)
+{
+    app = components;
+    startup = StartupTiming();
+    results.on<http::WiFiConnectResult>(onWiFiConnectResult);
+    results.on<http::ChangeTabResult>(onChangeTabResult);
+    results.on<http::ChangePlaystateResult>(onChangePlaystateResult);
+    results.on<http::GetStatusResult>(onGetStatusResult);
+    results.on<http::GetScriptActionIdResult>(onGetScriptActionIdResult);
+    results.on<http::GetTransportResult>(onGetTransportResult);
+    results.on<http::SubscribeResult>(onSubscribeResult);
+    results.on<http::PushUpdateResult>(onPushUpdateResult);
+}
+
+void checkStartupTiming(uint32_t current_time)
+{
+    if (!startup.reported && startup.transport_seen)
+    {
+        reportStartupTiming(current_time);
+    }
+}
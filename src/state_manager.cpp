@@ -1,6 +1,14 @@
 #include "state_manager.h"
 #include "http_job_manager.h"
+#include "response_parser.h"
 #include "log.h"
+#include <math.h>
+#include <cstring>
+
+static bool isAdvancing(const reaper::TransportState &state)
+{
+    return TransportClock::isAdvancing(state);
+}
 
 StateManager::StateManager(http::HttpJobManager *http_manager, UIManager *ui)
     : http_job_manager(http_manager), ui_manager(ui)
@@ -12,18 +20,33 @@ void StateManager::update(unsigned long current_time)
     if (!http_job_manager)
         return;
 
+    // Give up on optimistic actions whose result never arrived (e.g. the result queue overflowed)
+    if (pending_tab.job_id != 0 && current_time - pending_tab.press_time >= OPTIMISTIC_TIMEOUT_MS)
+    {
+        pending_tab = PendingAction();
+        current_reaper_state.active_index = rollback_active_index;
+        rollBack("tab change timed out", current_time);
+    }
+    if (pending_play.job_id != 0 && current_time - pending_play.press_time >= OPTIMISTIC_TIMEOUT_MS)
+    {
+        pending_play = PendingAction();
+        current_transport_state.play_state = rollback_play_state;
+        ui_manager->setUIState(rollback_play_state == 1 ? UIState::PLAYING : UIState::STOPPED);
+        rollBack("play state change timed out", current_time);
+    }
+
     // Update Reaper state if it's time and not awaiting async update
-    if (http_job_manager->isWiFiConnected() && !awaiting_state_update && (current_time - last_reaper_update >= getReaperStateInterval()))
+    if (http_job_manager->isWiFiConnected() && !awaiting_state_update && (current_time - last_reaper_update >= getReaperStateInterval(current_time)))
     {
         awaiting_state_update = true;
-        http_job_manager->submitGetStatusJob();
+        http_job_manager->submitGetStatusJob(current_reaper_state.tabs_digest);
         last_reaper_update = current_time;
         last_transport_update = current_time;
     }
 
     // Periodic transport updates when playing or in "are you sure" mode
     UIState current_ui_state = ui_manager->getCurrentUIState();
-    if (http_job_manager->isWiFiConnected() && (current_ui_state == UIState::PLAYING || current_ui_state == UIState::ARE_YOU_SURE) && (current_time - last_transport_update >= 1000)) // 1 second interval
+    if (http_job_manager->isWiFiConnected() && (current_ui_state == UIState::PLAYING || current_ui_state == UIState::ARE_YOU_SURE) && (current_time - last_transport_update >= getTransportInterval(current_time)))
     {
         http_job_manager->submitGetTransportJob();
         last_transport_update = current_time;
@@ -31,37 +54,584 @@ void StateManager::update(unsigned long current_time)
     }
 }
 
+uint32_t StateManager::msUntilNextUpdate(unsigned long current_time) const
+{
+    uint32_t next = hal::NO_DEADLINE;
+    if (pending_tab.job_id != 0)
+    {
+        next = hal::msRemaining(current_time - pending_tab.press_time, OPTIMISTIC_TIMEOUT_MS);
+    }
+    if (pending_play.job_id != 0)
+    {
+        uint32_t play_timeout = hal::msRemaining(current_time - pending_play.press_time, OPTIMISTIC_TIMEOUT_MS);
+        next = play_timeout < next ? play_timeout : next;
+    }
+
+    // Nothing is polled until WiFi is up - the connect result wakes the loop
+    if (!http_job_manager || !http_job_manager->isWiFiConnected())
+        return next;
+
+    // While a status poll is outstanding its result wakes the loop
+    if (!awaiting_state_update)
+    {
+        uint32_t status_due = hal::msRemaining(current_time - last_reaper_update, getReaperStateInterval(current_time));
+        next = status_due < next ? status_due : next;
+    }
+
+    UIState current_ui_state = ui_manager->getCurrentUIState();
+    if (current_ui_state == UIState::PLAYING || current_ui_state == UIState::ARE_YOU_SURE)
+    {
+        uint32_t transport_due = hal::msRemaining(current_time - last_transport_update, getTransportInterval(current_time));
+        if (transport_due < next)
+        {
+            next = transport_due;
+        }
+
+        // Wake when the shown position reaches its next whole second
+        uint32_t display_due = transport_clock.msUntilNextSecond(current_time);
+        if (display_due < next)
+        {
+            next = display_due;
+        }
+    }
+    return next;
+}
+
+void StateManager::updateTransportState(const reaper::TransportState &state, unsigned long sample_time)
+{
+    // Samples taken before a pending play/stop was applied would undo it
+    if (pending_play.job_id != 0)
+        return;
+
+    if (isAdvancing(current_transport_state) && isAdvancing(state) && state.play_state == current_transport_state.play_state)
+    {
+        double error = state.position_seconds - transport_clock.predictedPosition(sample_time);
+        if (fabs(error) > DRIFT_TOLERANCE_SECONDS)
+        {
+            // Seek, tempo change or a stall - go back to frequent polling
+            LOG_DEBUG("StateManager", "Transport drifted %.2f s from prediction, polling every %lu ms",
+                      error, TRANSPORT_POLL_MIN_MS);
+            transport_poll_interval = TRANSPORT_POLL_MIN_MS;
+            drift_corrections++;
+        }
+        else
+        {
+            transport_poll_interval = transport_poll_interval * 2 > TRANSPORT_POLL_MAX_MS ? TRANSPORT_POLL_MAX_MS
+                                                                                          : transport_poll_interval * 2;
+            predictions_confirmed++;
+        }
+    }
+    else
+    {
+        // Started, stopped or paused - nothing to extrapolate from yet
+        transport_poll_interval = TRANSPORT_POLL_MIN_MS;
+    }
+
+    current_transport_state = state;
+    transport_clock.anchor(state, sample_time);
+}
+
+double StateManager::getPredictedPosition(unsigned long current_time) const
+{
+    double position = transport_clock.position(current_time);
+    if (!transport_clock.isAdvancing())
+    {
+        return position;
+    }
+
+    // Never run past the end of the song - the next poll will tell us what happened there
+    if (current_reaper_state.success && current_reaper_state.hasActiveTab())
+    {
+        double length = current_reaper_state.activeTab().length;
+        if (length > 0.0 && position > length)
+        {
+            position = length;
+        }
+    }
+    return position;
+}
+
+void StateManager::updateReaperState(reaper::ReaperState &&state, bool tabs_unchanged)
+{
+    unsigned int shown_index = current_reaper_state.active_index;
+    if (tabs_unchanged)
+    {
+        // Setlist is the same as the one we hold - only take the fields that can change
+        current_reaper_state.active_index = state.active_index;
+        current_reaper_state.success = state.success;
+    }
+    else
+    {
+        current_reaper_state = std::move(state);
+    }
+
+    // A tab change is still in flight - keep showing where it will land
+    if (pending_tab.job_id != 0)
+    {
+        current_reaper_state.active_index = shown_index;
+    }
+}
+
+void StateManager::setActiveIndex(unsigned int index)
+{
+    if (pending_tab.job_id == 0)
+    {
+        current_reaper_state.active_index = index;
+    }
+}
+
+void StateManager::applyTabChange(int steps, uint32_t job_id, unsigned long press_time)
+{
+    int tab_count = (int)current_reaper_state.tabCount();
+    if (job_id == 0 || tab_count == 0)
+        return;
+
+    if (pending_tab.job_id == 0)
+    {
+        rollback_active_index = current_reaper_state.active_index;
+        pending_tab.press_time = press_time;
+    }
+    pending_tab.job_id = job_id; // Folded presses return the same job, later ones replace it
+
+    // REAPER's next/previous project tab actions wrap around
+    int index = ((int)current_reaper_state.active_index + steps) % tab_count;
+    current_reaper_state.active_index = index < 0 ? index + tab_count : index;
+
+    last_press_time = press_time;
+    press_awaiting_render = true;
+}
+
+void StateManager::applyPlayState(int play_state, uint32_t job_id, unsigned long press_time)
+{
+    if (job_id == 0)
+        return;
+
+    if (pending_play.job_id == 0)
+    {
+        rollback_play_state = current_transport_state.play_state;
+        pending_play.press_time = press_time;
+    }
+    pending_play.job_id = job_id;
+
+    // Extrapolate from the press onwards
+    current_transport_state.position_seconds = getPredictedPosition(press_time);
+    current_transport_state.play_state = play_state;
+    transport_clock.anchor(current_transport_state, press_time, false);
+    ui_manager->setUIState(play_state == 1 ? UIState::PLAYING : UIState::STOPPED);
+
+    last_press_time = press_time;
+    press_awaiting_render = true;
+}
+
+bool StateManager::confirmTabChange(uint32_t job_id, reaper::ReaperState &&state, bool tabs_unchanged, unsigned long current_time)
+{
+    // No optimistic change, or an earlier job while later presses are still in flight
+    if (pending_tab.job_id == 0 || job_id != pending_tab.job_id)
+    {
+        updateReaperState(std::move(state), tabs_unchanged);
+        return true;
+    }
+
+    unsigned int predicted_index = current_reaper_state.active_index;
+    press_to_confirm.record(current_time - pending_tab.press_time);
+    pending_tab = PendingAction();
+
+    if (!state.success)
+    {
+        current_reaper_state.active_index = rollback_active_index;
+        rollBack("tab change failed", current_time);
+        return false;
+    }
+
+    updateReaperState(std::move(state), tabs_unchanged);
+    if (current_reaper_state.active_index != predicted_index)
+    {
+        rollBack("tab change", current_time);
+        return false;
+    }
+    optimistic_confirmed++;
+    return true;
+}
+
+bool StateManager::confirmPlayState(uint32_t job_id, const reaper::TransportState &state, unsigned long current_time)
+{
+    if (pending_play.job_id == 0)
+    {
+        updateTransportState(state, current_time);
+        return true;
+    }
+    if (job_id != pending_play.job_id)
+    {
+        return true; // Superseded by a later press
+    }
+
+    int predicted_play_state = current_transport_state.play_state;
+    press_to_confirm.record(current_time - pending_play.press_time);
+    pending_play = PendingAction();
+
+    if (!state.success)
+    {
+        current_transport_state.play_state = rollback_play_state;
+        rollBack("play state change failed", current_time);
+        return false;
+    }
+
+    updateTransportState(state, current_time);
+    if (state.play_state != predicted_play_state)
+    {
+        rollBack("play state change", current_time);
+        return false;
+    }
+    optimistic_confirmed++;
+    return true;
+}
+
+void StateManager::rollBack(const char *what, unsigned long current_time)
+{
+    optimistic_rolled_back++;
+    LOG_WARNING("StateManager", "Optimistic %s disagreed with REAPER - rolled back", what);
+    ui_manager->showRollbackHint(current_time);
+}
+
+void StateManager::onFrameRendered(unsigned long current_time)
+{
+    if (press_awaiting_render)
+    {
+        press_to_render.record(current_time - last_press_time);
+        press_awaiting_render = false;
+    }
+}
+
 void StateManager::periodicDebugLog(unsigned long current_time)
 {
     static unsigned long last_ui_debug = 0;
     if (current_time - last_ui_debug >= 5000) // Every 5 seconds
     {
         UIState current_ui_state = ui_manager->getCurrentUIState();
-        LOG_TRACE("UI", "UI State: {}, Tabs: {}, Active: {}, Transport: {}",
-                  current_ui_state == UIState::STOPPED ? "STOPPED" : current_ui_state == UIState::PLAYING ? "PLAYING"
-                                                                                                          : "ARE_YOU_SURE",
-                  current_reaper_state.tabs.size(),
+        LOG_TRACE("UI", "UI State: %s, Tabs: %u, Active: %u, Transport: %d",
+                  current_ui_state == UIState::STOPPED      ? "STOPPED"
+                  : current_ui_state == UIState::PLAYING    ? "PLAYING"
+                  : current_ui_state == UIState::TAB_PICKER ? "TAB_PICKER"
+                                                            : "ARE_YOU_SURE",
+                  (unsigned)current_reaper_state.tabCount(),
                   current_reaper_state.active_index,
                   current_transport_state.play_state);
+
+        LOG_DEBUG("UI", "Frames rendered: %u (avg %u us, max %u us), skipped: %u, pixels flushed: %llu",
+                  ui_manager->getFramesRendered(), ui_manager->getAverageFrameMicros(), ui_manager->getMaxFrameMicros(),
+                  ui_manager->getFramesSkipped(), (unsigned long long)ui_manager->getPixelsFlushed());
+
+        hal::HttpStats http_stats = http_job_manager->getHttpStats();
+        if (http_stats.requests > 0)
+        {
+            LOG_DEBUG("HTTP", "Requests: %u (failed %u), new connections: %u, reconnects: %u, avg connect: %u ms, avg TTFB: %u ms",
+                      http_stats.requests, http_stats.failures, http_stats.connections_opened, http_stats.reconnects,
+                      http_stats.total_connect_ms / http_stats.requests, http_stats.total_ttfb_ms / http_stats.requests);
+        }
+
+        if (http_job_manager->getHostCount() > 1)
+        {
+            for (size_t host = 0; host < http_job_manager->getHostCount(); ++host)
+            {
+                const http::HostHealth &health = http_job_manager->getHostHealth(host);
+                LOG_DEBUG("HTTP", "Host %s%s: requests %u (failed %u, %u in a row), last latency %u ms",
+                          http_job_manager->getHostUrl(host).c_str(), host == http_job_manager->getActiveHost() ? " (active)" : "",
+                          health.requests.load(), health.failures.load(), health.consecutive_failures.load(),
+                          health.last_latency_ms.load());
+            }
+        }
+
+        LOG_DEBUG("StateManager", "Transport poll interval: %lu ms, predictions confirmed: %u, drift corrections: %u",
+                  getTransportInterval(current_time), predictions_confirmed, drift_corrections);
+
+        if (press_to_confirm.count() > 0)
+        {
+            LOG_DEBUG("UI", "Press to render: p50 %u ms, p90 %u ms, max %u ms (%u presses)",
+                      press_to_render.percentileMs(50), press_to_render.percentileMs(90), press_to_render.maxMs(),
+                      press_to_render.count());
+            LOG_DEBUG("UI", "Press to confirm: p50 %u ms, p90 %u ms, max %u ms - confirmed %u, rolled back %u",
+                      press_to_confirm.percentileMs(50), press_to_confirm.percentileMs(90), press_to_confirm.maxMs(),
+                      optimistic_confirmed, optimistic_rolled_back);
+        }
+
+        if (http_job_manager->getPushMessagesReceived() > 0)
+        {
+            LOG_DEBUG("HTTP", "Push updates received: %u (active: %d)", http_job_manager->getPushMessagesReceived(),
+                      http_job_manager->isPushActive(current_time));
+        }
+
+        if (http_job_manager->getJobsRejected() > 0 || http_job_manager->getResultsDropped() > 0)
+        {
+            LOG_DEBUG("HTTP", "Queue overflow: %u jobs rejected, %u results dropped",
+                      http_job_manager->getJobsRejected(), http_job_manager->getResultsDropped());
+        }
+
+        for (size_t priority = 0; priority < http::JOB_PRIORITY_COUNT; ++priority)
+        {
+            http::QueueWaitStats wait = http_job_manager->getQueueWaitStats((http::JobPriority)priority);
+            if (wait.jobs > 0)
+            {
+                LOG_DEBUG("HTTP", "Queue wait (%s): avg %u ms, max %u ms over %u jobs",
+                          http::jobPriorityName((http::JobPriority)priority), wait.averageWaitMs(), wait.max_wait_ms, wait.jobs);
+            }
+        }
+
+        const http::JobCoalesceStats &coalesce_stats = http_job_manager->getCoalesceStats();
+        if (coalesce_stats.requestsSaved() > 0)
+        {
+            LOG_DEBUG("HTTP", "Requests saved by coalescing: %u (merged polls %u, dropped transport %u, folded tab presses %u)",
+                      coalesce_stats.requestsSaved(), coalesce_stats.read_jobs_merged,
+                      coalesce_stats.transport_jobs_dropped, coalesce_stats.tab_presses_folded);
+        }
         last_ui_debug = current_time;
     }
 }
 
-unsigned long StateManager::getReaperStateInterval() const
+// Warm resume snapshot: a header, then the UI and transport state, the setlist position and one
+// record per tab (length, index, name length, name bytes). Native layout - only this firmware
+// on this device reads it back, and the version rejects a snapshot from an older build.
+static const uint32_t SNAPSHOT_MAGIC = 0x534e4150; // "SNAP"
+static const uint16_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t body_size;
+    uint32_t checksum; // Digest of the body
+};
+
+struct SnapshotWriter
+{
+    uint8_t *data;
+    size_t capacity;
+    size_t size = 0;
+    bool overflow = false;
+
+    SnapshotWriter(uint8_t *buffer, size_t buffer_size) : data(buffer), capacity(buffer_size) {}
+
+    void putBytes(const void *bytes, size_t length)
+    {
+        if (overflow || length > capacity - size)
+        {
+            overflow = true;
+            return;
+        }
+        memcpy(data + size, bytes, length);
+        size += length;
+    }
+
+    template <typename T>
+    void put(const T &value) { putBytes(&value, sizeof(value)); }
+};
+
+struct SnapshotReader
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    SnapshotReader(const uint8_t *buffer, size_t buffer_size) : data(buffer), size(buffer_size) {}
+
+    // Returns the next length bytes in place, nullptr past the end
+    const uint8_t *take(size_t length)
+    {
+        if (!ok || length > size - pos)
+        {
+            ok = false;
+            return nullptr;
+        }
+        const uint8_t *bytes = data + pos;
+        pos += length;
+        return bytes;
+    }
+
+    void getBytes(void *bytes, size_t length)
+    {
+        const uint8_t *source = take(length);
+        if (source)
+        {
+            memcpy(bytes, source, length);
+        }
+    }
+
+    template <typename T>
+    void get(T &value) { getBytes(&value, sizeof(value)); }
+};
+
+static uint32_t snapshotChecksum(const uint8_t *body, size_t size)
+{
+    return http::parser::digest(std::string_view((const char *)body, size));
+}
+
+void StateManager::saveSnapshot(hal::ISystemHAL &system, UIState ui_state, unsigned long sleep_ms) const
+{
+    size_t capacity = 0;
+    uint8_t *buffer = system.getRetainedBuffer(capacity);
+    if (!buffer || capacity < sizeof(SnapshotHeader))
+        return;
+
+    SnapshotWriter body(buffer + sizeof(SnapshotHeader), capacity - sizeof(SnapshotHeader));
+
+    // A song that keeps playing through the sleep will be further along on wake
+    double position = getPredictedPosition(system.getMillis());
+    if (isAdvancing(current_transport_state) && sleep_ms > 0)
+    {
+        position += sleep_ms / 1000.0;
+    }
+
+    // The stop confirmation and the picker are not worth restoring, wake into the screen behind them
+    uint8_t saved_ui_state = (uint8_t)(ui_state == UIState::ARE_YOU_SURE ? UIState::PLAYING
+                                       : ui_state == UIState::TAB_PICKER ? UIState::STOPPED
+                                                                         : ui_state);
+    body.put(saved_ui_state);
+    body.put(current_transport_state.play_state);
+    body.put(position);
+    body.put(current_transport_state.repeat_enabled);
+    body.putBytes(current_transport_state.position_bars_beats, sizeof(current_transport_state.position_bars_beats));
+    body.put(current_transport_state.success);
+    body.put(current_reaper_state.active_index);
+    body.put(current_reaper_state.tabs_digest);
+    body.put(current_reaper_state.success);
+
+    uint16_t tab_count = (uint16_t)current_reaper_state.tabCount();
+    body.put(tab_count);
+    for (size_t i = 0; i < tab_count; ++i)
+    {
+        const reaper::TabInfo &tab = (*current_reaper_state.tabs)[i];
+        body.put(tab.length);
+        body.put(tab.index);
+        body.put(tab.name_length);
+        body.putBytes(current_reaper_state.tabs->name(i), tab.name_length);
+    }
+
+    SnapshotHeader header = {};
+    if (!body.overflow)
+    {
+        header.magic = SNAPSHOT_MAGIC;
+        header.version = SNAPSHOT_VERSION;
+        header.body_size = (uint16_t)body.size;
+        header.checksum = snapshotChecksum(body.data, body.size);
+        LOG_INFO("StateManager", "Saved %u byte state snapshot (%u tabs)", (unsigned)(sizeof(header) + body.size), (unsigned)tab_count);
+    }
+    else
+    {
+        LOG_WARNING("StateManager", "State snapshot does not fit in %u bytes, not saved", (unsigned)capacity);
+    }
+    memcpy(buffer, &header, sizeof(header));
+}
+
+bool StateManager::restoreSnapshot(hal::ISystemHAL &system, UIState &ui_state)
+{
+    size_t capacity = 0;
+    uint8_t *buffer = system.getRetainedBuffer(capacity);
+    if (!buffer || capacity < sizeof(SnapshotHeader))
+        return false;
+
+    SnapshotHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION || header.body_size > capacity - sizeof(header))
+        return false;
+
+    // Consumed either way - a later reset must not bring back this state
+    const uint8_t *body_data = buffer + sizeof(header);
+    memset(buffer, 0, sizeof(header));
+    if (snapshotChecksum(body_data, header.body_size) != header.checksum)
+    {
+        LOG_WARNING("StateManager", "State snapshot checksum mismatch, starting cold");
+        return false;
+    }
+
+    SnapshotReader body(body_data, header.body_size);
+    uint8_t saved_ui_state = 0;
+    reaper::TransportState transport_state;
+    reaper::ReaperState reaper_state;
+    body.get(saved_ui_state);
+    body.get(transport_state.play_state);
+    body.get(transport_state.position_seconds);
+    body.get(transport_state.repeat_enabled);
+    body.getBytes(transport_state.position_bars_beats, sizeof(transport_state.position_bars_beats));
+    body.get(transport_state.success);
+    body.get(reaper_state.active_index);
+    body.get(reaper_state.tabs_digest);
+    body.get(reaper_state.success);
+
+    uint16_t tab_count = 0;
+    body.get(tab_count);
+    if (tab_count > 0)
+    {
+        reaper_state.tabs.reset(new reaper::Setlist());
+        for (uint16_t i = 0; i < tab_count && body.ok; ++i)
+        {
+            float length = 0.0f;
+            unsigned int index = 0;
+            uint16_t name_length = 0;
+            body.get(length);
+            body.get(index);
+            body.get(name_length);
+            const uint8_t *name = body.take(name_length);
+            if (name && !reaper_state.tabs->add(length, index, std::string_view((const char *)name, name_length)))
+            {
+                body.ok = false;
+            }
+        }
+    }
+
+    if (!body.ok || saved_ui_state > (uint8_t)UIState::PLAYING)
+    {
+        LOG_WARNING("StateManager", "State snapshot is malformed, starting cold");
+        return false;
+    }
+
+    // have_reaper_state stays false so the first status poll goes out as soon as WiFi is up. It
+    // sends the restored digest, so an unchanged setlist is not parsed again.
+    current_reaper_state = std::move(reaper_state);
+    current_transport_state = transport_state;
+    transport_clock.anchor(current_transport_state, system.getMillis(), false);
+    ui_state = (UIState)saved_ui_state;
+    LOG_INFO("StateManager", "Restored state snapshot (%u tabs, active %u, play state %d)",
+             (unsigned)current_reaper_state.tabCount(), current_reaper_state.active_index, current_transport_state.play_state);
+    return true;
+}
+
+unsigned long StateManager::getReaperStateInterval(unsigned long current_time) const
 {
     if (!have_reaper_state)
     {
         return 1000; // Get it ASAP if we don't have it
     }
+    if (http_job_manager->isPushActive(current_time))
+    {
+        return PUSH_FALLBACK_POLL_MS; // REAPER pushes setlist changes, poll only as a safety net
+    }
     return 10000; // Every 10 seconds if we have it
 }
 
-unsigned long StateManager::getTransportInterval() const
+unsigned long StateManager::getTransportInterval(unsigned long current_time) const
 {
     UIState current_ui_state = ui_manager->getCurrentUIState();
-    if (current_ui_state == UIState::STOPPED)
+    if (current_ui_state == UIState::STOPPED || current_ui_state == UIState::TAB_PICKER)
     {
         return 10000; // Every 10 seconds when stopped
     }
-    return 1000; // Every 1 second when playing or "are you sure"
+    if (http_job_manager->isPushActive(current_time))
+    {
+        return PUSH_FALLBACK_POLL_MS; // Play state changes and seeks are pushed
+    }
+    if (!isAdvancing(current_transport_state))
+    {
+        return TRANSPORT_POLL_MIN_MS;
+    }
+
+    // Tighten up near the end of the song so the stop or next song shows promptly
+    if (current_reaper_state.success && current_reaper_state.hasActiveTab())
+    {
+        double remaining = current_reaper_state.activeTab().length - getPredictedPosition(current_time);
+        if (remaining * 1000.0 < SONG_END_WINDOW_MS)
+        {
+            return TRANSPORT_POLL_MIN_MS;
+        }
+    }
+    return transport_poll_interval;
 }
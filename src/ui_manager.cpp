@@ -1,6 +1,9 @@
 #include "ui_manager.h"
 #include "log.h"
+#include "perf_metrics.h"
 #include <cstdio>
+#include <cstring>
+#include <climits>
 
 UIManager::UIManager(hal::ISystemHAL *hal) : system_hal(hal), wifi_connected(false), reaper_connected(false)
 {
@@ -25,9 +28,164 @@ void UIManager::createUI()
 
     createTabInfoSection(main_ui_container);
     createTransportSection(main_ui_container);
+    createTabPicker(main_ui_container);
     createButtonSection(main_ui_container);
     // Start with connection status showing
     showConnectionStatus("Connecting to WiFi...");
+
+    // Track whether LVGL has anything to redraw
+    lv_display_t *disp = lv_display_get_default();
+    if (disp)
+    {
+        lv_display_add_event_cb(disp, onDisplayEvent, LV_EVENT_INVALIDATE_AREA, this);
+        lv_display_add_event_cb(disp, onDisplayEvent, LV_EVENT_REFR_READY, this);
+    }
+}
+
+void UIManager::onDisplayEvent(lv_event_t *e)
+{
+    UIManager *ui = static_cast<UIManager *>(lv_event_get_user_data(e));
+    // Any invalidated area needs a refresh, a completed refresh has drawn them all
+    ui->render_pending = (lv_event_get_code(e) == LV_EVENT_INVALIDATE_AREA);
+}
+
+bool UIManager::refreshIfDirty()
+{
+    // Animations advance from LVGL's timers; without any running there is nothing for the
+    // timer handler to do beyond what lv_refr_now() below covers
+    if (lv_anim_count_running() > 0)
+    {
+        lv_timer_handler();
+    }
+
+    lv_display_t *disp = lv_display_get_default();
+    if (!disp || !render_pending)
+    {
+        frames_skipped++;
+        return false;
+    }
+
+#if PERF_METRICS
+    uint64_t pixels_before = getPixelsFlushed();
+#endif
+    uint32_t start_us = system_hal ? system_hal->getMicros() : 0;
+    lv_refr_now(disp);
+    uint32_t frame_us = system_hal ? system_hal->getMicros() - start_us : 0;
+    PERF_RECORD(perf::Metric::RENDER, frame_us);
+    PERF_RECORD(perf::Metric::FLUSH_BYTES, (getPixelsFlushed() - pixels_before) * sizeof(uint16_t));
+
+    frames_rendered++;
+    last_frame_us = frame_us;
+    total_frame_us += frame_us;
+    if (frame_us > max_frame_us)
+    {
+        max_frame_us = frame_us;
+    }
+    return true;
+}
+
+void UIManager::showRollbackHint(unsigned long current_time)
+{
+    if (!tab_name_label)
+        return;
+
+    setTextColor(tab_name_label, lv_color_hex(0xFFA500)); // Orange
+    rollback_hint_time = current_time;
+    rollback_hint_shown = true;
+}
+
+void UIManager::setMemoryDegraded(bool degraded)
+{
+    memory_degraded = degraded;
+    if (!degraded)
+        return;
+
+    // Neighbours are laid out again on the next tab change once memory recovers
+    for (size_t i = 0; i < TAB_SLOT_COUNT; ++i)
+    {
+        if (i != shown_tab_slot && tab_slots[i].label)
+        {
+            lv_label_set_text(tab_slots[i].label, "");
+            tab_slots[i].index = UINT_MAX;
+        }
+    }
+
+    // An open picker closes, as on its timeout, and gives its rows back
+    if (current_ui_state == UIState::TAB_PICKER)
+    {
+        current_ui_state = UIState::STOPPED;
+        updateButtonLabelsUI();
+    }
+    for (unsigned int i = 0; i < TAB_PICKER_ROWS; ++i)
+    {
+        if (tab_picker_rows[i])
+        {
+            lv_obj_delete(tab_picker_rows[i]);
+            tab_picker_rows[i] = nullptr;
+        }
+    }
+    tab_picker_row_count = 0;
+}
+
+uint32_t UIManager::msUntilNextUpdate(unsigned long current_time) const
+{
+    if (render_pending)
+    {
+        return 0;
+    }
+    if (lv_anim_count_running() > 0)
+    {
+        return ANIMATION_FRAME_MS;
+    }
+    uint32_t next = hal::msRemaining(current_time - last_battery_update, BATTERY_UPDATE_INTERVAL);
+#if PERF_METRICS
+    if (perf_overlay_shown)
+    {
+        uint32_t overlay_due = hal::msRemaining(current_time - last_perf_overlay_update, PERF_OVERLAY_INTERVAL);
+        next = overlay_due < next ? overlay_due : next;
+    }
+#endif
+    if (rollback_hint_shown)
+    {
+        uint32_t hint_due = hal::msRemaining(current_time - rollback_hint_time, ROLLBACK_HINT_MS);
+        next = hint_due < next ? hint_due : next;
+    }
+    if (current_ui_state == UIState::TAB_PICKER)
+    {
+        uint32_t picker_due = hal::msRemaining(current_time - tab_picker_input_time, TAB_PICKER_TIMEOUT_MS);
+        next = picker_due < next ? picker_due : next;
+    }
+    return next;
+}
+
+uint64_t UIManager::getPixelsFlushed() const
+{
+    return system_hal ? system_hal->getDisplayManager().getPixelsFlushed() : 0;
+}
+
+void UIManager::setLabelText(lv_obj_t *label, const char *text)
+{
+    const char *current = lv_label_get_text(label);
+    if (current && strcmp(current, text) == 0)
+        return;
+    lv_label_set_text(label, text);
+}
+
+void UIManager::setTextColor(lv_obj_t *obj, lv_color_t color)
+{
+    if (lv_color_eq(lv_obj_get_style_text_color(obj, LV_PART_MAIN), color))
+        return;
+    lv_obj_set_style_text_color(obj, color, 0);
+}
+
+void UIManager::setHidden(lv_obj_t *obj, bool hidden)
+{
+    if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) == hidden)
+        return;
+    if (hidden)
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    else
+        lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
 }
 
 void UIManager::updateBatteryUI()
@@ -74,12 +232,13 @@ void UIManager::updateBatteryUI()
         icon_color = lv_color_hex(0xFF0000); // Red
     }
 
-    auto battery_percent_text = std::to_string(battery_percent) + "%";
-    lv_label_set_text(battery_percentage_label, battery_percent_text.c_str());
-    lv_obj_set_style_text_color(battery_percentage_label, icon_color, 0);
+    char battery_percent_text[8];
+    snprintf(battery_percent_text, sizeof(battery_percent_text), "%u%%", (unsigned)battery_percent);
+    setLabelText(battery_percentage_label, battery_percent_text);
+    setTextColor(battery_percentage_label, icon_color);
 
-    lv_label_set_text(battery_icon_label, icon_text);
-    lv_obj_set_style_text_color(battery_icon_label, icon_color, 0);
+    setLabelText(battery_icon_label, icon_text);
+    setTextColor(battery_icon_label, icon_color);
 }
 
 void UIManager::updateWiFiUI()
@@ -98,8 +257,7 @@ void UIManager::updateWiFiUI(const bool connected)
 
     LOG_INFO("WIFI", "Connected %d", connected);
     auto color = connected ? lv_palette_main(LV_PALETTE_GREEN) : lv_palette_main(LV_PALETTE_RED);
-    lv_obj_set_style_text_color(wifi_status_label, color, 0);
-    lv_obj_invalidate(wifi_status_label);
+    setTextColor(wifi_status_label, color);
 
     // Track WiFi connection state and update UI
     wifi_connected = connected;
@@ -113,48 +271,43 @@ void UIManager::updateReaperStateUI(const reaper::ReaperState &state)
 
     bool reaper_is_connected = state.success;
     auto status_color = reaper_is_connected ? lv_palette_main(LV_PALETTE_GREEN) : lv_palette_main(LV_PALETTE_RED);
-    lv_obj_set_style_text_color(reaper_status_label, status_color, 0);
-    lv_obj_invalidate(reaper_status_label);
+    setTextColor(reaper_status_label, status_color);
 
-    if (state.success && !state.tabs.empty())
+    if (state.success && state.tabCount() > 0)
     {
         // Update tab info
         char tab_info[32];
         snprintf(tab_info, sizeof(tab_info), "[%d of %d]",
-                 state.active_index + 1, (int)state.tabs.size());
-        lv_label_set_text(tab_info_label, tab_info);
-        lv_obj_invalidate(tab_info_label);
+                 state.active_index + 1, (int)state.tabCount());
+        setLabelText(tab_info_label, tab_info);
 
         // Update tab name
-        if (state.active_index < state.tabs.size())
+        if (state.hasActiveTab())
         {
-            const auto &active_tab = state.tabs[state.active_index];
-            lv_label_set_text(tab_name_label, active_tab.name.c_str());
-            lv_obj_invalidate(tab_name_label);
+            showActiveTab(state);
 
-            // Debug output
-            static std::string last_tab_name;
-            if (last_tab_name != active_tab.name)
+            // Debug output - the setlist digest stands in for the name, no copy is kept
+            static unsigned int last_logged_index = UINT_MAX;
+            static uint32_t last_logged_digest = 0;
+            if (last_logged_index != state.active_index || last_logged_digest != state.tabs_digest)
             {
-                LOG_INFO("UI", "UI Updated: Tab [{} of {}] - {}",
+                LOG_INFO("UI", "UI Updated: Tab [%u of %u] - %s",
                          state.active_index + 1,
-                         state.tabs.size(),
-                         active_tab.name.c_str());
-                last_tab_name = active_tab.name;
+                         (unsigned)state.tabCount(),
+                         state.activeTabName());
+                last_logged_index = state.active_index;
+                last_logged_digest = state.tabs_digest;
             }
         }
         else
         {
-            lv_label_set_text(tab_name_label, "Invalid Tab");
-            lv_obj_invalidate(tab_name_label);
+            showTabMessage("Invalid Tab");
         }
     }
     else
     {
-        lv_label_set_text(tab_info_label, "[? of ?]");
-        lv_label_set_text(tab_name_label, "No Connection");
-        lv_obj_invalidate(tab_info_label);
-        lv_obj_invalidate(tab_name_label);
+        setLabelText(tab_info_label, "[? of ?]");
+        showTabMessage("No Connection");
     }
 
     // Track Reaper connection state and update UI
@@ -162,7 +315,91 @@ void UIManager::updateReaperStateUI(const reaper::ReaperState &state)
     updateConnectionState(wifi_connected, reaper_connected);
 }
 
-void UIManager::updateTransportUI(const reaper::TransportState &transport_state, const reaper::ReaperState &reaper_state)
+void UIManager::prepareTabSlot(TabSlot &slot, const reaper::ReaperState &state, unsigned int index)
+{
+    const reaper::TabInfo &tab = (*state.tabs)[index];
+    const char *name = state.tabs->name(index);
+    if (slot.index == index && slot.length == tab.length && strcmp(lv_label_get_text(slot.label), name) == 0)
+        return;
+
+    // The text layout happens here, while the label is still hidden for a neighbour
+    lv_label_set_text(slot.label, name);
+    slot.index = index;
+    slot.length = tab.length;
+    snprintf(slot.length_text, sizeof(slot.length_text), "%d:%02d", (int)(tab.length / 60), (int)tab.length % 60);
+}
+
+void UIManager::showActiveTab(const reaper::ReaperState &state)
+{
+    unsigned int count = (unsigned int)state.tabCount();
+    unsigned int active = state.active_index;
+
+    // Swap to the slot already holding the active tab - relaid out in the shown slot otherwise
+    size_t shown = shown_tab_slot;
+    for (size_t i = 0; i < TAB_SLOT_COUNT; ++i)
+    {
+        if (tab_slots[i].index == active)
+        {
+            shown = i;
+            break;
+        }
+    }
+    prepareTabSlot(tab_slots[shown], state, active);
+    if (shown != shown_tab_slot)
+    {
+        lv_obj_t *previous = tab_slots[shown_tab_slot].label;
+        setHidden(tab_slots[shown].label, false);
+        setHidden(previous, true);
+        // A rollback hint stays with the tab name, whichever label shows it
+        setTextColor(tab_slots[shown].label, lv_obj_get_style_text_color(previous, LV_PART_MAIN));
+        setTextColor(previous, lv_color_hex(0xFFFFFF));
+        shown_tab_slot = shown;
+        tab_name_label = tab_slots[shown].label;
+    }
+
+    if (memory_degraded)
+        return;
+
+    // Next/previous wrap around like REAPER's tab actions
+    unsigned int neighbours[] = {(active + 1) % count, (active + count - 1) % count};
+    for (unsigned int index : neighbours)
+    {
+        if (index == active)
+            continue;
+
+        TabSlot *target = nullptr;
+        for (TabSlot &slot : tab_slots)
+        {
+            if (slot.index == index)
+            {
+                target = &slot;
+                break;
+            }
+        }
+        // Otherwise the hidden slot that holds neither the active tab nor the other neighbour
+        for (size_t i = 0; !target && i < TAB_SLOT_COUNT; ++i)
+        {
+            unsigned int held = tab_slots[i].index;
+            if (i != shown_tab_slot && held != neighbours[0] && held != neighbours[1])
+            {
+                target = &tab_slots[i];
+            }
+        }
+        if (target)
+        {
+            prepareTabSlot(*target, state, index);
+        }
+    }
+}
+
+void UIManager::showTabMessage(const char *text)
+{
+    TabSlot &slot = tab_slots[shown_tab_slot];
+    setLabelText(slot.label, text);
+    slot.index = UINT_MAX;
+}
+
+void UIManager::updateTransportUI(const reaper::TransportState &transport_state, const reaper::ReaperState &reaper_state, double position_seconds)
 {
     if (!play_icon_label || !time_label)
         return;
@@ -203,33 +440,45 @@ void UIManager::updateTransportUI(const reaper::TransportState &transport_state,
         icon_color = lv_color_hex(0x808080); // Gray
     }
 
-    lv_label_set_text(play_icon_label, icon_text);
-    lv_obj_set_style_text_color(play_icon_label, icon_color, 0);
-    lv_obj_invalidate(play_icon_label);
+    setLabelText(play_icon_label, icon_text);
+    setTextColor(play_icon_label, icon_color);
+
+    // Update time display - formatted only when the shown second or the song length changes
+    bool has_time = transport_state.success && reaper_state.success && reaper_state.hasActiveTab();
+    int shown_seconds = has_time ? (int)position_seconds : -1;
+    float shown_length = has_time ? reaper_state.activeTab().length : -1.0f;
+    if (shown_seconds == time_label_seconds && shown_length == time_label_length)
+        return;
+    time_label_seconds = shown_seconds;
+    time_label_length = shown_length;
 
-    // Update time display
     char time_text[32];
-    if (transport_state.success && reaper_state.success &&
-        reaper_state.active_index < reaper_state.tabs.size())
+    if (has_time)
     {
-        double current_pos = transport_state.position_seconds;
-        double total_length = reaper_state.tabs[reaper_state.active_index].length;
+        int current_min = shown_seconds / 60;
+        int current_sec = shown_seconds % 60;
 
-        int current_min = (int)(current_pos / 60);
-        int current_sec = (int)(current_pos) % 60;
-        int total_min = (int)(total_length / 60);
-        int total_sec = (int)(total_length) % 60;
-
-        snprintf(time_text, sizeof(time_text), "%d:%02d / %d:%02d",
-                 current_min, current_sec, total_min, total_sec);
+        // The shown tab slot has the length formatted already
+        const TabSlot &slot = tab_slots[shown_tab_slot];
+        if (slot.index == reaper_state.active_index && slot.length == reaper_state.activeTab().length)
+        {
+            snprintf(time_text, sizeof(time_text), "%d:%02d / %s", current_min, current_sec, slot.length_text);
+        }
+        else
+        {
+            double total_length = reaper_state.activeTab().length;
+            int total_min = (int)(total_length / 60);
+            int total_sec = (int)(total_length) % 60;
+            snprintf(time_text, sizeof(time_text), "%d:%02d / %d:%02d",
+                     current_min, current_sec, total_min, total_sec);
+        }
     }
     else
     {
         snprintf(time_text, sizeof(time_text), "0:00 / 0:00");
     }
 
-    lv_label_set_text(time_label, time_text);
-    lv_obj_invalidate(time_label);
+    setLabelText(time_label, time_text);
 }
 
 void UIManager::updateButtonLabelsUI()
@@ -240,61 +489,129 @@ void UIManager::updateButtonLabelsUI()
     static UIState last_ui_state = UIState::STOPPED;
     if (last_ui_state != current_ui_state)
     {
-        LOG_INFO("UI", "Button labels updating for state: {}",
-                 current_ui_state == UIState::STOPPED ? "STOPPED" : current_ui_state == UIState::PLAYING ? "PLAYING"
-                                                                                                         : "ARE_YOU_SURE");
+        LOG_INFO("UI", "Button labels updating for state: %s",
+                 current_ui_state == UIState::STOPPED      ? "STOPPED"
+                 : current_ui_state == UIState::PLAYING    ? "PLAYING"
+                 : current_ui_state == UIState::TAB_PICKER ? "TAB_PICKER"
+                                                           : "ARE_YOU_SURE");
         last_ui_state = current_ui_state;
     }
 
     switch (current_ui_state)
     {
     case UIState::DISCONNECTED:
-        lv_label_set_text(btn1_label, LV_SYMBOL_CLOSE);
-        lv_label_set_text(btn2_label, LV_SYMBOL_CLOSE);
-        lv_label_set_text(btn3_label, LV_SYMBOL_CLOSE);
-        lv_obj_add_flag(are_you_sure_label, LV_OBJ_FLAG_HIDDEN); // Hide "Are you sure?"
+        setLabelText(btn1_label, LV_SYMBOL_CLOSE);
+        setLabelText(btn2_label, LV_SYMBOL_CLOSE);
+        setLabelText(btn3_label, LV_SYMBOL_CLOSE);
+        setHidden(are_you_sure_label, true); // Hide "Are you sure?"
         break;
     case UIState::STOPPED:
-        lv_label_set_text(btn1_label, LV_SYMBOL_PREV);
-        lv_label_set_text(btn2_label, LV_SYMBOL_PLAY);
-        lv_label_set_text(btn3_label, LV_SYMBOL_NEXT);
-        lv_obj_add_flag(are_you_sure_label, LV_OBJ_FLAG_HIDDEN); // Hide "Are you sure?"
+        setLabelText(btn1_label, LV_SYMBOL_PREV);
+        setLabelText(btn2_label, LV_SYMBOL_PLAY);
+        setLabelText(btn3_label, LV_SYMBOL_NEXT);
+        setHidden(are_you_sure_label, true); // Hide "Are you sure?"
         break;
     case UIState::PLAYING:
-        lv_label_set_text(btn1_label, "");
-        lv_label_set_text(btn2_label, LV_SYMBOL_STOP);
-        lv_label_set_text(btn3_label, "");
-        lv_obj_add_flag(are_you_sure_label, LV_OBJ_FLAG_HIDDEN); // Hide "Are you sure?"
+        setLabelText(btn1_label, "");
+        setLabelText(btn2_label, LV_SYMBOL_STOP);
+        setLabelText(btn3_label, "");
+        setHidden(are_you_sure_label, true); // Hide "Are you sure?"
         break;
     case UIState::ARE_YOU_SURE:
-        lv_label_set_text(btn1_label, LV_SYMBOL_OK);
-        lv_label_set_text(btn2_label, LV_SYMBOL_CLOSE);
-        lv_label_set_text(btn3_label, LV_SYMBOL_CLOSE);
-        lv_obj_clear_flag(are_you_sure_label, LV_OBJ_FLAG_HIDDEN); // Show "Are you sure?"
+        setLabelText(btn1_label, LV_SYMBOL_OK);
+        setLabelText(btn2_label, LV_SYMBOL_CLOSE);
+        setLabelText(btn3_label, LV_SYMBOL_CLOSE);
+        setHidden(are_you_sure_label, false); // Show "Are you sure?"
+        break;
+    case UIState::TAB_PICKER:
+        setLabelText(btn1_label, LV_SYMBOL_UP);
+        setLabelText(btn2_label, LV_SYMBOL_OK);
+        setLabelText(btn3_label, LV_SYMBOL_DOWN);
+        setHidden(are_you_sure_label, true); // Hide "Are you sure?"
         break;
     }
 
-    // Force redraw of all button labels and the "Are you sure?" label
-    lv_obj_invalidate(btn1_label);
-    lv_obj_invalidate(btn2_label);
-    lv_obj_invalidate(btn3_label);
-    lv_obj_invalidate(are_you_sure_label);
+    // The picker stands in for the tab name and time while open
+    bool picking = current_ui_state == UIState::TAB_PICKER;
+    if (tab_picker)
+    {
+        setHidden(tab_picker, !picking);
+        setHidden(play_row, picking);
+        setHidden(time_label, picking);
+    }
 }
 
 void UIManager::updatePeriodicUI(unsigned long current_time)
 {
+    if (current_ui_state == UIState::TAB_PICKER && current_time - tab_picker_input_time >= TAB_PICKER_TIMEOUT_MS)
+    {
+        LOG_INFO("UI", "Setlist picker closed after %lu ms without input", TAB_PICKER_TIMEOUT_MS);
+        current_ui_state = UIState::STOPPED;
+    }
+
+    if (rollback_hint_shown && current_time - rollback_hint_time >= ROLLBACK_HINT_MS)
+    {
+        setTextColor(tab_name_label, lv_color_hex(0xFFFFFF));
+        rollback_hint_shown = false;
+    }
+
     // Update battery UI every 30 seconds
-    if (current_time - last_battery_update >= 30000)
+    if (current_time - last_battery_update >= BATTERY_UPDATE_INTERVAL)
     {
         updateWiFiUI();
         updateBatteryUI();
         last_battery_update = current_time;
     }
+
+#if PERF_METRICS
+    if (perf_overlay_shown && current_time - last_perf_overlay_update >= PERF_OVERLAY_INTERVAL)
+    {
+        updatePerfOverlay(current_time);
+    }
+#endif
 }
 
+#if PERF_METRICS
+void UIManager::togglePerfOverlay(unsigned long current_time)
+{
+    if (!perf_overlay_label)
+    {
+        perf_overlay_label = lv_label_create(lv_layer_top());
+        lv_obj_set_size(perf_overlay_label, LV_PCT(100), LV_SIZE_CONTENT);
+        lv_obj_align(perf_overlay_label, LV_ALIGN_TOP_LEFT, 0, 0);
+        lv_obj_set_style_bg_color(perf_overlay_label, lv_color_black(), LV_PART_MAIN);
+        lv_obj_set_style_bg_opa(perf_overlay_label, LV_OPA_70, LV_PART_MAIN);
+        lv_obj_set_style_text_color(perf_overlay_label, lv_color_hex(0x00FF00), LV_PART_MAIN);
+        lv_obj_set_style_pad_all(perf_overlay_label, 4, LV_PART_MAIN);
+        setHidden(perf_overlay_label, true);
+    }
+
+    perf_overlay_shown = !perf_overlay_shown;
+    setHidden(perf_overlay_label, !perf_overlay_shown);
+    if (perf_overlay_shown)
+    {
+        updatePerfOverlay(current_time);
+    }
+    LOG_INFO("UIManager", "Metrics overlay %s", perf_overlay_shown ? "shown" : "hidden");
+}
+
+void UIManager::updatePerfOverlay(unsigned long current_time)
+{
+    char text[640];
+    perf::formatOverlay(text, sizeof(text), system_hal ? system_hal->getHeapStats() : hal::HeapStats());
+    setLabelText(perf_overlay_label, text);
+    last_perf_overlay_update = current_time;
+}
+#endif
+
 void UIManager::updateConnectionState(bool wifi_connected, bool reaper_connected)
 {
-    if (!wifi_connected)
+    if (showing_restored_state)
+    {
+        showing_restored_state = !(wifi_connected && reaper_connected);
+        showMainUI();
+    }
+    else if (!wifi_connected)
     {
         showConnectionStatus("Connecting to WiFi...");
     }
@@ -308,18 +625,17 @@ void UIManager::updateConnectionState(bool wifi_connected, bool reaper_connected
     }
 }
 
-void UIManager::showConnectionStatus(const std::string &message)
+void UIManager::showConnectionStatus(const char *message)
 {
     if (!connection_status_label || !main_ui_container)
         return;
 
     // Hide main UI
-    lv_obj_add_flag(main_ui_container, LV_OBJ_FLAG_HIDDEN);
+    setHidden(main_ui_container, true);
 
     // Show connection status message
-    lv_label_set_text(connection_status_label, message.c_str());
-    lv_obj_clear_flag(connection_status_label, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_invalidate(connection_status_label);
+    setLabelText(connection_status_label, message);
+    setHidden(connection_status_label, false);
 }
 
 void UIManager::showMainUI()
@@ -328,11 +644,25 @@ void UIManager::showMainUI()
         return;
 
     // Hide connection status message
-    lv_obj_add_flag(connection_status_label, LV_OBJ_FLAG_HIDDEN);
+    setHidden(connection_status_label, true);
 
     // Show main UI
-    lv_obj_clear_flag(main_ui_container, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_invalidate(main_ui_container);
+    setHidden(main_ui_container, false);
+}
+
+void UIManager::showRestoredState()
+{
+    showing_restored_state = true;
+    showMainUI();
+}
+
+void UIManager::clearRestoredState()
+{
+    if (showing_restored_state)
+    {
+        showing_restored_state = false;
+        updateConnectionState(wifi_connected, reaper_connected);
+    }
 }
 
 // Private UI creation helper methods
@@ -425,7 +755,7 @@ void UIManager::createTabInfoSection(lv_obj_t *parent)
 void UIManager::createTransportSection(lv_obj_t *parent)
 {
     // Play status container (Play icon + Tab name)
-    lv_obj_t *play_row = lv_obj_create(parent);
+    play_row = lv_obj_create(parent);
     lv_obj_set_size(play_row, LV_PCT(100), LV_SIZE_CONTENT);
     lv_obj_set_layout(play_row, LV_LAYOUT_FLEX);
     lv_obj_set_flex_flow(play_row, LV_FLEX_FLOW_ROW);
@@ -439,9 +769,19 @@ void UIManager::createTransportSection(lv_obj_t *parent)
     lv_label_set_text(play_icon_label, LV_SYMBOL_STOP);
     lv_obj_set_style_text_color(play_icon_label, lv_color_hex(0xFF0000), 0);
 
-    tab_name_label = lv_label_create(play_row);
-    lv_label_set_text(tab_name_label, "No Tab Selected");
-    lv_obj_set_style_text_color(tab_name_label, lv_color_hex(0xFFFFFF), 0);
+    // Hidden labels take no space in the row, only the shown slot is laid out in it
+    for (size_t i = 0; i < TAB_SLOT_COUNT; ++i)
+    {
+        lv_obj_t *label = lv_label_create(play_row);
+        lv_label_set_text(label, i == 0 ? "No Tab Selected" : "");
+        lv_obj_set_style_text_color(label, lv_color_hex(0xFFFFFF), 0);
+        if (i != shown_tab_slot)
+        {
+            lv_obj_add_flag(label, LV_OBJ_FLAG_HIDDEN);
+        }
+        tab_slots[i].label = label;
+    }
+    tab_name_label = tab_slots[shown_tab_slot].label;
 
     time_label = lv_label_create(parent);
     lv_label_set_text(time_label, "0:00 / 0:00");
@@ -457,6 +797,125 @@ void UIManager::createTransportSection(lv_obj_t *parent)
     printf("createTransportSection - Completed\n");
 }
 
+void UIManager::createTabPicker(lv_obj_t *parent)
+{
+    // Setlist picker, takes the place of the transport rows while open (initially hidden)
+    tab_picker = lv_obj_create(parent);
+    lv_obj_set_size(tab_picker, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_flex_grow(tab_picker, 1);
+    lv_obj_set_layout(tab_picker, LV_LAYOUT_FLEX);
+    lv_obj_set_flex_flow(tab_picker, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_style_bg_opa(tab_picker, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_opa(tab_picker, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_pad_all(tab_picker, 0, 0);
+    lv_obj_set_style_pad_gap(tab_picker, 2, 0);
+    lv_obj_add_flag(tab_picker, LV_OBJ_FLAG_HIDDEN);
+}
+
+bool UIManager::createTabPickerRows()
+{
+    // Each row is checked against the pool first - a failed LVGL allocation asserts and hangs
+    while (tab_picker_row_count < TAB_PICKER_ROWS)
+    {
+        lv_mem_monitor_t mem;
+        lv_mem_monitor(&mem);
+        if (mem.free_biggest_size < MEMORY_RESERVE_LVGL_BLOCK)
+        {
+            LOG_WARNING("UI", "Setlist picker limited to %u rows, LVGL pool low (%u bytes)",
+                        tab_picker_row_count, (unsigned)mem.free_biggest_size);
+            break;
+        }
+        lv_obj_t *row = lv_label_create(tab_picker);
+        lv_obj_set_size(row, LV_PCT(100), LV_SIZE_CONTENT);
+        lv_obj_set_style_bg_color(row, lv_color_hex(0xFFA500), 0); // Orange highlight
+        lv_obj_set_style_bg_opa(row, LV_OPA_TRANSP, 0);
+        lv_obj_set_style_text_color(row, lv_color_hex(0xFFFFFF), 0);
+        tab_picker_rows[tab_picker_row_count++] = row;
+    }
+    return tab_picker_row_count > 0;
+}
+
+void UIManager::fillTabPicker(const reaper::ReaperState &state)
+{
+    // Slide the window just far enough to keep the selection in it
+    unsigned int rows = tab_picker_row_count < tab_picker_tab_count ? tab_picker_row_count : tab_picker_tab_count;
+    if (tab_picker_selection < tab_picker_first)
+    {
+        tab_picker_first = tab_picker_selection;
+    }
+    else if (tab_picker_selection >= tab_picker_first + rows)
+    {
+        tab_picker_first = tab_picker_selection + 1 - rows;
+    }
+    if (tab_picker_first + rows > tab_picker_tab_count)
+    {
+        tab_picker_first = tab_picker_tab_count - rows; // The setlist got shorter
+    }
+
+    // Rows keep their text between moves, only changed names are laid out again
+    char text[96];
+    for (unsigned int row = 0; row < tab_picker_row_count; ++row)
+    {
+        lv_obj_t *label = tab_picker_rows[row];
+        if (row >= rows)
+        {
+            setHidden(label, true);
+            continue;
+        }
+        unsigned int index = tab_picker_first + row;
+        bool selected = index == tab_picker_selection;
+        snprintf(text, sizeof(text), "%u. %s", index + 1, state.tabs->name(index));
+        setLabelText(label, text);
+        setHidden(label, false);
+        lv_obj_set_style_bg_opa(label, selected ? LV_OPA_COVER : LV_OPA_TRANSP, 0);
+        setTextColor(label, selected ? lv_color_hex(0x000000) : lv_color_hex(0xFFFFFF));
+    }
+
+    // Scrolling to the selection needs the row positions
+    lv_obj_update_layout(tab_picker);
+    lv_obj_scroll_to_view(tab_picker_rows[tab_picker_selection - tab_picker_first], LV_ANIM_OFF);
+}
+
+bool UIManager::openTabPicker(const reaper::ReaperState &state, unsigned long current_time)
+{
+    if (!tab_picker || !state.success || !state.hasActiveTab())
+        return false;
+    if (memory_degraded)
+    {
+        LOG_WARNING("UI", "Setlist picker not opened, memory is low");
+        return false;
+    }
+    if (!createTabPickerRows())
+        return false;
+
+    // Shown first, the window is laid out and scrolled once visible
+    current_ui_state = UIState::TAB_PICKER;
+    setHidden(tab_picker, false);
+    setHidden(play_row, true);
+    setHidden(time_label, true);
+
+    tab_picker_tab_count = (unsigned int)state.tabCount();
+    tab_picker_selection = state.active_index;
+    tab_picker_first = 0;
+    fillTabPicker(state);
+    tab_picker_input_time = current_time;
+    return true;
+}
+
+void UIManager::moveTabPicker(const reaper::ReaperState &state, int steps, unsigned long current_time)
+{
+    // The setlist can change while the picker is open - wrap within the one now held
+    unsigned int count = (unsigned int)state.tabCount();
+    if (tab_picker_row_count == 0 || count == 0)
+        return;
+
+    int index = ((int)(tab_picker_selection % count) + steps) % (int)count;
+    tab_picker_tab_count = count;
+    tab_picker_selection = index < 0 ? index + count : index;
+    fillTabPicker(state);
+    tab_picker_input_time = current_time;
+}
+
 void UIManager::createButtonSection(lv_obj_t *parent)
 {
     // Button functions container